@@ -16,6 +16,8 @@
 #include <stdint.h>
 #include <time.h>
 #include "../config.h"
+#include "../zx0/pack.h"
+#include "uthash.h"
 
 #ifndef _MSC_VER
    #include <inttypes.h>
@@ -45,6 +47,7 @@ static int          option_set(int pos, int max, char *argv[], option_t *opt);
 static void         option_print(char *execname, char *ident, char *copyright, char *desc, char *longdesc, option_t *opts);
 static void         get_temporary_filename(char *filen);
 static void         cleanup_temporary_files(void);
+static unsigned char *pack_file(char *filename, uint32_t offset, long size, int method, long *packed_size);
 
 static int          num_temp_files = 0;
 static char       **temp_files = NULL;
@@ -179,35 +182,111 @@ void exit_log(int code, char *fmt, ...)
 }
 
 
+/* Symbols of a .map or .sym file, indexed by name when the file is first searched */
+
+struct symbol_entry
+{
+    char           *name;
+    long            value;
+    UT_hash_handle  hh;
+};
+
+struct symbol_file
+{
+    char           *filename;
+    time_t          mtime;
+    off_t           size;
+    struct symbol_entry *symbols;
+    UT_hash_handle  hh;
+};
+
+static struct symbol_file *symbol_files = NULL;
+
+static void symbol_file_clear(struct symbol_file *sf)
+{
+    struct symbol_entry *sym, *tmp;
+
+    HASH_ITER(hh, sf->symbols, sym, tmp)
+    {
+        HASH_DEL(sf->symbols, sym);
+        free(sym->name);
+        free(sym);
+    }
+}
+
+static void symbol_file_read(struct symbol_file *sf, FILE *fp)
+{
+    char    buffer[LINEMAX+1];
+    char    name[LINEMAX+1];
+    struct symbol_entry *sym;
+    size_t  len;
+    int     c;
+
+    while ( fgets(buffer,LINEMAX,fp) != NULL ) {
+        /* Long lines are cut, skip to the next one */
+        if ( buffer[strlen(buffer) - 1] != '\n' )
+            while ( (c = fgetc(fp)) != EOF && c != '\n' )
+                ;
+
+        if ( (len = strcspn(buffer," \t\r\n")) == 0 || buffer[len] == 0 )
+            continue;
+
+        memcpy(name,buffer,len);
+        name[len] = 0;
+
+        /* The first definition of a name wins */
+        HASH_FIND_STR(sf->symbols, name, sym);
+        if ( sym != NULL )
+            continue;
+
+        sym = must_malloc(sizeof(*sym));
+        sym->name = must_strdup(name);
+        sym->value = -1;
+        sscanf(buffer,"%*s%*s%*[ $]%lx", (long unsigned int *) &sym->value);
+        HASH_ADD_KEYPTR(hh, sf->symbols, sym->name, len, sym);
+    }
+}
+
 /* Search through debris from z80asm for some important parameters */
 long parameter_search(const char *filen,const  char *ext,const char *target)
 {
     char    name[FILENAME_MAX+1];
-    char    buffer[LINEMAX+1];
-    long    val=-1;
+    struct  stat st;
+    struct  symbol_file *sf;
+    struct  symbol_entry *sym;
     FILE    *fp;
 
     if (filen == NULL)
         return(-1);
 
     /* Create the filename very quickly */
-    strcpy(name,filen);
-    strcat(name,ext);
-    if ( (fp=fopen(name,"r"))==NULL) {
-//        sprintf(name,"Cannot open %s%s\n",filen,ext);
-//        myexit(name,1);
+    snprintf(name,sizeof(name),"%s%s",filen,ext);
+    if ( stat(name,&st) < 0 )
         return -1;
-    }
 
-     /* Successfully opened the file so search through it.. */
-    while ( fgets(buffer,LINEMAX,fp) != NULL ) {
-        if (strncmp(buffer,target,strlen(target)) == 0 && isspace(buffer[strlen(target)])) {
-            sscanf(buffer,"%*s%*s%*[ $]%lx", (long unsigned int *) &val);
-            break;
+    /* Read the file once, again only if it has been rewritten since */
+    HASH_FIND_STR(symbol_files, name, sf);
+    if ( sf == NULL || sf->mtime != st.st_mtime || sf->size != st.st_size ) {
+        if ( (fp=fopen(name,"r"))==NULL)
+            return -1;
+
+        if ( sf == NULL ) {
+            sf = must_malloc(sizeof(*sf));
+            sf->filename = must_strdup(name);
+            sf->symbols = NULL;
+            HASH_ADD_KEYPTR(hh, symbol_files, sf->filename, strlen(sf->filename), sf);
         }
+        else
+            symbol_file_clear(sf);
+
+        sf->mtime = st.st_mtime;
+        sf->size = st.st_size;
+        symbol_file_read(sf, fp);
+        fclose(fp);
     }
-    fclose(fp);
-    return(val);
+
+    HASH_FIND_STR(sf->symbols, target, sym);
+    return sym == NULL ? -1 : sym->value;
 }
 
 
@@ -332,38 +411,23 @@ FILE *fopen_bin(const char *fname,const  char *crtfile)
         if ((fdata = fopen(name, "rb")) == NULL)
             exit_log(1, "ERROR: File %s not found for a rom model compile\n", name);
 
-    } else if ( crt_model == 2 ) {
-
-        // 2: compressed zx7 rom model, complete binary is "*_CODE.bin" + zx7("*_DATA.bin")
-
-        get_temporary_filename(tname);
-        snprintf(cmdline, FILENAME_MAX*2 + 127, "z88dk-zx7 -f %s %s", name, tname);
-
-        if (system(cmdline) != 0)
-            exit_log(1, "ERROR: Unable to compress %s\n", name);
-
-        if ((fdata = fopen(tname, "rb")) == NULL)
-            exit_log(1, "ERROR: Unable to open compressed data file %s\n", tname);
+        while ((c = fgetc(fdata)) != EOF)
+            fputc(c, fin);
+        fclose(fdata);
 
-    } else if ( crt_model == 3 ) {
+    } else if ( crt_model == 2 || crt_model == 3 ) {
 
+        // 2: compressed zx7 rom model, complete binary is "*_CODE.bin" + zx7("*_DATA.bin")
         // 3: compressed zx0 rom model, complete binary is "*_CODE.bin" + zx0("*_DATA.bin")
 
-        get_temporary_filename(tname);
-        snprintf(cmdline, FILENAME_MAX*2 + 127, "z88dk-zx0 -f %s %s", name, tname);
+        unsigned char *packed;
+        long           size;
 
-        if (system(cmdline) != 0)
+        if ((packed = pack_file(name, 0, -1, crt_model == 2 ? PACK_ZX7 : PACK_ZX0, &size)) == NULL)
             exit_log(1, "ERROR: Unable to compress %s\n", name);
 
-        if ((fdata = fopen(tname, "rb")) == NULL)
-            exit_log(1, "ERROR: Unable to open compressed data file %s\n", tname);
-
-    }
-
-    if ( fdata != NULL ) {
-        while ((c = fgetc(fdata)) != EOF)
-            fputc(c, fin);
-        fclose(fdata);
+        fwrite(packed, 1, size, fin);
+        free(packed);
     }
 
     // If we have a HIMEM then append it as well
@@ -785,9 +849,10 @@ void writestring_cksum(char *mystring, FILE *fp, unsigned long *cksum)
 void raw2wav(char *wavfile)
 {
     char    rawfilename[FILENAME_MAX+1];
+    unsigned char buf[WAVE_BLOCK];
     FILE    *fpin, *fpout;
-    int      c;
-    long     i, len;
+    size_t   n;
+    long     len;
 
     strcpy(rawfilename,wavfile);
 
@@ -822,9 +887,7 @@ void raw2wav(char *wavfile)
     writestring("data",fpout);
     writelong(len,fpout);
 
-    for (i=0; i<63;i++) {
-      fputc(0x20,fpout);
-    }
+    wave_run(fpout, 0x20, 63);
 
     /*
     //writestring(wav_table,fpout);
@@ -833,10 +896,8 @@ void raw2wav(char *wavfile)
     }
     */
 
-    for (i=0; i<len;i++) {
-      c=getc(fpin);
-      fputc(c,fpout);
-    }
+    while ((n = fread(buf, 1, sizeof(buf), fpin)) > 0)
+      fwrite(buf, 1, n, fpout);
 
     fclose(fpin);
     fclose(fpout);
@@ -848,8 +909,9 @@ void raw2wav(char *wavfile)
 void raw2wav_22k(char *wavfile, int mode)
 {
     char    rawfilename[FILENAME_MAX+1];
+    unsigned char inbuf[WAVE_BLOCK*2], outbuf[WAVE_BLOCK];
     FILE    *fpin, *fpout;
-    int      c;
+    size_t   j, n;
     long     i, len;
 
     strcpy(rawfilename,wavfile);
@@ -885,9 +947,7 @@ void raw2wav_22k(char *wavfile, int mode)
     writestring("data",fpout);
     writelong(len,fpout);
 
-    for (i=0; i<63;i++) {
-      fputc(0x20,fpout);
-    }
+    wave_run(fpout, 0x20, 63);
 
     /*
     //writestring(wav_table,fpout);
@@ -896,23 +956,25 @@ void raw2wav_22k(char *wavfile, int mode)
     }
     */
 
-    for (i=0; i<len;i++) {
+    for (i=0; i<len; i+=n) {
+      n = (len-i) < WAVE_BLOCK ? (size_t)(len-i) : WAVE_BLOCK;
+      if (fread(inbuf, 2, n, fpin) != n)
+        exit_log(1,"Can't read from %s\n",rawfilename);
 
-    switch (mode)
-    {
-        case 1:
-			c=getc(fpin);
-			getc(fpin);
-            break;
-        case 2:
-			getc(fpin);
-			c=getc(fpin);
-            break;
-		default:
-			c=getc(fpin);
-			c=(c+getc(fpin))/2;
-	}
-      fputc(c,fpout);
+      for (j=0; j<n; j++) {
+        switch (mode)
+        {
+            case 1:
+                outbuf[j]=inbuf[2*j];
+                break;
+            case 2:
+                outbuf[j]=inbuf[2*j+1];
+                break;
+            default:
+                outbuf[j]=(inbuf[2*j]+inbuf[2*j+1])/2;
+        }
+      }
+      fwrite(outbuf, 1, n, fpout);
     }
 
     fclose(fpin);
@@ -921,43 +983,93 @@ void raw2wav_22k(char *wavfile, int mode)
 }
 
 
+/* Tape audio
+
+   Runs of samples are written from a block of the same level, and the
+   waveforms that repeat (a pilot tone, each possible byte) are built once
+   in memory, so a tape takes a few thousand writes instead of one call per
+   sample.
+*/
+
+/* Write count samples at level */
+void wave_run(FILE *fp, int level, int count)
+{
+    static unsigned char block[WAVE_BLOCK];
+    static int block_level = -1;
+    int n;
+
+    if (level != block_level) {
+        memset(block, level, sizeof(block));
+        block_level = level;
+    }
+
+    while (count > 0) {
+        n = (count < WAVE_BLOCK) ? count : WAVE_BLOCK;
+        fwrite(block, 1, n, fp);
+        count -= n;
+    }
+}
+
+/* Append count samples at level to a waveform in memory */
+void wave_run_b(struct wave_buf *wb, int level, int count)
+{
+    if (count <= 0)
+        return;
+
+    if (wb->len + count > wb->size) {
+        wb->size = (wb->len + count) * 2;
+        wb->data = must_realloc(wb->data, wb->size);
+    }
+
+    memset(wb->data + wb->len, level, count);
+    wb->len += count;
+}
+
+void wave_write_b(struct wave_buf *wb, FILE *fp)
+{
+    if (wb->len)
+        fwrite(wb->data, 1, wb->len, fp);
+}
+
+
 /* Pilot lenght in standard mode is about 2000 */
 void zx_pilot(int pilot_len, FILE *fpout)
 {
-  int i,j;
+  static struct wave_buf pilot;
+  static int last_len = -1;
+  int j;
 
-  /* First a short gap.. */
-  for (i=0; i < 200; i++)
-    fputc (0x80,fpout);
+  if (pilot_len != last_len) {
+    pilot.len = 0;
 
-  /* Then the beeeep */
-  for (j=0; j<pilot_len; j++) {
-    for (i=0; i < 27; i++)
-      fputc (0x20,fpout);
+    /* First a short gap.. */
+    wave_run_b(&pilot, 0x80, 200);
 
-    for (i=0; i < 27; i++)
-      fputc (0xe0,fpout);
-  }
+    /* Then the beeeep */
+    for (j=0; j<pilot_len; j++)
+      zx_rawbit_b(&pilot, 27);
 
+    /* Sync */
+    zx_rawbit_b(&pilot, 8);
 
-  /* Sync */
-  for (i=0; i < 8; i++)
-    fputc (0x20,fpout);
+    last_len = pilot_len;
+  }
 
-  for (i=0; i < 8; i++)
-    fputc (0xe0,fpout);
+  wave_write_b(&pilot, fpout);
 }
 
 
 void zx_rawbit(FILE *fpout, int period)
 {
-  int i;
+  wave_run(fpout, 0x20, period);
+  wave_run(fpout, 0xe0, period);
+}
 
-  for (i=0; i < period; i++)
-    fputc (0x20,fpout);
 
-  for (i=0; i < period; i++)
-    fputc (0xe0,fpout);
+void zx_rawbit_b(struct wave_buf *wb, int period)
+{
+  wave_run_b(wb, 0x20, period);
+  wave_run_b(wb, 0xe0, period);
 }
 
 
@@ -965,20 +1077,26 @@ void zx_rawbit(FILE *fpout, int period)
 void zx_rawout (FILE *fpout, unsigned char b, char fast)
 {
   static unsigned char c[8] = { 0x80, 0x40, 0x20, 0x10, 0x08, 0x04, 0x02, 0x01 };
+  static struct wave_buf bytes[2][256];
+  struct wave_buf *wb = &bytes[fast ? 1 : 0][b];
   int i,period;
 
-  for (i=0; i < 8; i++)
-  {
-    if (b & c[i])
-      /* Experimental MIN limit is 17 */
-      if ( fast ) period = 19; else period = 22;
-      //period = 22;
-    else
-      /* Experimental MIN limit is 7 */
-      if ( fast ) period = 9; else period = 11;
-      //period = 11;
-    zx_rawbit(fpout, period);
+  if (wb->len == 0) {
+    for (i=0; i < 8; i++)
+    {
+      if (b & c[i])
+        /* Experimental MIN limit is 17 */
+        if ( fast ) period = 19; else period = 22;
+        //period = 22;
+      else
+        /* Experimental MIN limit is 7 */
+        if ( fast ) period = 9; else period = 11;
+        //period = 11;
+      zx_rawbit_b(wb, period);
+    }
   }
+
+  wave_write_b(wb, fpout);
 }
 
 
@@ -1137,6 +1255,44 @@ static void  cleanup_temporary_files(void)
 }
 
 
+/* Compress size bytes from offset in a file, the whole file if size < 0,
+   returning the result in a malloc'ed buffer or NULL on failure */
+static unsigned char *pack_file(char *filename, uint32_t offset, long size, int method, long *packed_size)
+{
+    FILE          *fp;
+    unsigned char *data;
+    unsigned char *packed;
+
+    if ((fp = fopen(filename, "rb")) == NULL)
+        return NULL;
+
+    if (size < 0)
+        size = get_file_size(fp) - offset;
+
+    if ((size <= 0) || (fseek(fp, offset, SEEK_SET) != 0))
+    {
+        fclose(fp);
+        return NULL;
+    }
+
+    data = must_malloc(size);
+
+    if (fread(data, 1, size, fp) != (size_t)size)
+    {
+        free(data);
+        fclose(fp);
+        return NULL;
+    }
+
+    fclose(fp);
+
+    packed = pack(method, data, size, packed_size);
+    free(data);
+
+    return packed;
+}
+
+
 /* memory banks */
 
 #define MBLINEMAX 1024
@@ -1513,6 +1669,61 @@ int mb_remove_section(struct banked_memory *memory, char *section_name, int clea
     return 0;
 }
 
+int mb_compress_section(struct banked_memory *memory, char *section_spec, int clean)
+{
+    // replace a section's binary with its compressed form
+    // the section is given as "name" for zx0 or "name:method"
+    // return of 0 indicates section not found
+
+    char   section_name[MBLINEMAX];
+    char   tname[FILENAME_MAX+1];
+    char  *p;
+    int    method, secnum;
+    long   size;
+    unsigned char *packed;
+    struct memory_bank *mb;
+    struct section_bin *sb;
+    FILE  *fp;
+
+    snprintf(section_name, sizeof(section_name), "%s", section_spec);
+    method = PACK_ZX0;
+
+    if ((p = strchr(section_name, ':')) != NULL)
+    {
+        *p++ = 0;
+        if ((method = pack_method(p)) < 0)
+            exit_log(1, "Error: Unknown compression method %s\n", p);
+    }
+
+    if (mb_find_section(memory, section_name, &mb, &secnum) == 0)
+        return 0;
+
+    sb = &mb->secbin[secnum];
+
+    if ((packed = pack_file(sb->filename, sb->offset, sb->size, method, &size)) == NULL)
+        exit_log(1, "Error: Unable to compress section %s\n", section_name);
+
+    get_temporary_filename(tname);
+
+    if (((fp = fopen(tname, "wb")) == NULL) || (fwrite(packed, 1, size, fp) != (size_t)size))
+        exit_log(1, "Error: Cannot write compressed section %s\n", section_name);
+
+    fclose(fp);
+    free(packed);
+
+    printf("..compressed section %s from %d to %ld bytes (%s)\n", section_name, sb->size, size, pack_method_name(method));
+
+    if (clean) remove(sb->filename);
+
+    free(sb->filename);
+
+    sb->filename = must_strdup(tname);
+    sb->offset = 0;
+    sb->size = size;
+
+    return 1;
+}
+
 int mb_user_remove_bank(struct banked_memory *memory, char *bankname)
 {
     int i;
@@ -1663,7 +1874,8 @@ int mb_generate_output_binary(FILE *fbin, int filler, FILE *fhex, int ipad, int
     // irecsz is intel hex record size
 
     FILE *fin;
-    int   c, i, total, size;
+    unsigned char *data;
+    int   c, i, total;
 
     // iterate over all sections in memory bank
 
@@ -1671,18 +1883,11 @@ int mb_generate_output_binary(FILE *fbin, int filler, FILE *fhex, int ipad, int
 
     for (i = 0; i < mb->num; ++i)
     {
-        // open section binary file
-
-        if ((fin = fopen(mb->secbin[i].filename, "rb")) == NULL)
-        {
-            fprintf(stderr, "Error: Cannot read section binary %s\n", mb->secbin[i].filename);
-            return 1;
-        }
+        // section binary contents
 
-        if (fseek(fin, mb->secbin[i].offset, SEEK_SET) != 0)
+        if ((data = mb_section_data(&mb->secbin[i])) == NULL)
         {
-            fprintf(stderr, "Error: Cannot seek to %" PRIu32 " in file %s\n", mb->secbin[i].offset, mb->secbin[i].filename);
-            fclose(fin);
+            fprintf(stderr, "Error: Could not read %d bytes from offset %" PRIu32 " from file %s\n", mb->secbin[i].size, mb->secbin[i].offset, mb->secbin[i].filename);
             return 1;
         }
 
@@ -1703,30 +1908,23 @@ int mb_generate_output_binary(FILE *fbin, int filler, FILE *fhex, int ipad, int
 
         // add section binary to memory bank
 
-        for (size = mb->secbin[i].size; size && ((c = fgetc(fin)) != EOF); --size)
-        {
-            total++;
-            fputc(c, fbin);
-        }
-
-        if (size != 0)
-        {
-            fprintf(stderr, "Error: Could not read %d bytes from offset %" PRIu32 " from file %s\n", mb->secbin[i].size, mb->secbin[i].offset, mb->secbin[i].filename);
-            fclose(fin);
-            return 1;
-        }
+        fwrite(data, 1, mb->secbin[i].size, fbin);
+        total += mb->secbin[i].size;
 
         // generate into ihex file if padding is off
 
         if ((fhex != NULL) && !ipad)
         {
+            if ((fin = fopen(mb->secbin[i].filename, "rb")) == NULL)
+            {
+                fprintf(stderr, "Error: Cannot read section binary %s\n", mb->secbin[i].filename);
+                return 1;
+            }
+
             fseek(fin, mb->secbin[i].offset, SEEK_SET);
             bin2hex(fin, fhex, mb->secbin[i].org, mb->secbin[i].size, irecsz, 0);
+            fclose(fin);
         }
-
-        // close section binary file
-
-        fclose(fin);
     }
 
     // pad section if bankspace has size set
@@ -1860,30 +2058,72 @@ void mb_generate_output_binary_complete(char *binname, int ihex, int filler, int
     }
 }
 
-int mb_output_section_binary(FILE *fbout, struct section_bin *sb)
+/* Section binaries are read whole the first time a section refers to them */
+
+struct section_file
+{
+    char           *filename;
+    time_t          mtime;
+    off_t           size;
+    unsigned char  *data;
+    UT_hash_handle  hh;
+};
+
+static struct section_file *section_files = NULL;
+
+unsigned char *mb_section_data(struct section_bin *sb)
 {
+    struct stat st;
+    struct section_file *sf;
     FILE *fin;
-    int   c;
-    int   size;
 
-    // open section binary file
+    // returns the sb->size bytes of the section or NULL if they cannot be read
+    // the pointer is good until the file changes on disk
 
-    if ((fin = fopen(sb->filename, "rb")) == NULL)
-        return -1;
+    if (stat(sb->filename, &st) < 0)
+        return NULL;
+
+    HASH_FIND_STR(section_files, sb->filename, sf);
 
-    if (fseek(fin, sb->offset, SEEK_SET) != 0)
+    if ((sf == NULL) || (sf->mtime != st.st_mtime) || (sf->size != st.st_size))
     {
+        if ((fin = fopen(sb->filename, "rb")) == NULL)
+            return NULL;
+
+        if (sf == NULL)
+        {
+            sf = must_malloc(sizeof(*sf));
+            sf->filename = must_strdup(sb->filename);
+            sf->data = NULL;
+            HASH_ADD_KEYPTR(hh, section_files, sf->filename, strlen(sf->filename), sf);
+        }
+
+        sf->mtime = st.st_mtime;
+        sf->size = st.st_size;
+        sf->data = must_realloc(sf->data, st.st_size + 1);
+
+        if (fread(sf->data, 1, st.st_size, fin) != (size_t)st.st_size)
+            sf->size = -1;
+
         fclose(fin);
-        return -2;
     }
 
+    if ((sb->size < 0) || (sf->size < 0) || ((off_t)sb->offset + sb->size > sf->size))
+        return NULL;
+
+    return sf->data + sb->offset;
+}
+
+int mb_output_section_binary(FILE *fbout, struct section_bin *sb)
+{
+    unsigned char *data;
+
     // add section binary to output file
 
-    for (size = sb->size; size && ((c = fgetc(fin)) != EOF); --size)
-        fputc(c, fbout);
+    if ((data = mb_section_data(sb)) == NULL)
+        return -1;
 
-    fclose(fin);
-    return size;
+    return sb->size - fwrite(data, 1, sb->size, fbout);
 }
 
 void mb_delete_source_binaries(struct banked_memory *memory)
@@ -1946,6 +2186,54 @@ void mb_cleanup_memory(struct banked_memory *memory)
     memory->mainbank.secbin = NULL;
 }
 
+static void mb_copy_bank(struct memory_bank *dst, struct memory_bank *src)
+{
+    int i;
+
+    dst->num = src->num;
+    dst->secbin = NULL;
+
+    if (src->num > 0)
+    {
+        dst->secbin = must_malloc(src->num * sizeof(*dst->secbin));
+
+        for (i = 0; i < src->num; ++i)
+        {
+            dst->secbin[i] = src->secbin[i];
+            dst->secbin[i].filename = must_strdup(src->secbin[i].filename);
+            dst->secbin[i].section_name = must_strdup(src->secbin[i].section_name);
+        }
+    }
+}
+
+void mb_copy_memory(struct banked_memory *dst, struct banked_memory *src)
+{
+    int i,j;
+    // deep copy so that an output format can consume "dst" and leave "src" intact
+
+    dst->num = src->num;
+    dst->bankspace = NULL;
+
+    if (src->num > 0)
+    {
+        dst->bankspace = must_malloc(src->num * sizeof(*dst->bankspace));
+
+        for (i = 0; i < src->num; ++i)
+        {
+            struct bank_space *bs = &dst->bankspace[i];
+
+            bs->bank_id = must_strdup(src->bankspace[i].bank_id);
+            bs->org = src->bankspace[i].org;
+            bs->size = src->bankspace[i].size;
+
+            for (j = 0; j < MAXBANKS; ++j)
+                mb_copy_bank(&bs->membank[j], &src->bankspace[i].membank[j]);
+        }
+    }
+
+    mb_copy_bank(&dst->mainbank, &src->mainbank);
+}
+
 void mb_cleanup_aligned(struct aligned_data *aligned)
 {
     int  i;
@@ -654,8 +654,24 @@ extern void         writestring_b(char *mystring, uint8_t **pptr);
 extern void         raw2wav(char *rawfilename);
 extern void         raw2wav_22k(char *rawfilename, int mode);
 
+/* tape audio samples, built in memory and written in blocks */
+
+#define WAVE_BLOCK  4096
+
+struct wave_buf
+{
+    unsigned char *data;
+    size_t         len;
+    size_t         size;
+};
+
+extern void         wave_run(FILE *fp, int level, int count);
+extern void         wave_run_b(struct wave_buf *wb, int level, int count);
+extern void         wave_write_b(struct wave_buf *wb, FILE *fp);
+
 extern void         zx_pilot(int pilot_len, FILE *fpout);
 extern void         zx_rawbit(FILE *fpout, int period);
+extern void         zx_rawbit_b(struct wave_buf *wb, int period);
 extern void         zx_rawout (FILE *fpout, unsigned char b, char fast);
 
 extern long         get_file_size(FILE *fp);
@@ -730,13 +746,16 @@ extern int  mb_remove_bank(struct bank_space *bs, unsigned int index, int clean)
 extern void mb_remove_mainbank(struct memory_bank *mb, int clean);
 extern int  mb_find_section(struct banked_memory *memory, char *section_name, struct memory_bank **mb_r, int *secnum_r);
 extern int  mb_remove_section(struct banked_memory *memory, char *section_name, int clean);
+extern int  mb_compress_section(struct banked_memory *memory, char *section_spec, int clean);
 extern int  mb_user_remove_bank(struct banked_memory *memory, char *bankname);
 extern int  mb_check_alignment(struct aligned_data *aligned);
 extern int  mb_sort_banks(struct banked_memory *memory);
+extern unsigned char *mb_section_data(struct section_bin *sb);
 extern int  mb_output_section_binary(FILE *fbout, struct section_bin *sb);
 extern int  mb_generate_output_binary(FILE *fbin, int filler, FILE *fhex, int ipad, int irecsz, struct memory_bank *mb, int borg, int bsize);
 extern void mb_generate_output_binary_complete(char *binname, int ihex, int filler, int ipad, int irecsz, struct banked_memory *memory);
 extern void mb_delete_source_binaries(struct banked_memory *memory);
+extern void mb_copy_memory(struct banked_memory *dst, struct banked_memory *src);
 extern void mb_cleanup_memory(struct banked_memory *memory);
 extern void mb_cleanup_aligned(struct aligned_data *aligned);
 
@@ -19,6 +19,7 @@ static char             *crtfile = NULL;
 static char             *banked_space = NULL;
 static char             *excluded_banks = NULL;
 static char             *excluded_sections = NULL;
+static char             *compressed_sections = NULL;
 static int               romfill = 255;
 static char              ihex = 0;
 static char              ipad = 0;
@@ -36,6 +37,7 @@ option_t glue_options[] = {
     {  0 , "main-fence", "Main bin restricted below this address", OPT_INT,   &main_fence },
     {  0 , "exclude-banks", "Exclude memory banks from output",    OPT_STR,   &excluded_banks },
     {  0 , "exclude-sections", "Exclude section names from output", OPT_STR,  &excluded_sections },
+    {  0 , "compress-sections", "Compress sections, as name or name:zx0|zx7", OPT_STR, &compressed_sections },
     { 'f', "filler",    "Filler byte (default: 0xFF)",             OPT_INT,   &romfill },
     {  0,  "ihex",      "Generate an iHEX file",                   OPT_BOOL,  &ihex },
     { 'p', "pad",       "Pad iHEX file",                           OPT_BOOL,  &ipad },
@@ -137,6 +139,18 @@ int glue_exec(char *target)
         }
     }
 
+    // compress sections
+
+    if (compressed_sections != NULL)
+    {
+        printf("Compressing sections\n");
+        for (s = strtok(compressed_sections, " \t\n"); s != NULL; s = strtok(NULL, " \t\n"))
+        {
+            if (!mb_compress_section(&memory, s, clean))
+                printf("..section %s not found\n", s);
+        }
+    }
+
     // check for section alignment errors
     // but treat them like warnings
 
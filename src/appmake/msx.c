@@ -34,6 +34,9 @@ static uint8_t           l_lvl;
 static uint8_t           msx_h_lvl;
 static uint8_t           msx_l_lvl;
 
+static struct wave_buf   msx_bit_wave[2];
+static struct wave_buf   msx_byte_wave[256];
+
 static uint8_t blockid[8] = { 0x1F, 0xA6, 0xDE, 0xBA, 0xCC, 0x13, 0x7D, 0x74 };
 
 
@@ -58,9 +61,9 @@ option_t msx_options[] = {
 
 /* two fast cycles for '0', two slow cycles for '1' */
 
-void msx_bit(FILE* fpout, unsigned char bit)
+static void msx_bit(struct wave_buf *wb, unsigned char bit)
 {
-    int i, period0, period1;
+    int period0, period1;
 
     if (fast) {
         period1 = 6;
@@ -80,38 +83,49 @@ void msx_bit(FILE* fpout, unsigned char bit)
 
     if (bit) {
         /* '1' */
-        for (i = 0; i < period1; i++)
-            fputc(h_lvl, fpout);
-        for (i = 0; i < period1; i++)
-            fputc(l_lvl, fpout);
-        for (i = 0; i < period1; i++)
-            fputc(h_lvl, fpout);
-        for (i = 0; i < period1; i++)
-            fputc(l_lvl, fpout);
+        wave_run_b(wb, h_lvl, period1);
+        wave_run_b(wb, l_lvl, period1);
+        wave_run_b(wb, h_lvl, period1);
+        wave_run_b(wb, l_lvl, period1);
     } else {
         /* '0' */
-        for (i = 0; i < period0; i++)
-            fputc(h_lvl, fpout);
-        for (i = 0; i < period0; i++)
-            fputc(l_lvl, fpout);
+        wave_run_b(wb, h_lvl, period0);
+        wave_run_b(wb, l_lvl, period0);
     }
 }
 
-void msx_rawout(FILE* fpout, unsigned char b)
+/* Build the waveform of each bit and byte for the current speed and volume */
+static void msx_wave_init(void)
 {
     static unsigned char c[8] = { 0x01, 0x02, 0x04, 0x08, 0x10, 0x20, 0x40, 0x80 };
-    int i;
+    struct wave_buf *wb;
+    int i, b;
+
+    for (b = 0; b < 2; b++) {
+        msx_bit_wave[b].len = 0;
+        msx_bit(&msx_bit_wave[b], b);
+    }
+
+    for (b = 0; b < 256; b++) {
+        wb = &msx_byte_wave[b];
+        wb->len = 0;
 
-    /* Start bit */
-    msx_bit(fpout, 0);
+        /* Start bit */
+        msx_bit(wb, 0);
 
-    /* byte */
-    for (i = 0; i < 8; i++)
-        msx_bit(fpout, (b & c[i]));
+        /* byte */
+        for (i = 0; i < 8; i++)
+            msx_bit(wb, (b & c[i]));
 
-    /* Stop bits */
-    msx_bit(fpout, 1);
-    msx_bit(fpout, 1);
+        /* Stop bits */
+        msx_bit(wb, 1);
+        msx_bit(wb, 1);
+    }
+}
+
+static void msx_rawout(FILE* fpout, unsigned char b)
+{
+    wave_write_b(&msx_byte_wave[b], fpout);
 }
 
 int msx_exec(char* target)
@@ -256,11 +270,12 @@ int msx_exec(char* target)
             exit_log(1,  "Can't open output raw audio file %s\n", wavfile);
         }
 
+        msx_wave_init();
+
         /* leading silence and tone*/
-        for (i = 0; i < 0x3000; i++)
-            fputc(0x80, fpout);
+        wave_run(fpout, 0x80, 0x3000);
         for (i = 0; (i < 8000); i++)
-            msx_bit(fpout, 1);
+            wave_write_b(&msx_bit_wave[1], fpout);
 
         /* Skip the block id bytes  */
         if (fmsx) {
@@ -282,10 +297,9 @@ int msx_exec(char* target)
         }
 
         /* leading silence and tone*/
-        for (i = 0; i < 0x8000; i++)
-            fputc(0, fpout);
+        wave_run(fpout, 0, 0x8000);
         for (i = 0; (i < 2000); i++)
-            msx_bit(fpout, 1);
+            wave_write_b(&msx_bit_wave[1], fpout);
 
         /* Skip the block id bytes  */
         if (fmsx) {
@@ -24,6 +24,9 @@ static char              help         = 0;
 static uint8_t           mtx_h_lvl;
 static uint8_t           mtx_l_lvl;
 
+static struct wave_buf   mtx_byte_wave[256];
+static struct wave_buf   mtx_leader_wave;
+
 
 /* Options that are available for this module */
 option_t mtx_options[] = {
@@ -44,9 +47,9 @@ option_t mtx_options[] = {
 
 /* two fast cycles for '0', two slow cycles for '1' */
 
-void mtx_bit(FILE* fpout, unsigned char bit)
+static void mtx_bit(struct wave_buf *wb, unsigned char bit)
 {
-    int i, period0, period1;
+    int period0, period1;
 
     if (fast) {
         period1 = 5; /* Jim Willis says the speed limit is 3 */
@@ -58,43 +61,51 @@ void mtx_bit(FILE* fpout, unsigned char bit)
 
     if (bit) {
         /* '1' */
-        for (i = 0; i < period0; i++)
-            fputc(mtx_l_lvl, fpout);
-        for (i = 0; i < period0; i++)
-            fputc(mtx_h_lvl, fpout);
+        wave_run_b(wb, mtx_l_lvl, period0);
+        wave_run_b(wb, mtx_h_lvl, period0);
     } else {
         /* '0' */
-        for (i = 0; i < (period1); i++)
-            fputc(mtx_l_lvl, fpout);
-        for (i = 0; i < (period1); i++)
-            fputc(mtx_h_lvl, fpout);
+        wave_run_b(wb, mtx_l_lvl, period1);
+        wave_run_b(wb, mtx_h_lvl, period1);
     }
 }
 
-void mtx_rawout(FILE* fpout, unsigned char b)
+/* Build the waveform of the leader and of each byte for the current speed and volume */
+static void mtx_wave_init(void)
 {
     /* bit order is reversed ! */
     static unsigned char c[8] = { 0x01, 0x02, 0x04, 0x08, 0x10, 0x20, 0x40, 0x80 };
-    int i;
+    struct wave_buf *wb;
+    int i, b;
 
-    /* byte */
-    for (i = 0; i < 8; i++)
-        mtx_bit(fpout, (b & c[i]));
-}
+    for (b = 0; b < 256; b++) {
+        wb = &mtx_byte_wave[b];
+        wb->len = 0;
 
-void mtx_leader(FILE* fpout)
-{
-    int i;
+        /* byte */
+        for (i = 0; i < 8; i++)
+            mtx_bit(wb, (b & c[i]));
+    }
+
+    wb = &mtx_leader_wave;
+    wb->len = 0;
 
     /* leader tone (bit 0 repeated 1500 times) */
-    for (i = 0; (i < 9); i++) /* pre-leader short extra delay */
-        fputc(mtx_l_lvl, fpout);
+    wave_run_b(wb, mtx_l_lvl, 9); /* pre-leader short extra delay */
     for (i = 0; i < 1500; i++) /* leader tone */
-        mtx_bit(fpout, 0);
-    for (i = 0; (i < 9); i++) /* close leader (invert phase) */
-        fputc(mtx_l_lvl, fpout);
-    for (i = 0; (i < 27); i++) /* GAP to switch to data mode */
-        fputc(mtx_h_lvl, fpout);
+        mtx_bit(wb, 0);
+    wave_run_b(wb, mtx_l_lvl, 9); /* close leader (invert phase) */
+    wave_run_b(wb, mtx_h_lvl, 27); /* GAP to switch to data mode */
+}
+
+static void mtx_rawout(FILE* fpout, unsigned char b)
+{
+    wave_write_b(&mtx_byte_wave[b], fpout);
+}
+
+static void mtx_leader(FILE* fpout)
+{
+    wave_write_b(&mtx_leader_wave, fpout);
 }
 
 /*
@@ -394,9 +405,10 @@ The basic block must contain the following instructions:
             exit_log(1, "MTX file not valid for WAV conversion.\n");
         }
 
+        mtx_wave_init();
+
         /* leading silence */
-        for (i = 0; i < 0x10000; i++)
-            fputc(0x80, fpout);
+        wave_run(fpout, 0x80, 0x10000);
 
         /* HEADER */
         if (mtb) {
@@ -458,8 +470,7 @@ The basic block must contain the following instructions:
         mtx_rawout(fpout, 0);
 
         /* muted space */
-        for (i = 0; i < 0x4000; i++)
-            fputc(0x20, fpout);
+        wave_run(fpout, 0x20, 0x4000);
 
         /* System Variables block */
 
@@ -528,8 +539,7 @@ The basic block must contain the following instructions:
 
         if (len > 0) {
             /* muted space */
-            for (i = 0; i < 0x2000; i++)
-                fputc(0x20, fpout);
+            wave_run(fpout, 0x20, 0x2000);
 
             /* Extra block */
             for (i = 0; i < len; i++) {
@@ -541,8 +551,7 @@ The basic block must contain the following instructions:
         }
 
         /* trailing silence */
-        for (i = 0; i < 0x10000; i++)
-            fputc(0x20, fpout);
+        wave_run(fpout, 0x20, 0x10000);
 
         free(sys_vars);
         fclose(fpin);
@@ -46,7 +46,7 @@ int z88dk_ffs(int n)
 
 void zxn_construct_page_contents(unsigned char *mem, struct memory_bank *mb, int mbsz, int fillbyte)
 {
-    FILE *fin;
+    unsigned char *data;
     int   j;
     int   first = 0 , last = 0, gap;
 
@@ -69,16 +69,10 @@ void zxn_construct_page_contents(unsigned char *mem, struct memory_bank *mb, int
         if (((sb->org & (mbsz - 1)) + sb->size) > mbsz)
             exit_log(1, "Error: Section %s exceeds %s [%d,%d)\n", sb->section_name, (mbsz == 0x2000) ? "8k page" : "16k bank", sb->org & (mbsz - 1), (sb->org & (mbsz - 1)) + sb->size);
 
-        if ((fin = fopen(sb->filename, "rb")) == NULL)
-            exit_log(1, "Error: Can't open \"%s\"\n", sb->filename);
-
-        if (fseek(fin, sb->offset, SEEK_SET) != 0)
-            exit_log(1, "Error: Can't seek \"%s\" to %d\n", sb->filename, sb->offset);
-
-        if (fread(&mem[sb->org & (mbsz - 1)], sb->size, 1, fin) != 1)
-            exit_log(1, "Error: Can't read [%d,%d) from \"%s\"\n", sb->offset, sb->offset + sb->size);
+        if ((data = mb_section_data(sb)) == NULL)
+            exit_log(1, "Error: Can't read [%d,%d) from \"%s\"\n", sb->offset, sb->offset + sb->size, sb->filename);
 
-        fclose(fin);
+        memcpy(&mem[sb->org & (mbsz - 1)], data, sb->size);
 
         last = (sb->org & (mbsz - 1)) + sb->size;
     }
@@ -160,41 +154,50 @@ static unsigned char ts_loader[] = {
 };
 
 
-void turbo_one(FILE *fpout)
+void turbo_one_b(struct wave_buf *wb)
 {
-    int i;
+    wave_run_b(wb, 0x20, tperiod1);
+    wave_run_b(wb, 0xe0, tperiod0);
+}
+
 
-    for (i = 0; i < tperiod1; i++)
-        fputc(0x20, fpout);
-    for (i = 0; i < tperiod0; i++)
-        fputc(0xe0, fpout);
+void turbo_one(FILE *fpout)
+{
+    wave_run(fpout, 0x20, tperiod1);
+    wave_run(fpout, 0xe0, tperiod0);
 }
 
 
 void turbo_rawout(FILE *fpout, unsigned char b, char extreme)
 {
     static unsigned char c[8] = { 0x80, 0x40, 0x20, 0x10, 0x08, 0x04, 0x02, 0x01 };
+    static struct wave_buf bytes[2][256];
+    struct wave_buf *wb = &bytes[extreme ? 1 : 0][b];
     int i;
 
-    if (!b && (extreme)) {
-        /* if byte is zero then we shortcut to a single bit ! */
-        // Experimental min limit is 14
-        //zx_rawbit(fpout, tperiod2);
-        zx_rawbit(fpout, tperiod1);
-        //zx_rawbit(fpout, tperiod1);
-        turbo_one(fpout);
-    }
-    else {
-        for (i = 0; i < 8; i++)
-        {
-            if (b & c[i])
-                // Experimental min limit is 7
-                //zx_rawbit(fpout, tperiod1);
-                turbo_one(fpout);
-            else
-                zx_rawbit(fpout, tperiod0);
+    if (wb->len == 0) {
+        if (!b && (extreme)) {
+            /* if byte is zero then we shortcut to a single bit ! */
+            // Experimental min limit is 14
+            //zx_rawbit_b(wb, tperiod2);
+            zx_rawbit_b(wb, tperiod1);
+            //zx_rawbit_b(wb, tperiod1);
+            turbo_one_b(wb);
+        }
+        else {
+            for (i = 0; i < 8; i++)
+            {
+                if (b & c[i])
+                    // Experimental min limit is 7
+                    //zx_rawbit_b(wb, tperiod1);
+                    turbo_one_b(wb);
+                else
+                    zx_rawbit_b(wb, tperiod0);
+            }
         }
     }
+
+    wave_write_b(wb, fpout);
 }
 
 
@@ -623,13 +626,11 @@ int zx_tape(struct zx_common *zxc, struct zx_tape *zxt, struct banked_memory *me
                 struct memory_bank *mb = &memory->bankspace[bsnum_bank].membank[i];
                 if (mb->num > 0) {     
                     int      j;              
-                    unsigned char bank_buf[16384];
-                    FILE    *fpbank = fopen(mb->secbin->filename, "rb");
+                    unsigned char *bank_buf = mb_section_data(mb->secbin);
 
-                    if ( fpbank == NULL ) {
-                        exit_log(1,"Cannot open BANK file %s\n", mb->secbin->filename);
+                    if ( bank_buf == NULL ) {
+                        exit_log(1, "Could not read required data from <%s>\n",mb->secbin->filename);
                     }
-                    if ( mb->secbin->size != fread(bank_buf, 1,  mb->secbin->size, fpbank)) {  exit_log(1, "Could not read required data from <%s>\n",mb->secbin->filename); }
                     
                     /* Now onto the data bit */
                     writeword_p(mb->secbin->size + 2, fpout, &zxt->parity);      /* Length of next block */
@@ -640,7 +641,6 @@ int zx_tape(struct zx_common *zxc, struct zx_tape *zxt, struct banked_memory *me
                         writebyte_p(c, fpout, &zxt->parity);
                     }
                     writebyte_p(zxt->parity, fpout, &zxt->parity);
-                    fclose(fpbank);
                 }
             }
         }
@@ -676,8 +676,7 @@ int zx_tape(struct zx_common *zxc, struct zx_tape *zxt, struct banked_memory *me
             blockcount -= 4;
 
         /* leading silence */
-        for (i = 0; i < 0x500; i++)
-            fputc(0x80, fpout);
+        wave_run(fpout, 0x80, 0x500);
 
         /* Data blocks */
         while (ftell(fpin) < len) {
@@ -755,8 +754,7 @@ int zx_tape(struct zx_common *zxc, struct zx_tape *zxt, struct banked_memory *me
         }
 
         /* trailing silence */
-        for (i = 0; i < 0x500; i++)
-            fputc(0x80, fpout);
+        wave_run(fpout, 0x80, 0x500);
 
         fclose(fpin);
         fclose(fpout);
@@ -1000,7 +998,7 @@ int zxn_dotn_command(struct zx_common *zxc, struct banked_memory *memory, int fi
 
     for (i = 0; i < memory->mainbank.num; ++i)
     {
-        FILE *fin;
+        unsigned char *data;
         struct section_bin *sb = &memory->mainbank.secbin[i];
 
         if (sb->org < 0x2000)
@@ -1030,19 +1028,10 @@ int zxn_dotn_command(struct zx_common *zxc, struct banked_memory *memory, int fi
                 main_end = sb->org + sb->size - 1;
         }
 
-        if ((fin = fopen(sb->filename, "rb")) == NULL)
-            exit_log(1, "Error: Can't open file %s for reading\n", sb->filename);
-
-        if (fseek(fin, sb->offset, SEEK_SET) != 0)
-            exit_log(1, "Error: Can't seek to %" PRIu32 " in file %s\n", sb->offset, sb->filename);
-
-        if (fread(&mem[sb->org], sb->size, 1, fin) < 1)
-        {
-            fclose(fin);
+        if ((data = mb_section_data(sb)) == NULL)
             exit_log(1, "Error: Expected %d bytes from file %s\n", sb->size, sb->filename);
-        }
 
-        fclose(fin);
+        memcpy(&mem[sb->org], data, sb->size);
     }
 
     printf("Notice: Space to end of dot is %d bytes\n", 0x4000 - dot_bin_end);
@@ -1532,6 +1521,7 @@ uint8_t mem128[49152 + 16384 * 8];
 int zx_sna(struct zx_common *zxc, struct zx_sna *zxs, struct banked_memory *memory, int is_zxn)
 {
     FILE *fin, *fout;
+    unsigned char *data;
     char filename[FILENAME_MAX + 1];
     int i, j;
     int is_128 = 0;
@@ -1653,19 +1643,10 @@ int zx_sna(struct zx_common *zxc, struct zx_sna *zxs, struct banked_memory *memo
         if (sb->org < 0x4000)
             exit_log(1, "Error: Section %s has org in rom 0x%04x\n", sb->section_name, sb->org);
 
-        if ((fin = fopen(sb->filename, "rb")) == NULL)
-            exit_log(1, "Error: Can't open file %s for reading\n", sb->filename);
-
-        if (fseek(fin, sb->offset, SEEK_SET) != 0)
-            exit_log(1, "Error: Can't seek to %" PRIu32 " in file %s\n", sb->offset, sb->filename);
-
-        if (fread(&mem128[sb->org - 0x4000], sb->size, 1, fin) < 1)
-        {
-            fclose(fin);
+        if ((data = mb_section_data(sb)) == NULL)
             exit_log(1, "Error: Expected %d bytes from file %s\n", sb->size, sb->filename);
-        }
 
-        fclose(fin);
+        memcpy(&mem128[sb->org - 0x4000], data, sb->size);
     }
 
     // write other memory banks into memory image
@@ -1678,19 +1659,10 @@ int zx_sna(struct zx_common *zxc, struct zx_sna *zxs, struct banked_memory *memo
             {
                 struct section_bin *sb = &memory->bankspace[bsnum_bank].membank[i].secbin[j];
 
-                if ((fin = fopen(sb->filename, "rb")) == NULL)
-                    exit_log(1, "Error: Can't open file %s for reading\n", sb->filename);
-
-                if (fseek(fin, sb->offset, SEEK_SET) != 0)
-                    exit_log(1, "Error: Can't seek to %" PRIu32 " in file %s\n", sb->offset, sb->filename);
-
-                if (fread(&mem128[49152 + i * 16384 + sb->org - 0xc000], sb->size, 1, fin) < 1)
-                {
-                    fclose(fin);
+                if ((data = mb_section_data(sb)) == NULL)
                     exit_log(1, "Error: Expected %d bytes from file %s\n", sb->size, sb->filename);
-                }
 
-                fclose(fin);
+                memcpy(&mem128[49152 + i * 16384 + sb->org - 0xc000], data, sb->size);
             }
         }
     }
@@ -1857,6 +1829,7 @@ int zxn_nex(struct zx_common *zxc, struct zxn_nex *zxnex, struct banked_memory *
 
     FILE *fin;
     FILE *fout;
+    unsigned char *data;
 
     // find BANK space
 
@@ -1973,19 +1946,10 @@ int zxn_nex(struct zx_common *zxc, struct zxn_nex *zxnex, struct banked_memory *
             if (sb->org < 0x4000)
                 exit_log(1, "Error: Section %s has org in rom 0x%04x\n", sb->section_name, sb->org);
 
-            if ((fin = fopen(sb->filename, "rb")) == NULL)
-                exit_log(1, "Error: Can't open file %s for reading\n", sb->filename);
-
-            if (fseek(fin, sb->offset, SEEK_SET) != 0)
-                exit_log(1, "Error: Can't seek to %" PRIu32 " in file %s\n", sb->offset, sb->filename);
-
-            if (fread(&mem[sb->org - 0x4000], sb->size, 1, fin) < 1)
-            {
-                fclose(fin);
+            if ((data = mb_section_data(sb)) == NULL)
                 exit_log(1, "Error: Expected %d bytes from file %s\n", sb->size, sb->filename);
-            }
 
-            fclose(fin);
+            memcpy(&mem[sb->org - 0x4000], data, sb->size);
 
             if (sb->size > 0)
             {
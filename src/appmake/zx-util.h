@@ -11,6 +11,7 @@ struct zx_common
     char          *banked_space;
     char          *excluded_banks;
     char          *excluded_sections;
+    char          *compressed_sections;
     char           clean;
     int            main_fence;
     char           pages;
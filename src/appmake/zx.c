@@ -58,6 +58,7 @@ static struct zx_common zxc = {
     NULL,       // banked_space
     NULL,       // excluded_banks
     NULL,       // excluded_sections
+    NULL,       // compressed_sections
     0,          // clean
     -1,         // main_fence applies to banked model compiles only
     0,          // pages - zx next only
@@ -105,6 +106,7 @@ static char sna = 0;   // .sna 48k/128k snapshot
 static char dot = 0;   //  esxdos dot command
 static char bin = 0;   // .bin output binaries with banks correctly merged
 static char plus3 = 0; // Generate +3 disc
+static char *outputs = NULL;   // several of the above from one run
 
 /* Options that are available for this module */
 option_t zx_options[] = {
@@ -124,6 +126,7 @@ option_t zx_options[] = {
     { 0,  "bankspace", "Create custom bank spaces", OPT_STR,   &zxc.banked_space },
     { 0,  "exclude-banks",    "Exclude memory banks from output", OPT_STR, &zxc.excluded_banks },
     { 0,  "exclude-sections", "Exclude sections from output", OPT_STR, &zxc.excluded_sections },
+    { 0,  "compress-sections", "Compress sections, as name or name:zx0|zx7", OPT_STR, &zxc.compressed_sections },
     { 0,  "clean",    "Remove consumed source binaries\n", OPT_BOOL, &zxc.clean },
 
     { 0,  "sna",      "Make .sna instead of .tap",  OPT_BOOL,  &sna },
@@ -135,10 +138,12 @@ option_t zx_options[] = {
     { 0,  "bankspace", "Create custom bank spaces", OPT_STR,   &zxc.banked_space },
     { 0,  "exclude-banks",    "Exclude memory banks from output", OPT_STR, &zxc.excluded_banks },
     { 0,  "exclude-sections", "Exclude sections from output", OPT_STR, &zxc.excluded_sections },
+    { 0,  "compress-sections", "Compress sections, as name or name:zx0|zx7", OPT_STR, &zxc.compressed_sections },
     { 0,  "clean",    "Remove consumed source binaries\n", OPT_BOOL, &zxc.clean },
 
     { 0,  "dot",      "Make esxdos dot command instead of .tap\n", OPT_BOOL, &dot },
-    { 0,  "plus3",    "Make Spectrum +3 .dsk instead of .tap\n", OPT_BOOL, &plus3 },
+    { 0,  "plus3",    "Make Spectrum +3 .dsk instead of .tap", OPT_BOOL, &plus3 },
+    { 0,  "outputs",  "Make all of these: tap sna dot bin plus3\n", OPT_STR, &outputs },
 
     { 0,  "audio",     "Create also a WAV file",    OPT_BOOL,  &zxt.audio },
     { 0,  "ts2068",    "TS2068 BASIC relocation (if possible)",  OPT_BOOL,  &zxt.ts2068 },
@@ -158,11 +163,253 @@ option_t zx_options[] = {
     { 0 ,  NULL,       NULL,                        OPT_NONE,  NULL }
 };
 
+#define LINELEN  1024
+
 /*
-* Execution starts here
+* Output formats
+*
+* The memory model is consumed by the formats as they are written
 */
 
-#define LINELEN  1024
+static int zx_output(struct banked_memory *memory, int bsnum_bank)
+{
+    int i, j, ret;
+
+    ret = -1;
+
+    // if using 5,2,0 main bank executable model, merge these banks into the main bank
+
+    if (sna)
+    {
+        if (bsnum_bank >= 0)
+        {
+            for (i = 0; i < 8; ++i)
+            {
+                struct memory_bank *mb = &memory->bankspace[bsnum_bank].membank[i];
+
+                if (mb->num > 0)
+                {
+                    // merge banks 5,2,0 into main bank
+
+                    if ((i == 0) || (i == 2) || (i == 5))
+                    {
+                        // adjust org appropriately
+
+                        for (j = 0; j < mb->num; ++j)
+                        {
+                            if (i == 0)
+                                mb->secbin[j].org += 0xc000 - 0xc000;
+                            else if (i == 2)
+                                mb->secbin[j].org += 0x8000 - 0xc000;
+                            else
+                                mb->secbin[j].org += 0x4000 - 0xc000;
+                        }
+
+                        // move sections to main bank
+
+                        memory->mainbank.secbin = must_realloc(memory->mainbank.secbin, (memory->mainbank.num + mb->num) * sizeof(*memory->mainbank.secbin));
+                        memcpy(&memory->mainbank.secbin[memory->mainbank.num], mb->secbin, mb->num * sizeof(*memory->mainbank.secbin));
+                        memory->mainbank.num += mb->num;
+
+                        free(mb->secbin);
+
+                        mb->num = 0;
+                        mb->secbin = NULL;
+
+                        printf("Notice: Merged BANK_%d into the main memory bank\n", i);
+                    }
+                }
+            }
+
+            // sort the memory banks and look for section overlaps
+
+            if (mb_sort_banks(memory))
+                exit_log(1, "Aborting... one or more binaries overlap\n");
+        }
+    }
+
+    // check if main binary extends past fence
+
+    if (zxc.main_fence > 0)
+    {
+        struct memory_bank *mb = &memory->mainbank;
+
+        if (mb->num > 0)
+        {
+            long code_end_tail, data_end_tail, bss_end_tail;
+            struct section_bin *last = &mb->secbin[mb->num - 1];
+            int error = 0;
+
+            code_end_tail = parameter_search(zxc.crtfile, ".map", "__CODE_END_tail");
+            data_end_tail = parameter_search(zxc.crtfile, ".map", "__DATA_END_tail");
+            bss_end_tail = parameter_search(zxc.crtfile, ".map", "__BSS_END_tail");
+
+            if (code_end_tail > zxc.main_fence)
+            {
+                fprintf(stderr, "\nError: The code section has exceeded the fence by %u bytes\n(last address = 0x%04x, fence = 0x%04x)\n", (unsigned int)code_end_tail - zxc.main_fence, (unsigned int)code_end_tail - 1, zxc.main_fence);
+                error++;
+            }
+
+            if (data_end_tail > zxc.main_fence)
+            {
+                fprintf(stderr, "\nError: The data section has exceeded the fence by %u bytes\n(last address = 0x%04x, fence = 0x%04x)\n", (unsigned int)data_end_tail - zxc.main_fence, (unsigned int)data_end_tail - 1, zxc.main_fence);
+                error++;
+            }
+
+            if (bss_end_tail > zxc.main_fence)
+            {
+                fprintf(stderr, "\nError: The bss section has exceeded the fence by %u bytes\n(last address = 0x%04x, fence = 0x%04x)\n", (unsigned int)bss_end_tail - zxc.main_fence, (unsigned int)bss_end_tail - 1, zxc.main_fence);
+                error++;
+            }
+
+            if ((last->org + last->size) > zxc.main_fence)
+            {
+                fprintf(stderr, "\nWarning: Extra fragments in main bank have exceeded the fence\n");
+
+                for (i = 0; i < mb->num; ++i)
+                {
+                    struct section_bin *sb = &mb->secbin[i];
+
+                    if ((sb->org + sb->size) > zxc.main_fence)
+                        fprintf(stderr, "(section = %s, last address = 0x%04x, fence = 0x%04x)\n", sb->section_name, sb->org + sb->size - 1, zxc.main_fence);
+                }
+            }
+ 
+            if (error) exit(1);
+        }
+    }
+
+    // now the output formats
+    if (tap) {   
+        return zx_tape(&zxc, &zxt, memory);
+    }
+
+
+
+    if (plus3)
+        return zx_plus3(&zxc, &zxt, memory);
+
+    if (dot)
+    {
+        if ((ret = zx_dot_command(&zxc, memory)) != 0)
+            return ret;
+
+        // dot command is out but we need to process binaries in other memory banks
+    }
+
+    if (sna)
+    {
+        ret = zx_sna(&zxc, &zxs, memory, 0);
+
+        if (zxs.fsna != 0)
+        {
+            fclose(zxs.fsna);
+            zxs.fsna = 0;
+        }
+
+        if (ret != 0) return ret;
+
+        // sna snapshot is out but we need to process the rest of the binaries too
+        // so remove mainbank and banks 0-7 from memory model so as not to treat those again
+
+        mb_remove_mainbank(&memory->mainbank, zxc.clean);
+
+        if (bsnum_bank >= 0)
+        {
+            for (i = 0; i < 8; ++i)
+                mb_remove_bank(&memory->bankspace[bsnum_bank], i, zxc.clean);
+        }
+    }
+
+    if (bin || sna || dot)
+    {
+        mb_generate_output_binary_complete(zxc.binname, zxb.ihex, zxb.romfill, zxb.ipad, zxb.recsize, memory);
+        ret = 0;
+    }
+
+    return ret;
+}
+
+// generate each format listed in --outputs from a single load of the memory model
+// every format consumes its own copy of the model and sees the options as given
+// on the command line so the files are the same as those of separate runs
+
+static int zx_outputs(struct banked_memory *memory, int bsnum_bank)
+{
+    struct zx_common zxc_save = zxc;
+    struct zx_tape   zxt_save = zxt;
+    struct zx_sna    zxs_save = zxs;
+    struct zx_bin    zxb_save = zxb;
+    struct banked_memory copy;
+    char   outname[LINELEN];
+    char  *s, *suffix;
+    int    ret;
+
+    ret = 0;
+
+    for (s = strtok(outputs, " ,\t\n"); s != NULL; s = strtok(NULL, " ,\t\n"))
+    {
+        tap = sna = dot = bin = plus3 = 0;
+        suffix = NULL;
+
+        if (strcmp(s, "tap") == 0)
+        {
+            tap = 1;
+            suffix = ".tap";
+        }
+        else if (strcmp(s, "sna") == 0)
+        {
+            sna = 1;
+            suffix = ".sna";
+        }
+        else if (strcmp(s, "plus3") == 0)
+        {
+            plus3 = 1;
+            suffix = ".dsk";
+        }
+        else if (strcmp(s, "dot") == 0)
+            dot = 1;
+        else if (strcmp(s, "bin") == 0)
+            bin = 1;
+        else
+            exit_log(1, "Error: Unknown output format %s\n", s);
+
+        zxc = zxc_save;
+        zxt = zxt_save;
+        zxs = zxs_save;
+        zxb = zxb_save;
+
+        // source binaries are deleted once all formats are out
+
+        zxc.clean = 0;
+
+        if ((zxc.outfile != NULL) && (suffix != NULL))
+        {
+            snprintf(outname, sizeof(outname) - 4, "%s", zxc.outfile);
+            suffix_change(outname, suffix);
+            zxc.outfile = outname;
+        }
+
+        printf("Generating %s output\n", s);
+
+        mb_copy_memory(&copy, memory);
+        ret = zx_output(&copy, bsnum_bank);
+        mb_cleanup_memory(&copy);
+
+        if (ret != 0) break;
+    }
+
+    zxc = zxc_save;
+    zxt = zxt_save;
+    zxs = zxs_save;
+    zxb = zxb_save;
+
+    return ret;
+}
+
+/*
+* Execution starts here
+*/
 
 int zx_exec(char *target)
 {
@@ -191,7 +438,7 @@ int zx_exec(char *target)
 
     // generate output
 
-    tap = !dot && !sna && !bin && !plus3;
+    tap = (outputs == NULL) && !dot && !sna && !bin && !plus3;
 
     if (tap && (zxc.main_fence > 0))
         fprintf(stderr, "Warning: Main-fence is ignored for tap compiles\n");
@@ -281,6 +528,20 @@ int zx_exec(char *target)
         }
     }
 
+    // compress sections
+
+    if (zxc.compressed_sections != NULL)
+    {
+        char *s;
+
+        printf("Compressing sections\n");
+        for (s = strtok(zxc.compressed_sections, " \t\n"); s != NULL; s = strtok(NULL, " \t\n"))
+        {
+            if (!mb_compress_section(&memory, s, zxc.clean))
+                printf("..section %s not found\n", s);
+        }
+    }
+
     // check for section alignment errors
     // but treat them like warnings
 
@@ -364,155 +625,19 @@ int zx_exec(char *target)
     if (mb_sort_banks(&memory))
         exit_log(1, "Aborting... one or more binaries overlap\n");
 
-    // if using 5,2,0 main bank executable model, merge these banks into the main bank
-
-    if (sna)
-    {
-        if (bsnum_bank >= 0)
-        {
-            for (i = 0; i < 8; ++i)
-            {
-                struct memory_bank *mb = &memory.bankspace[bsnum_bank].membank[i];
-
-                if (mb->num > 0)
-                {
-                    // merge banks 5,2,0 into main bank
-
-                    if ((i == 0) || (i == 2) || (i == 5))
-                    {
-                        // adjust org appropriately
-
-                        for (j = 0; j < mb->num; ++j)
-                        {
-                            if (i == 0)
-                                mb->secbin[j].org += 0xc000 - 0xc000;
-                            else if (i == 2)
-                                mb->secbin[j].org += 0x8000 - 0xc000;
-                            else
-                                mb->secbin[j].org += 0x4000 - 0xc000;
-                        }
-
-                        // move sections to main bank
-
-                        memory.mainbank.secbin = must_realloc(memory.mainbank.secbin, (memory.mainbank.num + mb->num) * sizeof(*memory.mainbank.secbin));
-                        memcpy(&memory.mainbank.secbin[memory.mainbank.num], mb->secbin, mb->num * sizeof(*memory.mainbank.secbin));
-                        memory.mainbank.num += mb->num;
-
-                        free(mb->secbin);
-
-                        mb->num = 0;
-                        mb->secbin = NULL;
-
-                        printf("Notice: Merged BANK_%d into the main memory bank\n", i);
-                    }
-                }
-            }
-
-            // sort the memory banks and look for section overlaps
-
-            if (mb_sort_banks(&memory))
-                exit_log(1, "Aborting... one or more binaries overlap\n");
-        }
-    }
-
-    // check if main binary extends past fence
-
-    if (zxc.main_fence > 0)
-    {
-        struct memory_bank *mb = &memory.mainbank;
-
-        if (mb->num > 0)
-        {
-            long code_end_tail, data_end_tail, bss_end_tail;
-            struct section_bin *last = &mb->secbin[mb->num - 1];
-            int error = 0;
-
-            code_end_tail = parameter_search(zxc.crtfile, ".map", "__CODE_END_tail");
-            data_end_tail = parameter_search(zxc.crtfile, ".map", "__DATA_END_tail");
-            bss_end_tail = parameter_search(zxc.crtfile, ".map", "__BSS_END_tail");
-
-            if (code_end_tail > zxc.main_fence)
-            {
-                fprintf(stderr, "\nError: The code section has exceeded the fence by %u bytes\n(last address = 0x%04x, fence = 0x%04x)\n", (unsigned int)code_end_tail - zxc.main_fence, (unsigned int)code_end_tail - 1, zxc.main_fence);
-                error++;
-            }
-
-            if (data_end_tail > zxc.main_fence)
-            {
-                fprintf(stderr, "\nError: The data section has exceeded the fence by %u bytes\n(last address = 0x%04x, fence = 0x%04x)\n", (unsigned int)data_end_tail - zxc.main_fence, (unsigned int)data_end_tail - 1, zxc.main_fence);
-                error++;
-            }
-
-            if (bss_end_tail > zxc.main_fence)
-            {
-                fprintf(stderr, "\nError: The bss section has exceeded the fence by %u bytes\n(last address = 0x%04x, fence = 0x%04x)\n", (unsigned int)bss_end_tail - zxc.main_fence, (unsigned int)bss_end_tail - 1, zxc.main_fence);
-                error++;
-            }
-
-            if ((last->org + last->size) > zxc.main_fence)
-            {
-                fprintf(stderr, "\nWarning: Extra fragments in main bank have exceeded the fence\n");
-
-                for (i = 0; i < mb->num; ++i)
-                {
-                    struct section_bin *sb = &mb->secbin[i];
-
-                    if ((sb->org + sb->size) > zxc.main_fence)
-                        fprintf(stderr, "(section = %s, last address = 0x%04x, fence = 0x%04x)\n", sb->section_name, sb->org + sb->size - 1, zxc.main_fence);
-                }
-            }
- 
-            if (error) exit(1);
-        }
-    }
-
     // now the output formats
-    if (tap) {   
-        return zx_tape(&zxc, &zxt, &memory);
-    }
-
-
-
-    if (plus3)
-        return zx_plus3(&zxc, &zxt, &memory);
 
-    if (dot)
+    if (outputs == NULL)
     {
-        if ((ret = zx_dot_command(&zxc, &memory)) != 0)
-            return ret;
-
-        // dot command is out but we need to process binaries in other memory banks
-    }
+        ret = zx_output(&memory, bsnum_bank);
 
-    if (sna)
-    {
-        ret = zx_sna(&zxc, &zxs, &memory, 0);
+        // tap and +3 return without cleaning up the source binaries
 
-        if (zxs.fsna != 0)
-        {
-            fclose(zxs.fsna);
-            zxs.fsna = 0;
-        }
-
-        if (ret != 0) return ret;
-
-        // sna snapshot is out but we need to process the rest of the binaries too
-        // so remove mainbank and banks 0-7 from memory model so as not to treat those again
-
-        mb_remove_mainbank(&memory.mainbank, zxc.clean);
-
-        if (bsnum_bank >= 0)
-        {
-            for (i = 0; i < 8; ++i)
-                mb_remove_bank(&memory.bankspace[bsnum_bank], i, zxc.clean);
-        }
-    }
-
-    if (bin || sna || dot)
-    {
-        mb_generate_output_binary_complete(zxc.binname, zxb.ihex, zxb.romfill, zxb.ipad, zxb.recsize, &memory);
-        ret = 0;
+        if (tap || plus3 || (ret != 0))
+            return ret;
     }
+    else if ((ret = zx_outputs(&memory, bsnum_bank)) != 0)
+        return ret;
 
     // cleanup
 
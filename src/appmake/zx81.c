@@ -42,43 +42,43 @@ option_t zx81_options[] = {
     {  0,  NULL,       NULL,                         OPT_NONE,  NULL }
 };
 
-void zx81_rawpeak(FILE* fpout)
+static void zx81_rawpeak(struct wave_buf *wb)
 {
-    int i;
-    for (i = 0; i < 7; i++)
-        fputc(0xe0, fpout);
-    for (i = 0; i < 7; i++)
-        fputc(0x20, fpout);
+    wave_run_b(wb, 0xe0, 7);
+    wave_run_b(wb, 0x20, 7);
 }
 
 void zx81_rawout(FILE* fpout, unsigned char b)
 {
     static unsigned char c[8] = { 0x80, 0x40, 0x20, 0x10, 0x08, 0x04, 0x02, 0x01 };
+    static struct wave_buf bytes[2][256];
+    struct wave_buf *wb = &bytes[fast ? 1 : 0][b];
     int i, j, peaks;
 
-    for (i = 0; i < 8; i++) {
-        if (b & c[i])
-            if (fast)
-                peaks = 7;
+    if (wb->len == 0) {
+        for (i = 0; i < 8; i++) {
+            if (b & c[i])
+                if (fast)
+                    peaks = 7;
+                else
+                    peaks = 9;
+            else if (fast)
+                peaks = 3;
             else
-                peaks = 9;
-        else if (fast)
-            peaks = 3;
-        else
-            peaks = 4;
+                peaks = 4;
 
-        for (j = 0; j < peaks; j++)
-            zx81_rawpeak(fpout);
+            for (j = 0; j < peaks; j++)
+                zx81_rawpeak(wb);
 
-        /* bit interval at std speed: about 67 */
-        if (fast) {
-            for (j = 0; j < 20; j++)
-                fputc(0x20, fpout);
-        } else {
-            for (j = 0; j < 60; j++)
-                fputc(0x20, fpout);
+            /* bit interval at std speed: about 67 */
+            if (fast)
+                wave_run_b(wb, 0x20, 20);
+            else
+                wave_run_b(wb, 0x20, 60);
         }
     }
+
+    wave_write_b(wb, fpout);
 }
 
 int zx81_exec(char* target)
@@ -534,8 +534,7 @@ int zx81_exec(char* target)
         }
 
         /* leading silence */
-        for (i = 0; i < 0x3000; i++)
-            fputc(0x20, fpout);
+        wave_run(fpout, 0x20, 0x3000);
 
         if (!zx80) {
             /* The program on tape has to have a leading name */
@@ -572,8 +571,7 @@ int zx81_exec(char* target)
         }
 
         /* trailing silence */
-        for (i = 0; i < 0x1000; i++)
-            fputc(0x20, fpout);
+        wave_run(fpout, 0x20, 0x1000);
 
         fclose(fpin);
         fclose(fpout);
@@ -20,6 +20,7 @@ static struct zx_common zxc = {
     NULL,       // banked_space
     NULL,       // excluded_banks
     NULL,       // excluded_sections
+    NULL,       // compressed_sections
     0,          // clean
     -1,         // main_fence applies to banked model compiles only
     0,          // pages
@@ -83,6 +84,7 @@ static char dotn = 0;           //  nextos dot command
 static char zxn = 0;            // .zxn full size memory executable
 static char bin = 0;            // .bin output binaries with banks correctly merged
 static char nex = 0;            // .nex format
+static char *outputs = NULL;    // several of the above from one run
 
 /* Options that are available for this module */
 option_t zxn_options[] = {
@@ -103,6 +105,7 @@ option_t zxn_options[] = {
     {  0,  "bankspace", "Create custom bank spaces", OPT_STR,   &zxc.banked_space },
     {  0,  "exclude-banks",    "Exclude memory banks from output", OPT_STR, &zxc.excluded_banks },
     {  0,  "exclude-sections", "Exclude sections from output", OPT_STR, &zxc.excluded_sections },
+    {  0,  "compress-sections", "Compress sections, as name or name:zx0|zx7", OPT_STR, &zxc.compressed_sections },
     {  0,  "clean",    "Remove consumed source binaries\n", OPT_BOOL, &zxc.clean },
 
     {  0,  "sna",      "Make .sna instead of .tap",  OPT_BOOL,  &sna },
@@ -116,6 +119,7 @@ option_t zxn_options[] = {
     {  0,  "bankspace", "Create custom bank spaces", OPT_STR,   &zxc.banked_space },
     {  0,  "exclude-banks",    "Exclude memory banks from output", OPT_STR, &zxc.excluded_banks },
     {  0,  "exclude-sections", "Exclude sections from output", OPT_STR, &zxc.excluded_sections },
+    {  0,  "compress-sections", "Compress sections, as name or name:zx0|zx7", OPT_STR, &zxc.compressed_sections },
     {  0,  "clean",    "Remove consumed source binaries\n", OPT_BOOL, &zxc.clean },
 
     {  0,  "nex",          "Make .nex instead of .tap", OPT_BOOL,   &nex },
@@ -133,7 +137,8 @@ option_t zxn_options[] = {
     {  0,  "nex-noreset",  "Do not reset nextreg state\n", OPT_BOOL, &zxnex.noreset },
 
     {  0,  "dot",      "Make esxdos dot command instead of .tap", OPT_BOOL, &dot },
-    {  0,  "dotn",     "Make nextos dot command instead of .tap\n", OPT_BOOL, &dotn },
+    {  0,  "dotn",     "Make nextos dot command instead of .tap", OPT_BOOL, &dotn },
+    {  0,  "outputs",  "Make all of these: tap sna snx nex dot dotn bin\n", OPT_STR, &outputs },
 
     {  0,  "audio",     "Create also a WAV file",    OPT_BOOL,  &zxt.audio },
     {  0,  "ts2068",    "TS2068 BASIC relocation (if possible)",  OPT_BOOL,  &zxt.ts2068 },
@@ -153,668 +158,799 @@ option_t zxn_options[] = {
 };
 
 
+#define LINELEN  1024
+
 /*
- * Execution starts here
+* Output formats
+*
+* The memory model is consumed by the formats as they are written
 */
 
-#define LINELEN  1024
-
-int zxn_exec(char *target)
+static int zxn_output(struct banked_memory *memory, int bsnum_bank)
 {
-    struct banked_memory memory;
-    struct aligned_data aligned;
-    char   filename[LINELEN];
-    char   crtname[LINELEN];
-    FILE  *fmap;
-    char  *p;
-    int i, j, errors, ret;
-    int bsnum_bank, bsnum_div, bsnum_page;
-    char k;
+    int i, j, ret;
+    int bsnum_page;
 
     ret = -1;
 
-    if (zxc.help) return ret;
+    // if using 5,2,0 main bank executable model, merge these banks into the main bank
 
-    // filenames
+    if (sna || dotn || nex)
+    {
+        if (bsnum_bank >= 0)
+        {
+            for (i = 0; i < 8; ++i)
+            {
+                struct memory_bank *mb = &memory->bankspace[bsnum_bank].membank[i];
 
-    if (zxc.binname == NULL) return ret;
+                if (mb->num > 0)
+                {
+                    // merge banks 5,2,0 into main bank
 
-    if (zxc.crtfile == NULL)
-    {
-        snprintf(crtname, sizeof(crtname) - 4, "%s", zxc.binname);
-        suffix_change(crtname, "");
-        zxc.crtfile = crtname;
-    }
+                    if ((i == 0) || (i == 2) || (i == 5))
+                    {
+                        // adjust org appropriately
 
-    // generate output
+                        for (j = 0; j < mb->num; ++j)
+                        {
+                            if (i == 0)
+                                mb->secbin[j].org += 0xc000 - 0xc000;
+                            else if (i == 2)
+                                mb->secbin[j].org += 0x8000 - 0xc000;
+                            else
+                                mb->secbin[j].org += 0x4000 - 0xc000;
+                        }
 
-    if (zxs.snx)
-    {
-        sna = 1;
-        zxs.xsna = 1;
-    }
+                        // move sections to main bank
 
-    tap = !dot && !dotn && !sna && !zxn && !bin && !nex;
+                        memory->mainbank.secbin = must_realloc(memory->mainbank.secbin, (memory->mainbank.num + mb->num) * sizeof(*memory->mainbank.secbin));
+                        memcpy(&memory->mainbank.secbin[memory->mainbank.num], mb->secbin, mb->num * sizeof(*memory->mainbank.secbin));
+                        memory->mainbank.num += mb->num;
 
-    if (tap && (zxc.main_fence > 0))
-        fprintf(stderr, "Warning: Main-fence is ignored for tap compiles\n");
+                        free(mb->secbin);
 
+                        mb->num = 0;
+                        mb->secbin = NULL;
 
+                        printf("Notice: Merged BANK_%d into the main memory bank\n", i);
+                    }
+                }
+            }
 
-    // output formats below need banked memory model
+            // sort the memory banks and look for section overlaps
 
-    // warning about rom model compiles as this isn't solved yet
+            if (mb_sort_banks(memory))
+                exit_log(1, "Aborting... one or more binaries overlap\n");
+        }
+    }
 
-    if (parameter_search(zxc.crtfile, ".map", "__crt_model") > 0)
-        fprintf(stderr, "Warning: the DATA binary should be manually attached to CODE for rom model compiles\n");
+    // check if main binary extends past fence
 
-    // initialize banked memory representation
-    
-    // pre-defined banks:
+    if (zxc.main_fence > 0)
+    {
+        struct memory_bank *mb = &memory->mainbank;
 
-    // BANK = ZXN Ram Enumerated as 16K banks compatible with 128k Spectrum banking scheme with org 0xc000
-    // PAGE = ZXN Ram Enumerated as 8k pages compatible with ZXN MMU paging
-    // DIV  = DIVMMC Memory organized as 16 8k pages with org 0x2000
-    // RES  = Separate bankspace to hold resources stored in disk file but not initially loaded at runtime
+        if (mb->num > 0)
+        {
+            long code_end_tail, data_end_tail, bss_end_tail;
+            struct section_bin *last = &mb->secbin[mb->num - 1];
+            int error = 0;
 
-    memset(&memory, 0, sizeof(memory));
-    mb_create_bankspace(&memory, "BANK");   // bank space 0
-    mb_create_bankspace(&memory, "DIV");    // bank space 1
-    mb_create_bankspace(&memory, "PAGE");   // bank space 2 - must be last of first three because it is deleted later
-    mb_create_bankspace(&memory, "RES");
+            code_end_tail = parameter_search(zxc.crtfile, ".map", "__CODE_END_tail");
+            data_end_tail = parameter_search(zxc.crtfile, ".map", "__DATA_END_tail");
+            bss_end_tail = parameter_search(zxc.crtfile, ".map", "__BSS_END_tail");
 
-    if (zxb.fullsize)
-    {
-        memory.bankspace[0].org = 0xc000;
-        memory.bankspace[0].size = 0x4000;
+            if (code_end_tail > zxc.main_fence)
+            {
+                fprintf(stderr, "\nError: The code section has exceeded the fence by %u bytes\n(last address = 0x%04x, fence = 0x%04x)\n", (unsigned int)code_end_tail - zxc.main_fence, (unsigned int)code_end_tail - 1, zxc.main_fence);
+                error++;
+            }
 
-        memory.bankspace[1].org = 0x2000;
-        memory.bankspace[1].size = 0x2000;
-    }
+            if (data_end_tail > zxc.main_fence)
+            {
+                fprintf(stderr, "\nError: The data section has exceeded the fence by %u bytes\n(last address = 0x%04x, fence = 0x%04x)\n", (unsigned int)data_end_tail - zxc.main_fence, (unsigned int)data_end_tail - 1, zxc.main_fence);
+                error++;
+            }
 
-    if (zxc.banked_space != NULL)
-    {
-        char *s;
+            if (bss_end_tail > zxc.main_fence)
+            {
+                fprintf(stderr, "\nError: The bss section has exceeded the fence by %u bytes\n(last address = 0x%04x, fence = 0x%04x)\n", (unsigned int)bss_end_tail - zxc.main_fence, (unsigned int)bss_end_tail - 1, zxc.main_fence);
+                error++;
+            }
 
-        for (s = strtok(zxc.banked_space, " \t\n"); s != NULL; s = strtok(NULL, " \t\n"))
-        {
-            printf("Creating bank space %s\n", s);
-            mb_create_bankspace(&memory, s);
+            if ((last->org + last->size) > zxc.main_fence)
+            {
+                fprintf(stderr, "\nWarning: Extra fragments in main bank have exceeded the fence\n");
+
+                for (i = 0; i < mb->num; ++i)
+                {
+                    struct section_bin *sb = &mb->secbin[i];
+
+                    if ((sb->org + sb->size) > zxc.main_fence)
+                        fprintf(stderr, "(section = %s, last address = 0x%04x, fence = 0x%04x)\n", sb->section_name, sb->org + sb->size - 1, zxc.main_fence);
+                }
+            }
+
+            if (error) exit(1);
         }
     }
 
-    memset(&aligned, 0, sizeof(aligned));
 
-    // enumerate memory banks in map file
+    if (tap)
+        return zx_tape(&zxc, &zxt, memory);
 
-    snprintf(filename, sizeof(filename) - 4, "%s", zxc.crtfile);
-    suffix_change(filename, ".map");
+    // now the output formats
 
-    if ((fmap = fopen(filename, "r")) == NULL)
-        exit_log(1, "Error: Cannot open map file %s\n", filename);
+    if (dot)
+    {
+        if ((ret = zx_dot_command(&zxc, memory)) != 0)
+            return ret;
 
-    mb_enumerate_banks(fmap, zxc.binname, &memory, &aligned);
+        // dot command is out but we need to process binaries in other memory banks
+    }
 
-    fclose(fmap);
+    if (dotn)
+    {
+        zxc.pages = 1;
+    }
 
-    // exclude unwanted banks
+    // sna snapshot
 
-    if (zxc.excluded_banks != NULL)
+    if (sna)
     {
-        char *s;
+        if (zxs.xsna)
+        {
+            // generating an extended sna for nextos so tick off the implied options
 
-        printf("Excluding banks from output\n");
-        for (s = strtok(zxc.excluded_banks, " \t\n"); s != NULL; s = strtok(NULL, " \t\n"))
+            zxs.force_128 = 1;
+            zxc.pages = 1;
+        }
+
+        ret = zx_sna(&zxc, &zxs, memory, 1);
+
+        if ((ret != 0) || (zxs.xsna == 0))
         {
-            switch (mb_user_remove_bank(&memory, s))
+            if (zxs.fsna)
             {
-            case 1:
-                printf("..removed bank space %s\n", s);
-                break;
-            case 2:
-                printf("..removed bank %s\n", s);
-            default:
-                break;
+                fclose(zxs.fsna);
+                zxs.fsna = 0;
             }
         }
-    }
 
-    // exclude unwanted sections
+        if (ret != 0) return ret;
 
-    if (zxc.excluded_sections != NULL)
-    {
-        char *s;
+        // sna snapshot is out but we need to process the rest of the binaries too
+        // so remove mainbank and banks 0-7 from memory model so as not to treat those again
 
-        printf("Excluding sections from output\n");
-        for (s = strtok(zxc.excluded_sections, " \t\n"); s != NULL; s = strtok(NULL, " \t\n"))
+        mb_remove_mainbank(&memory->mainbank, zxc.clean);
+
+        if (bsnum_bank >= 0)
         {
-            if (mb_remove_section(&memory, s, 0))
-                printf("..removed section %s\n", s);
-            else
-                printf("..section %s not found\n", s);
+            for (i = 0; i < 8; ++i)
+                mb_remove_bank(&memory->bankspace[bsnum_bank], i, zxc.clean);
         }
     }
 
-    // check for section alignment errors
-    // but treat them like warnings
+    // nex format
 
-    mb_check_alignment(&aligned);
+    if (nex)
+    {
+        if ((ret = zxn_nex(&zxc, &zxnex, memory, zxb.romfill)) != 0)
+            return ret;
 
-    // collapse zxn's relocatable 16k banks in bank space BANK
+        // nex is out but we need to process any remaining binaries
+        // remove the mainbank; BANK space should have been emptied
 
-    errors = 0;
-    bsnum_bank = mb_find_bankspace(&memory, "BANK");
-    bsnum_div  = mb_find_bankspace(&memory, "DIV");
-    bsnum_page = mb_find_bankspace(&memory, "PAGE");
+        mb_remove_mainbank(&memory->mainbank, zxc.clean);
+        // mb_remove_bankspace(memory, "BANK");
+    }
 
-    if (bsnum_bank >= 0)
+    // if user wants memory represented in 8k segments must switch from current 16k segments
+
+    if (zxc.pages)
     {
-        for (i = 0; i < MAXBANKS; ++i)
-        {
-            struct memory_bank *mb = &memory.bankspace[bsnum_bank].membank[i];
+        // move everything from BANK space to PAGE space
+        // at this point everything in BANK space lies in [0xc000, 0xffff] 
 
-            for (j = 0; j < mb->num; ++j)
+        mb_create_bankspace(memory, "PAGE");
+        bsnum_page = mb_find_bankspace(memory, "PAGE");
+
+        if ((bsnum_page >= 0) && (bsnum_bank >= 0))
+        {
+            for (i = 0; i < MAXBANKS; ++i)
             {
-                struct section_bin *sb = &mb->secbin[j];
+                int numlive = 0;
+                struct memory_bank *mb = &memory->bankspace[bsnum_bank].membank[i];
 
-                if ((p = strstr(sb->section_name, "BANK")) != NULL)
+                for (j = 0; j < mb->num; ++j)
                 {
-                    if ((sscanf(p, "BANK_%*d_%c", &k) == 1) && (k == 'L'))
-                    {
-                        // this is an 8k bank in the lower part of the 16k BANK_nnn
+                    int pnum = MAXBANKS;
+                    struct section_bin *sb = &mb->secbin[j];
 
-                        sb->org = (sb->org & 0x1fff) + 0xc000;
+                    int org = sb->org;
+                    int size = sb->size;   // size of section in bytes
+                    uint32_t offset = sb->offset;   // offset of data in source file
 
-                        if ((sb->org + sb->size) > 0xe000)
-                        {
-                            errors++;
-                            fprintf(stderr, "Error: Section %s exceeds 8k boundary by %d bytes\n", sb->section_name, sb->org + sb->size - 0xe000);
-                        }
-                    }
-                    else if ((sscanf(p, "BANK_%*d_%c", &k) == 1) && (k == 'H'))
+                    // reassign to page space
+
+                    while (size > 0)
                     {
-                        // this is an 8k bank in the upper part of the 16k BANK_nnn
+                        int len;
+                        struct section_bin newsec;
 
-                        sb->org = (sb->org & 0x1fff) + 0xe000;
+                        // make a new section to contain this part
 
-                        if ((sb->org + sb->size) > 0x10000)
+                        memset(&newsec, 0, sizeof(newsec));
+
+                        newsec.filename = must_strdup(sb->filename);
+                        newsec.offset = offset;
+                        newsec.section_name = must_strdup(sb->section_name);
+                        newsec.org = org & 0x1fff;
+
+                        len = min(0x2000 - newsec.org, size);
+                        newsec.size = len;
+
+                        // put the section in PAGE space
+
+                        pnum = i * 2 + (org >= 0xe000);
+
+                        if (pnum < MAXBANKS)
                         {
-                            errors++;
-                            fprintf(stderr, "Error: Section %s exceeds 8k boundary by %d bytes\n", sb->section_name, sb->org + sb->size - 0x10000);
+                            struct memory_bank *dst;
+
+                            dst = &memory->bankspace[bsnum_page].membank[pnum];
+
+                            dst->num++;
+                            dst->secbin = must_realloc(dst->secbin, dst->num * sizeof(*dst->secbin));
+
+                            memcpy(&dst->secbin[dst->num - 1], &newsec, sizeof(*dst->secbin));
                         }
+
+                        // update pointers
+
+                        org += len;
+                        size -= len;
+                        offset += len;
                     }
-                    else
+
+                    // flag this section for removal from BANK bankspace
+
+                    if (pnum < MAXBANKS)
                     {
-                        // this is destined for the full 16k
+                        free(sb->filename);
+                        free(sb->section_name);
 
-                        sb->org = (sb->org & 0x3fff) + 0xc000;
+                        sb->filename = NULL;
+                        sb->section_name = NULL;
 
-                        if ((sb->org + sb->size) > 0x10000)
+                        sb->size = 0;
+                    }
+                    else
+                        numlive++;
+                }
+
+                // remove dead sections from BANK
+
+                for (j = 0; j < mb->num; ++j)
+                {
+                    if (mb->secbin[j].size == 0)
+                    {
+                        memcpy(&mb->secbin[j], &mb->secbin[j + 1], (mb->num - j - 1) * sizeof(*mb->secbin));
+
+                        if (--mb->num > 0)
+                            mb->secbin = must_realloc(mb->secbin, mb->num * sizeof(*mb->secbin));
+                        else
                         {
-                            errors++;
-                            fprintf(stderr, "Error: Section %s exceeds 16k boundary by %d bytes\n", sb->section_name, sb->org + sb->size - 0x10000);
+                            free(mb->secbin);
+                            mb->secbin = NULL;
                         }
+
+                        j--;
                     }
                 }
             }
         }
-    }
 
-    // check divmmc banks for size violations
+        //
 
-    if (bsnum_div >= 0)
-    {
-        for (i = 0; i < MAXBANKS; ++i)
+        if (zxb.fullsize)
         {
-            struct memory_bank *mb = &memory.bankspace[bsnum_div].membank[i];
-
-            for (j = 0; j < mb->num; ++j)
-            {
-                struct section_bin *sb = &mb->secbin[j];
-
-                if (sb->org < 0x2000)
-                {
-                    errors++;
-                    fprintf(stderr, "Error: Section %s has org less than 0x2000 (%#04x)\n", sb->section_name, sb->org);
-                }
-                else if ((sb->org + sb->size) > 0x4000)
-                {
-                    errors++;
-                    fprintf(stderr, "Error: Section %s exceeds 8k boundary by %d bytes\n", sb->section_name, sb->org + sb->size - 0x4000);
-                }
-            }
+            memory->bankspace[bsnum_page].org = 0x0000;
+            memory->bankspace[bsnum_page].size = 0x2000;
         }
     }
 
-    // merge PAGE space into BANK space
+    // extended nextos sna
 
-    if ((bsnum_page >= 0) && (bsnum_bank >= 0))
+    if (sna && zxs.xsna && zxs.fsna)
     {
-        for (i = 0; i < MAXBANKS; ++i)
-        {
-            struct memory_bank *mb = &memory.bankspace[bsnum_page].membank[i];
+        // append PAGE bankspace to sna
 
-            for (j = 0; j < mb->num; ++j)
+        if ((bsnum_page = mb_find_bankspace(memory, "PAGE")) >= 0)
+        {
+            for (i = 0; i < MAXBANKS; ++i)
             {
-                struct section_bin *sb = &mb->secbin[j];
+                struct memory_bank *mb = &memory->bankspace[bsnum_page].membank[i];
 
-                int bank = i / 2;         // destination 16k bank
-                int org = (sb->org & 0x1fff) + ((i & 0x01) * 0x2000);   // offset into 16k bank
-                int size = sb->size;    // size of data in bytes
-                uint32_t offset = sb->offset;  // start offset of data in source file
-                int part = 0;           // track number of fragments  
-
-                // distribute page section into 16k banks
-
-                while (size > 0)
+                if (mb->num > 0)
                 {
-                    struct section_bin newsec;
-                    int len;
-                    struct memory_bank *dst;
-
-                    // make a new section to contain this part
-
-                    memset(&newsec, 0, sizeof(newsec));
+                    unsigned char mem[8192];
 
-                    newsec.filename = must_strdup(sb->filename);
-                    newsec.offset = offset;
+                    printf("Page %d", i);
+                    zxn_construct_page_contents(mem, mb, sizeof(mem), zxb.romfill);
 
-                    // buffer = must_malloc((strlen(sb->section_name) + 6) * sizeof(*buffer));
-                    // sprintf(buffer, "%s_f%03u", sb->section_name, part);
-                    // newsec.section_name = buffer;
+                    // append to sna
 
-                    newsec.section_name = must_strdup(sb->section_name);
-                    newsec.org = (org & 0x3fff) + 0xc000;
+                    fputc(i, zxs.fsna);
+                    fwrite(mem, sizeof(mem), 1, zxs.fsna);
 
-                    len = min(0x10000 - newsec.org, size);
-                    newsec.size = len;
+                    // remove this PAGE from memory model
 
-                    // put the new section into BANK space
+                    mb_remove_bank(&memory->bankspace[bsnum_page], i, zxc.clean);
+                }
+            }
 
-                    dst = &memory.bankspace[bsnum_bank].membank[bank];
+            // remove PAGE bankspace from memory model
 
-                    dst->num++;
-                    dst->secbin = must_realloc(dst->secbin, dst->num * sizeof(*dst->secbin));
+            mb_remove_bankspace(memory, "PAGE");
+        }
+    }
 
-                    memcpy(&dst->secbin[dst->num - 1], &newsec, sizeof(*dst->secbin));
+    if (zxs.fsna)
+    {
+        fclose(zxs.fsna);
+        zxs.fsna = 0;
+    }
 
-                    // update pointers
+    // nextos dotn command
 
-                    bank++;
-                    org += len;
-                    size -= len;
-                    offset += len;
-                    part++;
-                }
-            }
-        }
+    if (dotn)
+    {
+        if ((ret = zxn_dotn_command(&zxc, memory, zxb.romfill)) != 0)
+            return ret;
 
-        // remove the PAGE bankspace from the memory model
+        // dotn is out but we need to process the rest of the binaries too
+        // so remove mainbank, PAGE, and DIV spaces since they've already been consumed
 
-        mb_remove_bankspace(&memory, "PAGE");
+        mb_remove_mainbank(&memory->mainbank, zxc.clean);
+        // mb_remove_bankspace(memory, "PAGE");
+        // mb_remove_bankspace(memory, "DIV");
     }
 
-    //
+    // output remaining memory bank contents as raw binaries
+    
+    if (bin || sna || nex || dot || dotn || tap)
+    {
+        mb_generate_output_binary_complete(zxc.binname, zxb.ihex, zxb.romfill, zxb.ipad, zxb.recsize, memory);
+        ret = 0;
+    }
 
-    if (errors)
-        exit_log(1, "Aborting... errors in one or more memory banks\n");
+    return ret;
+}
 
-    // sort the memory banks and look for section overlaps
+// generate each format listed in --outputs from a single load of the memory model
+// every format consumes its own copy of the model and sees the options as given
+// on the command line so the files are the same as those of separate runs
 
-    if (mb_sort_banks(&memory))
-        exit_log(1, "Aborting... one or more binaries overlap\n");
+static int zxn_outputs(struct banked_memory *memory, int bsnum_bank)
+{
+    struct zx_common zxc_save = zxc;
+    struct zx_tape   zxt_save = zxt;
+    struct zx_sna    zxs_save = zxs;
+    struct zx_bin    zxb_save = zxb;
+    struct zxn_nex   zxnex_save = zxnex;
+    struct banked_memory copy;
+    char   outname[LINELEN];
+    char  *s, *suffix;
+    int    ret;
+
+    ret = 0;
+
+    for (s = strtok(outputs, " ,\t\n"); s != NULL; s = strtok(NULL, " ,\t\n"))
+    {
+        zxc = zxc_save;
+        zxt = zxt_save;
+        zxs = zxs_save;
+        zxb = zxb_save;
+        zxnex = zxnex_save;
 
-    // if using 5,2,0 main bank executable model, merge these banks into the main bank
+        tap = sna = dot = dotn = zxn = bin = nex = 0;
+        suffix = NULL;
 
-    if (sna || dotn || nex)
-    {
-        if (bsnum_bank >= 0)
+        if (strcmp(s, "tap") == 0)
         {
-            for (i = 0; i < 8; ++i)
-            {
-                struct memory_bank *mb = &memory.bankspace[bsnum_bank].membank[i];
+            tap = 1;
+            suffix = ".tap";
+        }
+        else if (strcmp(s, "sna") == 0)
+        {
+            sna = 1;
+            zxs.snx = 0;
+            suffix = ".sna";
+        }
+        else if (strcmp(s, "snx") == 0)
+        {
+            sna = 1;
+            zxs.snx = 1;
+            zxs.xsna = 1;
+            suffix = ".snx";
+        }
+        else if (strcmp(s, "nex") == 0)
+            nex = 1;
+        else if (strcmp(s, "dot") == 0)
+            dot = 1;
+        else if (strcmp(s, "dotn") == 0)
+            dotn = 1;
+        else if (strcmp(s, "bin") == 0)
+            bin = 1;
+        else
+            exit_log(1, "Error: Unknown output format %s\n", s);
+
+        // source binaries are deleted once all formats are out
+
+        zxc.clean = 0;
+
+        if ((zxc.outfile != NULL) && (suffix != NULL))
+        {
+            snprintf(outname, sizeof(outname) - 4, "%s", zxc.outfile);
+            suffix_change(outname, suffix);
+            zxc.outfile = outname;
+        }
 
-                if (mb->num > 0)
-                {
-                    // merge banks 5,2,0 into main bank
+        printf("Generating %s output\n", s);
 
-                    if ((i == 0) || (i == 2) || (i == 5))
-                    {
-                        // adjust org appropriately
+        mb_copy_memory(&copy, memory);
+        ret = zxn_output(&copy, bsnum_bank);
+        mb_cleanup_memory(&copy);
 
-                        for (j = 0; j < mb->num; ++j)
-                        {
-                            if (i == 0)
-                                mb->secbin[j].org += 0xc000 - 0xc000;
-                            else if (i == 2)
-                                mb->secbin[j].org += 0x8000 - 0xc000;
-                            else
-                                mb->secbin[j].org += 0x4000 - 0xc000;
-                        }
+        if (ret != 0) break;
+    }
 
-                        // move sections to main bank
+    zxc = zxc_save;
+    zxt = zxt_save;
+    zxs = zxs_save;
+    zxb = zxb_save;
+    zxnex = zxnex_save;
 
-                        memory.mainbank.secbin = must_realloc(memory.mainbank.secbin, (memory.mainbank.num + mb->num) * sizeof(*memory.mainbank.secbin));
-                        memcpy(&memory.mainbank.secbin[memory.mainbank.num], mb->secbin, mb->num * sizeof(*memory.mainbank.secbin));
-                        memory.mainbank.num += mb->num;
+    return ret;
+}
 
-                        free(mb->secbin);
+/*
+ * Execution starts here
+*/
 
-                        mb->num = 0;
-                        mb->secbin = NULL;
+int zxn_exec(char *target)
+{
+    struct banked_memory memory;
+    struct aligned_data aligned;
+    char   filename[LINELEN];
+    char   crtname[LINELEN];
+    FILE  *fmap;
+    char  *p;
+    int i, j, errors, ret;
+    int bsnum_bank, bsnum_div, bsnum_page;
+    char k;
 
-                        printf("Notice: Merged BANK_%d into the main memory bank\n", i);
-                    }
-                }
-            }
+    ret = -1;
 
-            // sort the memory banks and look for section overlaps
+    if (zxc.help) return ret;
 
-            if (mb_sort_banks(&memory))
-                exit_log(1, "Aborting... one or more binaries overlap\n");
-        }
-    }
+    // filenames
 
-    // check if main binary extends past fence
+    if (zxc.binname == NULL) return ret;
 
-    if (zxc.main_fence > 0)
+    if (zxc.crtfile == NULL)
     {
-        struct memory_bank *mb = &memory.mainbank;
+        snprintf(crtname, sizeof(crtname) - 4, "%s", zxc.binname);
+        suffix_change(crtname, "");
+        zxc.crtfile = crtname;
+    }
 
-        if (mb->num > 0)
-        {
-            long code_end_tail, data_end_tail, bss_end_tail;
-            struct section_bin *last = &mb->secbin[mb->num - 1];
-            int error = 0;
+    // generate output
 
-            code_end_tail = parameter_search(zxc.crtfile, ".map", "__CODE_END_tail");
-            data_end_tail = parameter_search(zxc.crtfile, ".map", "__DATA_END_tail");
-            bss_end_tail = parameter_search(zxc.crtfile, ".map", "__BSS_END_tail");
+    if (zxs.snx)
+    {
+        sna = 1;
+        zxs.xsna = 1;
+    }
 
-            if (code_end_tail > zxc.main_fence)
-            {
-                fprintf(stderr, "\nError: The code section has exceeded the fence by %u bytes\n(last address = 0x%04x, fence = 0x%04x)\n", (unsigned int)code_end_tail - zxc.main_fence, (unsigned int)code_end_tail - 1, zxc.main_fence);
-                error++;
-            }
+    tap = (outputs == NULL) && !dot && !dotn && !sna && !zxn && !bin && !nex;
 
-            if (data_end_tail > zxc.main_fence)
-            {
-                fprintf(stderr, "\nError: The data section has exceeded the fence by %u bytes\n(last address = 0x%04x, fence = 0x%04x)\n", (unsigned int)data_end_tail - zxc.main_fence, (unsigned int)data_end_tail - 1, zxc.main_fence);
-                error++;
-            }
+    if (tap && (zxc.main_fence > 0))
+        fprintf(stderr, "Warning: Main-fence is ignored for tap compiles\n");
 
-            if (bss_end_tail > zxc.main_fence)
-            {
-                fprintf(stderr, "\nError: The bss section has exceeded the fence by %u bytes\n(last address = 0x%04x, fence = 0x%04x)\n", (unsigned int)bss_end_tail - zxc.main_fence, (unsigned int)bss_end_tail - 1, zxc.main_fence);
-                error++;
-            }
 
-            if ((last->org + last->size) > zxc.main_fence)
-            {
-                fprintf(stderr, "\nWarning: Extra fragments in main bank have exceeded the fence\n");
 
-                for (i = 0; i < mb->num; ++i)
-                {
-                    struct section_bin *sb = &mb->secbin[i];
+    // output formats below need banked memory model
 
-                    if ((sb->org + sb->size) > zxc.main_fence)
-                        fprintf(stderr, "(section = %s, last address = 0x%04x, fence = 0x%04x)\n", sb->section_name, sb->org + sb->size - 1, zxc.main_fence);
-                }
-            }
+    // warning about rom model compiles as this isn't solved yet
 
-            if (error) exit(1);
-        }
-    }
+    if (parameter_search(zxc.crtfile, ".map", "__crt_model") > 0)
+        fprintf(stderr, "Warning: the DATA binary should be manually attached to CODE for rom model compiles\n");
 
+    // initialize banked memory representation
+    
+    // pre-defined banks:
 
-    if (tap)
-        return zx_tape(&zxc, &zxt, &memory);
+    // BANK = ZXN Ram Enumerated as 16K banks compatible with 128k Spectrum banking scheme with org 0xc000
+    // PAGE = ZXN Ram Enumerated as 8k pages compatible with ZXN MMU paging
+    // DIV  = DIVMMC Memory organized as 16 8k pages with org 0x2000
+    // RES  = Separate bankspace to hold resources stored in disk file but not initially loaded at runtime
 
-    // now the output formats
+    memset(&memory, 0, sizeof(memory));
+    mb_create_bankspace(&memory, "BANK");   // bank space 0
+    mb_create_bankspace(&memory, "DIV");    // bank space 1
+    mb_create_bankspace(&memory, "PAGE");   // bank space 2 - must be last of first three because it is deleted later
+    mb_create_bankspace(&memory, "RES");
 
-    if (dot)
+    if (zxb.fullsize)
     {
-        if ((ret = zx_dot_command(&zxc, &memory)) != 0)
-            return ret;
+        memory.bankspace[0].org = 0xc000;
+        memory.bankspace[0].size = 0x4000;
 
-        // dot command is out but we need to process binaries in other memory banks
+        memory.bankspace[1].org = 0x2000;
+        memory.bankspace[1].size = 0x2000;
     }
 
-    if (dotn)
+    if (zxc.banked_space != NULL)
     {
-        zxc.pages = 1;
+        char *s;
+
+        for (s = strtok(zxc.banked_space, " \t\n"); s != NULL; s = strtok(NULL, " \t\n"))
+        {
+            printf("Creating bank space %s\n", s);
+            mb_create_bankspace(&memory, s);
+        }
     }
 
-    // sna snapshot
+    memset(&aligned, 0, sizeof(aligned));
 
-    if (sna)
-    {
-        if (zxs.xsna)
-        {
-            // generating an extended sna for nextos so tick off the implied options
+    // enumerate memory banks in map file
 
-            zxs.force_128 = 1;
-            zxc.pages = 1;
-        }
+    snprintf(filename, sizeof(filename) - 4, "%s", zxc.crtfile);
+    suffix_change(filename, ".map");
+
+    if ((fmap = fopen(filename, "r")) == NULL)
+        exit_log(1, "Error: Cannot open map file %s\n", filename);
 
-        ret = zx_sna(&zxc, &zxs, &memory, 1);
+    mb_enumerate_banks(fmap, zxc.binname, &memory, &aligned);
 
-        if ((ret != 0) || (zxs.xsna == 0))
+    fclose(fmap);
+
+    // exclude unwanted banks
+
+    if (zxc.excluded_banks != NULL)
+    {
+        char *s;
+
+        printf("Excluding banks from output\n");
+        for (s = strtok(zxc.excluded_banks, " \t\n"); s != NULL; s = strtok(NULL, " \t\n"))
         {
-            if (zxs.fsna)
+            switch (mb_user_remove_bank(&memory, s))
             {
-                fclose(zxs.fsna);
-                zxs.fsna = 0;
+            case 1:
+                printf("..removed bank space %s\n", s);
+                break;
+            case 2:
+                printf("..removed bank %s\n", s);
+            default:
+                break;
             }
         }
+    }
 
-        if (ret != 0) return ret;
-
-        // sna snapshot is out but we need to process the rest of the binaries too
-        // so remove mainbank and banks 0-7 from memory model so as not to treat those again
+    // exclude unwanted sections
 
-        mb_remove_mainbank(&memory.mainbank, zxc.clean);
+    if (zxc.excluded_sections != NULL)
+    {
+        char *s;
 
-        if (bsnum_bank >= 0)
+        printf("Excluding sections from output\n");
+        for (s = strtok(zxc.excluded_sections, " \t\n"); s != NULL; s = strtok(NULL, " \t\n"))
         {
-            for (i = 0; i < 8; ++i)
-                mb_remove_bank(&memory.bankspace[bsnum_bank], i, zxc.clean);
+            if (mb_remove_section(&memory, s, 0))
+                printf("..removed section %s\n", s);
+            else
+                printf("..section %s not found\n", s);
         }
     }
 
-    // nex format
+    // compress sections
 
-    if (nex)
+    if (zxc.compressed_sections != NULL)
     {
-        if ((ret = zxn_nex(&zxc, &zxnex, &memory, zxb.romfill)) != 0)
-            return ret;
-
-        // nex is out but we need to process any remaining binaries
-        // remove the mainbank; BANK space should have been emptied
+        char *s;
 
-        mb_remove_mainbank(&memory.mainbank, zxc.clean);
-        // mb_remove_bankspace(&memory, "BANK");
+        printf("Compressing sections\n");
+        for (s = strtok(zxc.compressed_sections, " \t\n"); s != NULL; s = strtok(NULL, " \t\n"))
+        {
+            if (!mb_compress_section(&memory, s, zxc.clean))
+                printf("..section %s not found\n", s);
+        }
     }
 
-    // if user wants memory represented in 8k segments must switch from current 16k segments
+    // check for section alignment errors
+    // but treat them like warnings
 
-    if (zxc.pages)
-    {
-        // move everything from BANK space to PAGE space
-        // at this point everything in BANK space lies in [0xc000, 0xffff] 
+    mb_check_alignment(&aligned);
 
-        mb_create_bankspace(&memory, "PAGE");
-        bsnum_page = mb_find_bankspace(&memory, "PAGE");
+    // collapse zxn's relocatable 16k banks in bank space BANK
 
-        if ((bsnum_page >= 0) && (bsnum_bank >= 0))
+    errors = 0;
+    bsnum_bank = mb_find_bankspace(&memory, "BANK");
+    bsnum_div  = mb_find_bankspace(&memory, "DIV");
+    bsnum_page = mb_find_bankspace(&memory, "PAGE");
+
+    if (bsnum_bank >= 0)
+    {
+        for (i = 0; i < MAXBANKS; ++i)
         {
-            for (i = 0; i < MAXBANKS; ++i)
+            struct memory_bank *mb = &memory.bankspace[bsnum_bank].membank[i];
+
+            for (j = 0; j < mb->num; ++j)
             {
-                int numlive = 0;
-                struct memory_bank *mb = &memory.bankspace[bsnum_bank].membank[i];
+                struct section_bin *sb = &mb->secbin[j];
 
-                for (j = 0; j < mb->num; ++j)
+                if ((p = strstr(sb->section_name, "BANK")) != NULL)
                 {
-                    int pnum = MAXBANKS;
-                    struct section_bin *sb = &mb->secbin[j];
-
-                    int org = sb->org;
-                    int size = sb->size;   // size of section in bytes
-                    uint32_t offset = sb->offset;   // offset of data in source file
-
-                    // reassign to page space
-
-                    while (size > 0)
+                    if ((sscanf(p, "BANK_%*d_%c", &k) == 1) && (k == 'L'))
                     {
-                        int len;
-                        struct section_bin newsec;
-
-                        // make a new section to contain this part
-
-                        memset(&newsec, 0, sizeof(newsec));
-
-                        newsec.filename = must_strdup(sb->filename);
-                        newsec.offset = offset;
-                        newsec.section_name = must_strdup(sb->section_name);
-                        newsec.org = org & 0x1fff;
-
-                        len = min(0x2000 - newsec.org, size);
-                        newsec.size = len;
-
-                        // put the section in PAGE space
+                        // this is an 8k bank in the lower part of the 16k BANK_nnn
 
-                        pnum = i * 2 + (org >= 0xe000);
+                        sb->org = (sb->org & 0x1fff) + 0xc000;
 
-                        if (pnum < MAXBANKS)
+                        if ((sb->org + sb->size) > 0xe000)
                         {
-                            struct memory_bank *dst;
-
-                            dst = &memory.bankspace[bsnum_page].membank[pnum];
-
-                            dst->num++;
-                            dst->secbin = must_realloc(dst->secbin, dst->num * sizeof(*dst->secbin));
-
-                            memcpy(&dst->secbin[dst->num - 1], &newsec, sizeof(*dst->secbin));
+                            errors++;
+                            fprintf(stderr, "Error: Section %s exceeds 8k boundary by %d bytes\n", sb->section_name, sb->org + sb->size - 0xe000);
                         }
-
-                        // update pointers
-
-                        org += len;
-                        size -= len;
-                        offset += len;
                     }
-
-                    // flag this section for removal from BANK bankspace
-
-                    if (pnum < MAXBANKS)
+                    else if ((sscanf(p, "BANK_%*d_%c", &k) == 1) && (k == 'H'))
                     {
-                        free(sb->filename);
-                        free(sb->section_name);
+                        // this is an 8k bank in the upper part of the 16k BANK_nnn
 
-                        sb->filename = NULL;
-                        sb->section_name = NULL;
+                        sb->org = (sb->org & 0x1fff) + 0xe000;
 
-                        sb->size = 0;
+                        if ((sb->org + sb->size) > 0x10000)
+                        {
+                            errors++;
+                            fprintf(stderr, "Error: Section %s exceeds 8k boundary by %d bytes\n", sb->section_name, sb->org + sb->size - 0x10000);
+                        }
                     }
                     else
-                        numlive++;
-                }
-
-                // remove dead sections from BANK
-
-                for (j = 0; j < mb->num; ++j)
-                {
-                    if (mb->secbin[j].size == 0)
                     {
-                        memcpy(&mb->secbin[j], &mb->secbin[j + 1], (mb->num - j - 1) * sizeof(*mb->secbin));
+                        // this is destined for the full 16k
 
-                        if (--mb->num > 0)
-                            mb->secbin = must_realloc(mb->secbin, mb->num * sizeof(*mb->secbin));
-                        else
+                        sb->org = (sb->org & 0x3fff) + 0xc000;
+
+                        if ((sb->org + sb->size) > 0x10000)
                         {
-                            free(mb->secbin);
-                            mb->secbin = NULL;
+                            errors++;
+                            fprintf(stderr, "Error: Section %s exceeds 16k boundary by %d bytes\n", sb->section_name, sb->org + sb->size - 0x10000);
                         }
-
-                        j--;
                     }
                 }
             }
         }
+    }
 
-        //
+    // check divmmc banks for size violations
 
-        if (zxb.fullsize)
+    if (bsnum_div >= 0)
+    {
+        for (i = 0; i < MAXBANKS; ++i)
         {
-            memory.bankspace[bsnum_page].org = 0x0000;
-            memory.bankspace[bsnum_page].size = 0x2000;
+            struct memory_bank *mb = &memory.bankspace[bsnum_div].membank[i];
+
+            for (j = 0; j < mb->num; ++j)
+            {
+                struct section_bin *sb = &mb->secbin[j];
+
+                if (sb->org < 0x2000)
+                {
+                    errors++;
+                    fprintf(stderr, "Error: Section %s has org less than 0x2000 (%#04x)\n", sb->section_name, sb->org);
+                }
+                else if ((sb->org + sb->size) > 0x4000)
+                {
+                    errors++;
+                    fprintf(stderr, "Error: Section %s exceeds 8k boundary by %d bytes\n", sb->section_name, sb->org + sb->size - 0x4000);
+                }
+            }
         }
     }
 
-    // extended nextos sna
+    // merge PAGE space into BANK space
 
-    if (sna && zxs.xsna && zxs.fsna)
+    if ((bsnum_page >= 0) && (bsnum_bank >= 0))
     {
-        // append PAGE bankspace to sna
-
-        if ((bsnum_page = mb_find_bankspace(&memory, "PAGE")) >= 0)
+        for (i = 0; i < MAXBANKS; ++i)
         {
-            for (i = 0; i < MAXBANKS; ++i)
+            struct memory_bank *mb = &memory.bankspace[bsnum_page].membank[i];
+
+            for (j = 0; j < mb->num; ++j)
             {
-                struct memory_bank *mb = &memory.bankspace[bsnum_page].membank[i];
+                struct section_bin *sb = &mb->secbin[j];
 
-                if (mb->num > 0)
+                int bank = i / 2;         // destination 16k bank
+                int org = (sb->org & 0x1fff) + ((i & 0x01) * 0x2000);   // offset into 16k bank
+                int size = sb->size;    // size of data in bytes
+                uint32_t offset = sb->offset;  // start offset of data in source file
+                int part = 0;           // track number of fragments  
+
+                // distribute page section into 16k banks
+
+                while (size > 0)
                 {
-                    unsigned char mem[8192];
+                    struct section_bin newsec;
+                    int len;
+                    struct memory_bank *dst;
 
-                    printf("Page %d", i);
-                    zxn_construct_page_contents(mem, mb, sizeof(mem), zxb.romfill);
+                    // make a new section to contain this part
 
-                    // append to sna
+                    memset(&newsec, 0, sizeof(newsec));
 
-                    fputc(i, zxs.fsna);
-                    fwrite(mem, sizeof(mem), 1, zxs.fsna);
+                    newsec.filename = must_strdup(sb->filename);
+                    newsec.offset = offset;
 
-                    // remove this PAGE from memory model
+                    // buffer = must_malloc((strlen(sb->section_name) + 6) * sizeof(*buffer));
+                    // sprintf(buffer, "%s_f%03u", sb->section_name, part);
+                    // newsec.section_name = buffer;
+
+                    newsec.section_name = must_strdup(sb->section_name);
+                    newsec.org = (org & 0x3fff) + 0xc000;
+
+                    len = min(0x10000 - newsec.org, size);
+                    newsec.size = len;
+
+                    // put the new section into BANK space
+
+                    dst = &memory.bankspace[bsnum_bank].membank[bank];
+
+                    dst->num++;
+                    dst->secbin = must_realloc(dst->secbin, dst->num * sizeof(*dst->secbin));
 
-                    mb_remove_bank(&memory.bankspace[bsnum_page], i, zxc.clean);
+                    memcpy(&dst->secbin[dst->num - 1], &newsec, sizeof(*dst->secbin));
+
+                    // update pointers
+
+                    bank++;
+                    org += len;
+                    size -= len;
+                    offset += len;
+                    part++;
                 }
             }
+        }
 
-            // remove PAGE bankspace from memory model
+        // remove the PAGE bankspace from the memory model
 
-            mb_remove_bankspace(&memory, "PAGE");
-        }
+        mb_remove_bankspace(&memory, "PAGE");
     }
 
-    if (zxs.fsna)
-    {
-        fclose(zxs.fsna);
-        zxs.fsna = 0;
-    }
+    //
 
-    // nextos dotn command
+    if (errors)
+        exit_log(1, "Aborting... errors in one or more memory banks\n");
 
-    if (dotn)
-    {
-        if ((ret = zxn_dotn_command(&zxc, &memory, zxb.romfill)) != 0)
-            return ret;
+    // sort the memory banks and look for section overlaps
 
-        // dotn is out but we need to process the rest of the binaries too
-        // so remove mainbank, PAGE, and DIV spaces since they've already been consumed
+    if (mb_sort_banks(&memory))
+        exit_log(1, "Aborting... one or more binaries overlap\n");
 
-        mb_remove_mainbank(&memory.mainbank, zxc.clean);
-        // mb_remove_bankspace(&memory, "PAGE");
-        // mb_remove_bankspace(&memory, "DIV");
-    }
+    // now the output formats
 
-    // output remaining memory bank contents as raw binaries
-    
-    if (bin || sna || nex || dot || dotn || tap)
+    if (outputs == NULL)
     {
-        mb_generate_output_binary_complete(zxc.binname, zxb.ihex, zxb.romfill, zxb.ipad, zxb.recsize, &memory);
-        ret = 0;
+        ret = zxn_output(&memory, bsnum_bank);
+
+        // tap returns without cleaning up the source binaries
+
+        if (tap || (ret != 0))
+            return ret;
     }
+    else if ((ret = zxn_outputs(&memory, bsnum_bank)) != 0)
+        return ret;
 
     // cleanup
 
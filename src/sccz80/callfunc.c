@@ -8,10 +8,6 @@
 
 #include "ccdefs.h"
 
-#ifdef WIN32
-#include <process.h>
-#endif
-
 /*
  * Local functions
  */
@@ -19,80 +15,21 @@
 static int SetWatch(char* sym, int* isscanf);
 static int SetMiniFunc(unsigned char* arg, uint32_t* format_option_ptr);
 static Kind ForceArgs(Type *dest, Type *src, int isconst);
+static int inline_call(SYMBOL *ptr, t_buffer **args, Type **argtypes, int *isconstarg, zdouble *constargval, int *isconst, zdouble *constval);
 
 
-/* msys2 tmpfile() is broken:
-   it creates the temporary file in the root directory of C:\ 
-   and therefore needs elevated privileges.
-   It returns NULL and sets errno to EACCES when run 
-   with normal privileges.
-   This causes the sccz80 compiler to generate wrong code.
-*/
-#ifdef _WIN32
-#  include <time.h>
-#  define my_tmpfile    w32_tmpfile
-#else
-#  define my_tmpfile    tmpfile
-#endif
- 
-#ifdef _WIN32
-
-static char **tmpfiles = NULL;
-static int    tmpfiles_num = 0;
-
-
-static void cleanup_tmpfiles() {
-    int  i;
-
-    for ( i = 0; i < tmpfiles_num; i++ ) {
-        unlink(tmpfiles[i]);
-        free(tmpfiles[i]);
-    }
-}
-
-static FILE* w32_tmpfile()
-{
-    static char tmpnambuf[FILENAME_MAX+1];
-    static int  inited = 0;
-    char        *tmpnam;
-    FILE        *fp;
-    
-    if (!inited) {
-        /* Randomize temporary filenames for windows */
-        snprintf(tmpnambuf, sizeof(tmpnambuf), 
-                 "sccz80%08X%04X",_getpid(), ((unsigned int)time(NULL)) & 0xffff);
-        inited = 1;
-        atexit(cleanup_tmpfiles);
-    }
-
-    if ((tmpnam = _tempnam(".\\", tmpnambuf)) == NULL) {
-        fprintf(stderr, "Failed to create temporary filename\n");
-        exit(1);
-    }
-
-    tmpfiles = REALLOC(tmpfiles, (tmpfiles_num+1) * sizeof(tmpfiles[0]));
-    tmpfiles[tmpfiles_num++] = strdup(tmpnam);
-
-    if ((fp = fopen(tmpnam, "w+")) == NULL) {
-        perror(tmpnam);
-        exit(1);
-    }
-    
-    return fp;
-}
-
-
-#endif
-   
 /*
  *      Perform a function call
  *
  * called from heirb, this routine will either call
  *      the named function, or if the supplied ptr is
  *      zero, will call the contents of HL
+ *
+ * Returns 1 if the call was expanded inline to the
+ *      constant in constval
  */
 
-void callfunction(SYMBOL *ptr, Type *fnptr_type)
+int callfunction(SYMBOL *ptr, Type *fnptr_type, zdouble *constval)
 {
     int isscanf = 0;
     uint32_t format_option = 0;
@@ -103,9 +40,10 @@ void callfunction(SYMBOL *ptr, Type *fnptr_type)
     char preserve = NO; /* Preserve af when cleaningup */
     int   isconstarg[5];
     zdouble constargval[5];
-    FILE *tmpfiles[100];  // 100 arguments enough I guess */
+    Type   *argtypes[5];
+    t_buffer *argbuffers[100];  // 100 arguments enough I guess */
     int   tmplinenos[100];
-    FILE *save_fps;
+    t_buffer **save_fps;
     int   i;
     int   save_fps_num;
     int   function_pointer_call = ptr == NULL ? YES : NO;
@@ -121,7 +59,14 @@ void callfunction(SYMBOL *ptr, Type *fnptr_type)
         functype = default_function_with_type("(funcpointer)", functype);
     }   
 
-    memset(tmpfiles, 0, sizeof(tmpfiles)); 
+    if ( ptr != NULL && ptr == currfn ) {
+        if ( currfn_static_locals ) {
+            errorfmt("Function '%s' calls itself but holds its locals in static storage, declare it __reentrant", 1, ptr->name);
+        }
+        currfn_recursive = 1;
+    }
+
+    memset(argbuffers, 0, sizeof(argbuffers)); 
     nargs = 0;
     argnumber = 0;
     watcharg = minifunc = 0;
@@ -130,7 +75,7 @@ void callfunction(SYMBOL *ptr, Type *fnptr_type)
     if (ptr && (strcmp(ptr->name, "asm") == 0 || strcmp(ptr->name,"__asm__") == 0) ) {
         /* We're calling asm("code") */
         doasmfunc(NO);
-        return;
+        return 0;
     }
 
     if (ptr ) {
@@ -145,18 +90,19 @@ void callfunction(SYMBOL *ptr, Type *fnptr_type)
             break;
         }
         argnumber++;
-        tmpfiles[argnumber] = my_tmpfile();
+        argbuffers[argnumber] = getbuffer();
         tmplinenos[argnumber] = lineno;
-        push_buffer_fp(tmpfiles[argnumber]);
+        push_buffer_fp(argbuffers[argnumber]);
 
         setstage(&before, &start);
         expr = expression(&vconst, &val, &type);
         if ( argnumber < 5 ) {
             isconstarg[argnumber] = vconst;
             constargval[argnumber] = val;
+            argtypes[argnumber] = type;
         }
         clearstage(before, start);  // Wipe out everything we did
-        fprintf(tmpfiles[argnumber],";\n");
+        bufferstr(argbuffers[argnumber], ";\n", 2);
         pop_buffer_fp();
 
         if (cmatch(',') == 0)
@@ -177,17 +123,28 @@ void callfunction(SYMBOL *ptr, Type *fnptr_type)
             errorfmt("Too few arguments to call to function '%s'", 1, functype->name);
     }
 
+    if ( ptr != NULL && ptr->inline_body != NULL && argnumber == array_len(functype->parameters) ) {
+        int isconst;
+
+        if ( inline_call(ptr, argbuffers, argtypes, isconstarg, constargval, &isconst, constval) ) {
+            for ( i = 1; i <= argnumber; i++ )
+                releasebuffer(argbuffers[i]);
+            lineno = saveline;
+            return isconst;
+        }
+    }
+
     if ( ptr != NULL ) {
         /* Check for some builtins */
         if ( strcmp(funcname, "__builtin_memset") == 0 ) {
             if ( argnumber == 3 && isconstarg[3] && constargval[3] > 0 && c_disable_builtins == 0  ) {
                 /* We want at least the size to be constant */
-                fclose(tmpfiles[3]);
-                tmpfiles[3] = NULL;
+                releasebuffer(argbuffers[3]);
+                argbuffers[3] = NULL;
                 builtin_flags = SMALLC|FASTCALL;
                 if ( isconstarg[2] ) {
-                    fclose(tmpfiles[2]);
-                    tmpfiles[2] = NULL;
+                    releasebuffer(argbuffers[2]);
+                    argbuffers[2] = NULL;
                 }
             } else {
                 funcname = "memset";
@@ -195,12 +152,12 @@ void callfunction(SYMBOL *ptr, Type *fnptr_type)
         } else if ( strcmp(funcname, "__builtin_memcpy") == 0 ) {
             if ( argnumber == 3 && isconstarg[3] && constargval[3] > 0  && c_disable_builtins == 0) {
                 /* We want at least the size to be constant */
-                fclose(tmpfiles[3]);
-                tmpfiles[3] = NULL;
+                releasebuffer(argbuffers[3]);
+                argbuffers[3] = NULL;
                 builtin_flags = SMALLC|FASTCALL;    
                 if ( isconstarg[2] ) {
-                    fclose(tmpfiles[2]);
-                    tmpfiles[2] = NULL;
+                    releasebuffer(argbuffers[2]);
+                    argbuffers[2] = NULL;
                 }
             } else {
                 funcname = "memcpy";
@@ -215,8 +172,8 @@ void callfunction(SYMBOL *ptr, Type *fnptr_type)
             if ( argnumber == 2  && c_disable_builtins == 0) {
                 builtin_flags = SMALLC|FASTCALL;
                 if ( isconstarg[2] && constargval[2] ) {
-                    fclose(tmpfiles[2]);
-                    tmpfiles[2] = NULL;
+                    releasebuffer(argbuffers[2]);
+                    argbuffers[2] = NULL;
                 }
             } else {
                 funcname = "strchr";
@@ -227,10 +184,10 @@ void callfunction(SYMBOL *ptr, Type *fnptr_type)
 
     if ( ( (ptr == NULL && c_use_r2l_calling_convention == YES ) || (ptr && (functype->flags & SMALLC) == 0) ) && (builtin_flags & SMALLC) == 0)  {
         for ( i = 1; argnumber >= i ; argnumber--, i++) {
-            FILE *tmp = tmpfiles[i];
+            t_buffer *tmp = argbuffers[i];
             int   tmpi;
-            tmpfiles[i] = tmpfiles[argnumber];
-            tmpfiles[argnumber] = tmp;
+            argbuffers[i] = argbuffers[argnumber];
+            argbuffers[argnumber] = tmp;
             tmpi = tmplinenos[i];
             tmplinenos[i] = tmplinenos[argnumber];
             tmplinenos[argnumber] = tmpi;
@@ -243,13 +200,12 @@ void callfunction(SYMBOL *ptr, Type *fnptr_type)
     save_fps = MALLOC(buffer_fps_num * sizeof(buffer_fps[0]));
     memcpy(save_fps, buffer_fps, save_fps_num * sizeof(buffer_fps[0]));
     buffer_fps_num = 0;
-    while ( tmpfiles[argnumber+1] ) {
+    while ( argbuffers[argnumber+1] ) {
         Type *type;        
         char *before, *start;
 
         argnumber++;
-        rewind(tmpfiles[argnumber]);
-        set_temporary_input(tmpfiles[argnumber]);
+        set_temporary_input(argbuffers[argnumber]);
         lineno = tmplinenos[argnumber];
         if ( function_pointer_call ) {
             if ( fnptr_type->kind == KIND_CPTR ) {
@@ -311,7 +267,7 @@ void callfunction(SYMBOL *ptr, Type *fnptr_type)
             // }
         }
         //clearstage(before,start);
-        if ( function_pointer_call == 0 && tmpfiles[argnumber+1] == NULL &&
+        if ( function_pointer_call == 0 && argbuffers[argnumber+1] == NULL &&
             ( (functype->flags & FASTCALL) == FASTCALL || (builtin_flags & FASTCALL) == FASTCALL ) ) {
             /* fastcall of single expression OR the last argument of a builtin */
         } else {
@@ -328,12 +284,12 @@ void callfunction(SYMBOL *ptr, Type *fnptr_type)
             if ( function_pointer_call == 0 ||  fnptr_type->kind == KIND_CPTR ) {
                 nargs += gen_push_function_argument(expr, type,  functype->flags & SDCCDECL && argnumber <= array_len(functype->parameters));
             } else {
-                last_argument_size = push_function_argument_fnptr(expr, type, functype, functype->flags & SDCCDECL && argnumber <= array_len(functype->parameters), tmpfiles[argnumber+1] == NULL);
+                last_argument_size = push_function_argument_fnptr(expr, type, functype, functype->flags & SDCCDECL && argnumber <= array_len(functype->parameters), argbuffers[argnumber+1] == NULL);
                 nargs += last_argument_size;
             }
         }
         restore_input();
-        fclose(tmpfiles[argnumber]);
+        releasebuffer(argbuffers[argnumber]);
     }
     memcpy(buffer_fps, save_fps, save_fps_num * sizeof(buffer_fps[0]));
     buffer_fps_num = save_fps_num ;
@@ -356,10 +312,10 @@ void callfunction(SYMBOL *ptr, Type *fnptr_type)
         } else if ( strcmp(funcname,"__builtin_strchr") == 0 && !IS_808x() ) {
             gen_builtin_strchr(isconstarg[2] ? constargval[2] : -1);
             nargs = 0;
-        } else if ( strcmp(funcname, "__builtin_memset") == 0 && !IS_808x() ) {
+        } else if ( strcmp(funcname, "__builtin_memset") == 0 ) {
             gen_builtin_memset(isconstarg[2] ? constargval[2] : -1,  constargval[3]);
             nargs = 0;
-        } else if ( strcmp(funcname, "__builtin_memcpy") == 0 && !IS_808x() ) {
+        } else if ( strcmp(funcname, "__builtin_memcpy") == 0 ) {
             gen_builtin_memcpy(isconstarg[2] ? constargval[2] : -1,  constargval[3]);
             nargs = 0;
         } else if ( functype->flags & SHORTCALL ) {
@@ -390,6 +346,7 @@ void callfunction(SYMBOL *ptr, Type *fnptr_type)
         }
         Zsp = gen_restore_frame_after_call(nargs,functype->return_type->kind != KIND_DOUBLE || c_fp_size < 6, preserve, YES);  /* clean up arguments - we know what type is MOOK */
     }
+    return 0;
 }
 
 static int SetWatch(char* sym, int* type)
@@ -569,3 +526,463 @@ static int SetMiniFunc(unsigned char* arg, uint32_t* format_option_ptr)
     *format_option_ptr = format_option;
     return (complex);
 }
+
+
+
+/*
+ *      Inline expansion of small functions
+ *
+ * A function declared inline, or any static function with
+ * --opt-code-speed=inline, whose body is a single return statement keeps
+ * the source text of the returned expression. A call is then compiled by
+ * parsing that expression in place of the call with the parameters
+ * replaced by the arguments. Constant arguments are substituted as
+ * constants so that the expansion folds. The expansion is only used when
+ * it gives the same result as the call: the body may not assign to
+ * anything and the arguments must be free of side effects.
+ */
+
+#define INLINE_MAX_TOKENS   24  /* Size budget for the body */
+#define INLINE_MAX_PARAMS   4
+#define INLINE_MAX_DEPTH    4   /* Bounds the expansion of recursive functions */
+
+enum inline_token { TOK_END, TOK_IDENT, TOK_NUMBER, TOK_LITERAL, TOK_PUNCT };
+
+static t_buffer *inline_buffer;       /* Source text of the return expression */
+static Type     *inline_functype;
+static int       inline_capturing;
+static int       inline_captured;
+static int       inline_line;
+static int       inline_depth;
+
+static const char *inline_ops[] = { "<<=", ">>=", "->", "++", "--", "<<", ">>", "<=", ">=", "==", "!=", "&&", "||",
+                                    "+=", "-=", "*=", "/=", "%=", "&=", "|=", "^=", NULL };
+
+/* Get the next token of the text at *pp, return its kind */
+static int inline_token(const char **pp, const char *end, const char **tok, int *len)
+{
+    const char *p = *pp;
+    const char **op;
+    int   kind;
+
+    while (p < end && isspace((unsigned char)*p))
+        p++;
+    *tok = p;
+    if (p >= end) {
+        kind = TOK_END;
+    } else if (isalpha((unsigned char)*p) || *p == '_') {
+        while (p < end && (isalnum((unsigned char)*p) || *p == '_'))
+            p++;
+        kind = TOK_IDENT;
+    } else if (isdigit((unsigned char)*p) || (*p == '.' && p + 1 < end && isdigit((unsigned char)p[1]))) {
+        while (p < end && (isalnum((unsigned char)*p) || *p == '.'))
+            p++;
+        kind = TOK_NUMBER;
+    } else if (*p == '"' || *p == '\'') {
+        char quote = *p++;
+        while (p < end && *p != quote) {
+            if (*p == '\\' && p + 1 < end)
+                p++;
+            p++;
+        }
+        if (p < end)
+            p++;
+        kind = TOK_LITERAL;
+    } else {
+        kind = TOK_PUNCT;
+        for (op = inline_ops; *op != NULL; op++) {
+            if (end - p >= (int)strlen(*op) && strncmp(p, *op, strlen(*op)) == 0)
+                break;
+        }
+        p += *op != NULL ? strlen(*op) : 1;
+    }
+    *len = p - *tok;
+    *pp = p;
+    return kind;
+}
+
+static int inline_is_punct(const char *tok, int len, const char *op)
+{
+    return len == (int)strlen(op) && strncmp(tok, op, len) == 0;
+}
+
+/* An operator that changes what it's applied to */
+static int inline_is_assignment(const char *tok, int len)
+{
+    if (inline_is_punct(tok, len, "++") || inline_is_punct(tok, len, "--"))
+        return 1;
+    if (tok[len - 1] != '=')
+        return 0;
+    return !(inline_is_punct(tok, len, "==") || inline_is_punct(tok, len, "!=") ||
+             inline_is_punct(tok, len, "<=") || inline_is_punct(tok, len, ">="));
+}
+
+/* A token that ends an operand, so a following & is binary */
+static int inline_ends_operand(int kind, const char *tok, int len)
+{
+    return kind == TOK_IDENT || kind == TOK_NUMBER || kind == TOK_LITERAL ||
+           inline_is_punct(tok, len, ")") || inline_is_punct(tok, len, "]");
+}
+
+/* Index of the parameter called tok, or -1 */
+static int inline_param(Type *functype, const char *tok, int len)
+{
+    int i;
+
+    for (i = 0; i < array_len(functype->parameters); i++) {
+        Type *param = array_get_byindex(functype->parameters, i);
+        if ((int)strlen(param->name) == len && strncmp(param->name, tok, len) == 0)
+            return i;
+    }
+    return -1;
+}
+
+static int inline_name(char *sname, const char *tok, int len)
+{
+    if (len >= NAMESIZE)
+        return 0;
+    memcpy(sname, tok, len);
+    sname[len] = 0;
+    return 1;
+}
+
+/* Check that the text is an expression without side effects. Returns the
+ * number of tokens, or -1. Calls of functions that are themselves expanded
+ * inline don't count as calls */
+static int inline_pure(const char *text, const char *end, int *calls)
+{
+    const char *tok, *prev = "";
+    int   len, kind, prevkind = TOK_END, prevlen = 0;
+    int   tokens = 0;
+    char  sname[NAMESIZE];
+    SYMBOL *sym;
+
+    *calls = 0;
+    while ((kind = inline_token(&text, end, &tok, &len)) != TOK_END) {
+        if (kind == TOK_PUNCT && inline_is_assignment(tok, len))
+            return -1;
+        if (kind == TOK_IDENT && inline_is_punct(tok, len, "sizeof"))
+            return -1;
+        if (inline_is_punct(tok, len, "(") && prevkind == TOK_IDENT) {
+            if (inline_name(sname, prev, prevlen) == 0 || findloc(sname) != NULL ||
+                (sym = findglb(sname)) == NULL || sym->inline_body == NULL)
+                *calls = 1;
+        }
+        prevkind = kind;
+        prev = tok;
+        prevlen = len;
+        tokens++;
+    }
+    return tokens;
+}
+
+static int inline_candidate(SYMBOL *fn, Type *functype)
+{
+    int  i;
+
+    if (decl_inline == 0 && (fn->storage != LSTATIC || (c_speed_optimisation & OPT_INLINE) == 0))
+        return 0;
+    if (functype->flags & (NAKED|CRITICAL|INTERRUPT|SAVEFRAME|SDCCDECL|SHORTCALL|BANKED|HL_CALL))
+        return 0;
+    if (functype->funcattrs.oldstyle || functype->funcattrs.hasva)
+        return 0;
+    if (array_len(functype->parameters) > INLINE_MAX_PARAMS)
+        return 0;
+    if (functype->return_type->kind != KIND_CHAR && functype->return_type->kind != KIND_INT &&
+        functype->return_type->kind != KIND_LONG && functype->return_type->kind != KIND_PTR)
+        return 0;
+    for (i = 0; i < array_len(functype->parameters); i++) {
+        Type *param = array_get_byindex(functype->parameters, i);
+        if (param->kind != KIND_CHAR && param->kind != KIND_INT && param->kind != KIND_LONG && param->kind != KIND_PTR)
+            return 0;
+    }
+    return 1;
+}
+
+void inline_function_start(SYMBOL *fn, Type *functype)
+{
+    fn->inline_body = NULL;
+    inline_capturing = inline_captured = 0;
+    inline_buffer = inline_candidate(fn, functype) ? getbuffer() : NULL;
+    inline_functype = functype;
+}
+
+/* Record the expression of a return statement, only a return that is
+ * the first statement within the function braces is of interest */
+void inline_return_start(void)
+{
+    if (inline_buffer != NULL && currfn_statements == 2 && inline_captured == 0) {
+        push_buffer_fp(inline_buffer);
+        inline_capturing = 1;
+        inline_line = lineno;
+    }
+}
+
+void inline_return_end(int complete)
+{
+    if (inline_capturing) {
+        pop_buffer_fp();
+        inline_capturing = 0;
+        /* Lines are joined without a separator, so keep to one line */
+        inline_captured = complete && lineno == inline_line;
+    }
+}
+
+void inline_function_end(SYMBOL *fn)
+{
+    const char *text, *end, *tok;
+    int   len, kind, tokens, calls;
+    int   prevkind = TOK_END, prev2kind = TOK_END;
+    const char *prev = "", *prev2 = "";
+    int   prevlen = 0, prev2len = 0;
+    int   i;
+
+    if (inline_buffer == NULL)
+        return;
+    /* Calls are expanded with the parameter names of the symbol */
+    for (i = 0; i < array_len(inline_functype->parameters); i++) {
+        Type *param = array_get_byindex(inline_functype->parameters, i);
+        if (inline_param(fn->ctype, param->name, strlen(param->name)) != i)
+            inline_captured = 0;
+    }
+    text = inline_buffer->start;
+    end = inline_buffer->next;
+    tokens = inline_pure(text, end, &calls);
+    if (inline_captured && currfn_statements == 2 && tokens > 0 && tokens <= INLINE_MAX_TOKENS) {
+        /* The address of a parameter can't be taken once expanded, and a
+         * recursive function would be unrolled */
+        while ((kind = inline_token(&text, end, &tok, &len)) != TOK_END) {
+            if (kind == TOK_IDENT && inline_is_punct(tok, len, fn->name))
+                break;
+            if (kind == TOK_IDENT && inline_param(fn->ctype, tok, len) >= 0 &&
+                inline_is_punct(prev, prevlen, "&") && !inline_ends_operand(prev2kind, prev2, prev2len))
+                break;
+            prev2kind = prevkind; prev2 = prev; prev2len = prevlen;
+            prevkind = kind; prev = tok; prevlen = len;
+        }
+        if (kind == TOK_END) {
+            len = end - inline_buffer->start;
+            fn->inline_body = MALLOC(len + 1);
+            memcpy(fn->inline_body, inline_buffer->start, len);
+            fn->inline_body[len] = 0;
+        }
+    }
+    releasebuffer(inline_buffer);
+    inline_buffer = NULL;
+}
+
+/* Write a constant argument as a literal of the parameter type, returns 0
+ * if there's no such literal */
+static int inline_constant(UT_string *out, Type *param, zdouble val)
+{
+    int64_t v = (int64_t)val;
+
+    switch (param->kind) {
+    case KIND_CHAR:
+        v = param->isunsigned ? (int64_t)(uint8_t)v : (int64_t)(int8_t)v;
+        utstring_printf(out, "(%d)", (int)v);
+        return 1;
+    case KIND_INT:
+        if (param->isunsigned) {
+            utstring_printf(out, "%uU", (unsigned int)(uint16_t)v);
+            return 1;
+        }
+        v = (int16_t)v;
+        if (v == INT16_MIN)
+            return 0;
+        utstring_printf(out, "(%d)", (int)v);
+        return 1;
+    case KIND_LONG:
+        if (param->isunsigned) {
+            if ((uint32_t)v == UINT32_MAX)
+                return 0;
+            utstring_printf(out, "%luUL", (unsigned long)(uint32_t)v);
+            return 1;
+        }
+        v = (int32_t)v;
+        if (v == INT32_MIN)
+            return 0;
+        utstring_printf(out, "(%ldL)", (long)v);
+        return 1;
+    default:
+        return 0;
+    }
+}
+
+/* Is the argument a variable that can be read more than once */
+static int inline_simple(const char *text, const char *end)
+{
+    const char *tok;
+    int   len;
+    char  sname[NAMESIZE];
+    SYMBOL *sym;
+
+    if (inline_token(&text, end, &tok, &len) != TOK_IDENT || inline_name(sname, tok, len) == 0)
+        return 0;
+    if (inline_token(&text, end, &tok, &len) != TOK_END)
+        return 0;
+    if ((sym = findloc(sname)) == NULL && (sym = findglb(sname)) == NULL)
+        return 0;
+    return sym->ident == ID_VARIABLE && sym->ctype->isvolatile == 0 &&
+           sym->ctype->kind != KIND_ARRAY && sym->ctype->kind != KIND_FUNC;
+}
+
+/* Convert a constant to the return type */
+static zdouble inline_convert(Type *type, zdouble val)
+{
+    int64_t v = (int64_t)val;
+
+    switch (type->kind) {
+    case KIND_CHAR:
+        return type->isunsigned ? (uint8_t)v : (int8_t)v;
+    case KIND_INT:
+        return type->isunsigned ? (uint16_t)v : (int16_t)v;
+    case KIND_LONG:
+        return type->isunsigned ? (uint32_t)v : (int32_t)v;
+    default:
+        return (uint16_t)v;
+    }
+}
+
+/*
+ * Expand a call to a function with an inline body. args holds the source
+ * text of the arguments, terminated by ";\n". Returns 0 if the call can't
+ * be expanded, otherwise the code for the expression has been generated.
+ */
+static int inline_call(SYMBOL *ptr, t_buffer **args, Type **argtypes, int *isconstarg, zdouble *constargval, int *isconst, zdouble *constval)
+{
+    Type       *functype = ptr->ctype;
+    int         nparams = array_len(functype->parameters);
+    const char *body = ptr->inline_body;
+    const char *body_end = body + strlen(body);
+    const char *text, *tok;
+    const char *prev = "";
+    int         prevlen = 0;
+    int         uses[INLINE_MAX_PARAMS] = {0};
+    UT_string  *subst[INLINE_MAX_PARAMS] = {NULL};
+    UT_string  *expansion = NULL;
+    char        sname[NAMESIZE];
+    int         len, kind, i, calls, argcalls;
+    int         ok = 0;
+
+    if (inline_depth >= INLINE_MAX_DEPTH)
+        return 0;
+    inline_pure(body, body_end, &calls);
+
+    /* Count the uses of the parameters, the other names must not be hidden
+     * by a local of the caller */
+    text = body;
+    while ((kind = inline_token(&text, body_end, &tok, &len)) != TOK_END) {
+        if (kind == TOK_IDENT && !inline_is_punct(prev, prevlen, ".") && !inline_is_punct(prev, prevlen, "->")) {
+            if ((i = inline_param(functype, tok, len)) >= 0) {
+                uses[i]++;
+            } else if (inline_name(sname, tok, len) == 0 || findloc(sname) != NULL) {
+                return 0;
+            }
+        }
+        prev = tok;
+        prevlen = len;
+    }
+
+    for (i = 0; i < nparams; i++) {
+        Type       *param = array_get_byindex(functype->parameters, i);
+        Type       *argtype = argtypes[i + 1];
+        const char *arg = args[i + 1]->start;
+        const char *arg_end = args[i + 1]->next - 2;       /* Strip the ";\n" */
+
+        utstring_new(subst[i]);
+        if (isconstarg[i + 1] && kind_is_integer(argtype->kind) && inline_constant(subst[i], param, constargval[i + 1]))
+            continue;
+        /* The arguments of a call are evaluated before the body */
+        if (calls)
+            goto done;
+        if (param->kind == KIND_PTR) {
+            if (argtype->kind != KIND_PTR || type_matches(param, argtype) == 0)
+                goto done;
+        } else if (argtype->kind != param->kind || argtype->isunsigned != param->isunsigned) {
+            goto done;
+        }
+        if (inline_pure(arg, arg_end, &argcalls) <= 0 || argcalls)
+            goto done;
+        if (uses[i] > 1 && inline_simple(arg, arg_end) == 0)
+            goto done;
+        utstring_printf(subst[i], "(%.*s)", (int)(arg_end - arg), arg);
+    }
+
+    /* Build the expression, it's parsed as any other argument */
+    utstring_new(expansion);
+    utstring_printf(expansion, "(");
+    prev = "";
+    prevlen = 0;
+    text = body;
+    while ((kind = inline_token(&text, body_end, &tok, &len)) != TOK_END) {
+        if (kind == TOK_IDENT && !inline_is_punct(prev, prevlen, ".") && !inline_is_punct(prev, prevlen, "->") &&
+            (i = inline_param(functype, tok, len)) >= 0) {
+            utstring_printf(expansion, "%s ", utstring_body(subst[i]));
+        } else {
+            utstring_printf(expansion, "%.*s ", len, tok);
+        }
+        prev = tok;
+        prevlen = len;
+    }
+    utstring_printf(expansion, ");\n");
+    ok = 1;
+
+    {
+        t_buffer   *buf = getbuffer();
+        t_buffer  **save_fps;
+        int         save_fps_num;
+        char       *before, *start;
+        int         vconst;
+        zdouble     val;
+        Type       *type;
+        Kind        expr;
+        Type       *return_type = functype->return_type;
+
+        bufferstr(buf, utstring_body(expansion), utstring_len(expansion));
+
+        /* Don't record the expansion into the arguments of an outer call */
+        save_fps_num = buffer_fps_num;
+        save_fps = MALLOC(buffer_fps_num * sizeof(buffer_fps[0]) + 1);
+        memcpy(save_fps, buffer_fps, save_fps_num * sizeof(buffer_fps[0]));
+        buffer_fps_num = 0;
+        inline_depth++;
+
+        set_temporary_input(buf);
+        setstage(&before, &start);
+        expr = expression(&vconst, &val, &type);
+        *isconst = vconst && (kind_is_integer(type->kind) || type->kind == KIND_PTR);
+        if (*isconst) {
+            LVALUE lval = {0};
+            clearstage(before, NULL);
+            *constval = inline_convert(return_type, val);
+            lval.val_type = return_type->kind;
+            lval.const_val = *constval;
+            load_constant(&lval);
+        } else {
+            if (expr == KIND_CARRY) {
+                gen_conv_carry2int();
+                type = type_int;
+            }
+            force(return_type->kind, type->kind, return_type->isunsigned, type->isunsigned, 0);
+            if (before == NULL)
+                clearstage(before, start);
+        }
+        restore_input();
+
+        inline_depth--;
+        memcpy(buffer_fps, save_fps, save_fps_num * sizeof(buffer_fps[0]));
+        buffer_fps_num = save_fps_num;
+        FREENULL(save_fps);
+        releasebuffer(buf);
+    }
+
+done:
+    for (i = 0; i < nparams; i++) {
+        if (subst[i] != NULL)
+            utstring_free(subst[i]);
+    }
+    if (expansion != NULL)
+        utstring_free(expansion);
+    return ok;
+}
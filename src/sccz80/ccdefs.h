@@ -47,7 +47,11 @@ typedef long double zdouble;
  *      Prototypes
  */
 
-extern void     callfunction(SYMBOL *ptr, Type *func_ptr_call_type);
+extern int      callfunction(SYMBOL *ptr, Type *func_ptr_call_type, zdouble *constval);
+extern void     inline_function_start(SYMBOL *fn, Type *functype);
+extern void     inline_function_end(SYMBOL *fn);
+extern void     inline_return_start(void);
+extern void     inline_return_end(int complete);
 
 
 /* cdbfile.c */
@@ -77,6 +81,19 @@ extern void gen_intrinsic_out(SYMBOL *sym);
 extern void gen_swap_float(Kind float_type);
 extern void gen_pop_frame(void);
 extern void gen_push_frame(void);
+extern void gen_register_variables_start(void);
+extern void gen_register_variables_disable(void);
+extern int gen_register_variable(void);
+extern void gen_load_register(SYMBOL *sym);
+extern void gen_store_register(SYMBOL *sym);
+extern void gen_register_variables_leave(Kind vartype, int newsp);
+extern void gen_register_variables_end(void);
+extern void gen_frame_pointer_start(void);
+extern void gen_frame_pointer_disable(void);
+extern int gen_frame_pointer_address(int frame_offset, int sp_offset);
+extern void gen_frame_pointer_enter(void);
+extern void gen_frame_pointer_leave(void);
+extern void gen_frame_pointer_end(void);
 extern void gen_push_float(Kind typeToPush);
 extern void gen_push_primary(LVALUE *lval);
 
@@ -100,6 +117,7 @@ extern int gen_push_function_argument(Kind expr, Type *type, int push_sdccchar);
 extern void gen_switch_preamble(Kind kind);
 extern void gen_switch_case(Kind kind, int64_t value, int label);
 extern void gen_switch_postamble(Kind kind);
+extern int gen_switch_dispatch(Kind kind, unsigned char isunsigned, SW_TAB *cases, int ncases, int deflabel);
 extern void gen_jp_label(int label, int end_of_scope);
 extern void gen_save_pointer(LVALUE *lval);
 
@@ -157,6 +175,8 @@ extern void gen_builtin_strcpy();
 extern void gen_builtin_strchr(int32_t c); 
 extern void gen_builtin_memset(int32_t c, int32_t s);
 extern void gen_builtin_memcpy(int32_t src, int32_t n);
+extern void gen_block_copy(int32_t n);
+extern void gen_block_fill(int32_t n);
 
 extern void zconvert_to_long(unsigned char tounsigned, Kind from, unsigned char fromunsigned);
 extern void zconvert_to_llong(unsigned char tounsigned, Kind from, unsigned char fromunsigned);
@@ -197,7 +217,7 @@ extern Type      *default_function_with_type(const char *name, Type *return_type
 extern Type     *asm_function(const char *name);
 extern Type      *make_pointer(Type *base_type);
 extern Type      *dodeclare(enum storage_type storage);
-extern int        declare_local(int local_static);
+extern int        declare_local(int local_static, int local_register);
 extern void       declare_func_kr();
 extern int        ispointer(Type *type);
 extern void       type_describe(Type *type, UT_string *output);
@@ -235,6 +255,11 @@ extern void     goto_cleanup(void);
 #include "io.h"
 extern void     discardbuffer(t_buffer *buf);
 
+/* ir.c */
+extern void     ir_function_start(void);
+extern void     ir_function_asm(void);
+extern void     ir_function_end(void);
+
 /* lex.c */
 extern int      streq(char str1[], char str2[]);
 extern int      astreq(char *str1, char *str2);
@@ -262,6 +287,7 @@ extern void     WriteDefined(char *sname, int value);
 
 extern int      c_notaltreg;
 extern int      c_cline_directive;
+extern int      c_function_sections;
 extern int      c_cpu;
 extern int      c_fp_mantissa_bytes;
 extern int      c_fp_exponent_bias;
@@ -291,9 +317,9 @@ extern void     addmac(void);
 extern void     delmac(void);
 extern char     putmac(char c);
 extern void     defmac(char *text);
-extern void     set_temporary_input(FILE *temp);
+extern void     set_temporary_input(t_buffer *temp);
 extern void     restore_input(void);
-extern void     push_buffer_fp(FILE *fp);
+extern void     push_buffer_fp(t_buffer *buf);
 extern void     pop_buffer_fp(void);
 
 /* primary.c */
@@ -322,6 +348,13 @@ extern int      check_lastop_was_testjump(LVALUE *lval);
 extern int      check_range(LVALUE *lval, int32_t min_value, int32_t max_value) ;
 extern void     check_assign_range(Type *type, double const_value);
 
+/* profile.c */
+extern void     profile_read(const char *filename);
+extern void     profile_function_start(SYMBOL *fn);
+extern void     profile_function_end(void);
+extern int      profile_cold_block(int line, int first, int last);
+extern void     profile_defer(t_buffer *buf);
+
 /* stmt.c */
 extern int      statement(void);
 extern void     gen_leave_function(Kind save,char type, int incritical);
@@ -336,9 +369,19 @@ extern SYMBOL  *findglb(const char *sname);
 extern SYMBOL  *findloc(char *sname);
 extern SYMBOL  *addglb(char *sname, Type *type, enum ident_type id, Kind kind, int value, enum storage_type storage);
 extern SYMBOL  *addloc(char *sname, Type *type, enum ident_type id, Kind kind, int where);
+extern SYMBOL  *addlocstatic(char *sname, SYMBOL *target);
 
 /* while.c */
 extern void     addwhile(WHILE_TAB *ptr);
 extern void     delwhile(void);
 extern WHILE_TAB *readwhile(WHILE_TAB *ptr);
+extern SYMBOL   *loop_induction(int *step);
+extern WHILE_TAB *loop_subscript(LVALUE *lval, int *size);
+extern int      loop_reduce(WHILE_TAB *wq, SYMBOL *base, int size);
+extern void     loop_assigned(SYMBOL *sym);
+extern void     loop_unsafe(void);
+extern void     gen_loop_pointer(WHILE_TAB *wq, int idx, const char *code);
+extern void     gen_loop_pointers_init(WHILE_TAB *wq, t_buffer *cond, t_buffer *modify, t_buffer *body);
+extern void     gen_loop_pointers_step(WHILE_TAB *wq);
+extern void     gen_loop_pointers_body(WHILE_TAB *wq, t_buffer *body);
 #endif
@@ -159,6 +159,10 @@ void gen_file_header(void)
         outfmt(";\tModule compile time: %s\n",timestr);
     }
     nl();
+    if (c_function_sections) {
+        /* Let z80asm -gc-sections split the module at each public label */
+        outstr("__gc_split:\n\n");
+    }
 }
 
 
@@ -360,8 +364,10 @@ int getloc(SYMBOL* sym, int off)
 {
     int offs;
     offs = sym->offset.i - Zsp + off;
-    vconst(offs);
-    ol("add\thl,sp");
+    if ( gen_frame_pointer_address(sym->offset.i + off, offs) == 0 ) {
+        vconst(offs);
+        ol("add\thl,sp");
+    }
     return (offs);
 }
 
@@ -645,8 +651,7 @@ void putstk(LVALUE *lval)
         break;
     case KIND_STRUCT:
         pop("de");
-        outfmt("\tld\tbc,%d\n",lval->ltype->size);
-        ol("ldir");
+        gen_block_copy(lval->ltype->size);
         break;
     default: 
         pop("de");
@@ -983,8 +988,7 @@ int gen_push_function_argument(Kind expr, Type *type, int push_sdccchar)
         ol("ld\tsp,hl");
         Zsp -= type->size;
         swap();
-        outfmt("\tld\tbc,%d\n",type->size);
-        ol("ldir");
+        gen_block_copy(type->size);
         return type->size;
     } 
     // Default push the word
@@ -1030,8 +1034,7 @@ int push_function_argument_fnptr(Kind expr, Type *type, Type *functype, int push
         ol("push\tbc");
         Zsp -= type->size;
         swap();
-        outfmt("\tld\tbc,%d\n",type->size);
-        ol("ldir");
+        gen_block_copy(type->size);
         pop("hl");
         return type->size;
     } else if (is_last_argument == 0 || (functype->flags & FASTCALL) == 0 ) {
@@ -1403,7 +1406,8 @@ void gen_leave_function(Kind vartype, char type, int incritical)
     } else if (vartype == KIND_LONGLONG) {
         vartype = KIND_NONE;
     }
-    modstk(0, vartype, NO,YES);
+    gen_register_variables_leave(vartype, 0);
+    gen_frame_pointer_leave();
 
     if (callee_cleanup) {
         int bcused = 0;
@@ -4894,6 +4898,8 @@ void gen_push_frame(void)
         } else {
             ol("push\taf");
         }
+    } else {
+        gen_frame_pointer_enter();
     }
 }
 
@@ -4973,58 +4979,117 @@ void gen_builtin_strchr(int32_t c)
     postlabel(endlabel);
 }
 
-void gen_builtin_memset(int32_t c, int32_t s)
+/* Block copies and fills of up to this many bytes are unrolled, more with
+ * --opt-code-speed=copy
+ */
+#define COPY_UNROLL         2
+#define COPY_UNROLL_SPEED   16
+#define FILL_UNROLL         3
+#define FILL_UNROLL_SPEED   16
+
+/* Loop on b, the 8080 and gbz80 don't have djnz */
+static void gen_djnz(int label)
 {
-    if ( c == -1 ) {
-        /* Entry hl = c, on stack = buffer */
-        if ( IS_GBZ80() ) {
-            ol("ld\td,h");
-            ol("ld\te,l");
-        } else {
-            ol("ex\tde,hl");  /* c */
-        }
-        ol("pop\thl");  /* buffer */
-        Zsp += 2;
+    if ( IS_808x() || IS_GBZ80() ) {
+        ol("dec\tb");
+        opjump("nz,", label, 0);
     } else {
-        /* hl is buffer - data load happens a bit later*/
+        outstr("\tdjnz\t"); printlabel(label); nl();
     }
-    ol("push\thl");
+}
 
-    /* Now decide what to do about the count */
-    if ( s < 4 ) {
-        int i;
-        for ( i = 0; i < s; i++ ) {
-            if ( i  != 0 ) {
-                ol("inc\thl");
+/* Copy n bytes from (hl) to (de)
+ *
+ * Exit: hl, de = past the end of the blocks, a, bc = corrupted
+ */
+void gen_block_copy(int32_t n)
+{
+    int limit = (c_speed_optimisation & OPT_COPY) ? COPY_UNROLL_SPEED : COPY_UNROLL;
+    int i;
+
+    n %= 65536;
+    if ( IS_808x() || IS_GBZ80() ) {
+        /* No ldi, ldir is a library routine */
+        if ( n > 0 && n <= 256 ) {
+            int looplabel = getlabel();
+
+            if ( n > limit ) {
+                outstr("\tld\tb,"); outdec(n % 256); nl();
+                postlabel(looplabel);
             }
-            if ( c != -1 ) {
-                outstr("\tld\t(hl),"); outdec(c % 256); nl();
-            } else {
-                ol("ld\t(hl),e");
+            for ( i = 0; i < (n > limit ? 1 : n); i++ ) {
+                if ( IS_GBZ80() ) {
+                    ol("ld\ta,(hl+)");
+                } else {
+                    ol("ld\ta,(hl)");
+                    ol("inc\thl");
+                }
+                ol("ld\t(de),a");
+                ol("inc\tde");
             }
+            if ( n > limit ) {
+                gen_djnz(looplabel);
+            }
+            return;
         }
-    } else if ( s <= 256 ) {
-        int looplabel = getlabel();
-        if ( c != -1 ) {
-            outstr("\tld\te,"); outdec(c % 256); nl();
+    } else if ( n > 0 && n <= limit ) {
+        for ( i = 0; i < n; i++ ) {
+            ol("ldi");
+        }
+        return;
+    }
+    outstr("\tld\tbc,"); outdec(n); nl();
+    ol("ldir");
+}
+
+/* Fill n bytes at (hl) with a
+ *
+ * Exit: hl = last byte filled, bc, de = corrupted
+ */
+void gen_block_fill(int32_t n)
+{
+    int limit = (c_speed_optimisation & OPT_COPY) ? FILL_UNROLL_SPEED : FILL_UNROLL;
+    int i;
+
+    n %= 65536;
+    if ( n > 0 && n <= limit ) {
+        for ( i = 0; i < n; i++ ) {
+            if ( i != 0 ) {
+                ol("inc\thl");
+            }
+            ol("ld\t(hl),a");
         }
-        outstr("\tld\tb,"); outdec(s % 256); nl();
+    } else if ( n > 0 && n <= 256 ) {
+        int looplabel = getlabel();
+
+        outstr("\tld\tb,"); outdec(n % 256); nl();
         postlabel(looplabel);
-        ol("ld\t(hl),e");
+        ol("ld\t(hl),a");
         ol("inc\thl");
-        outstr("\tdjnz\t"); printlabel(looplabel); nl();
+        gen_djnz(looplabel);
     } else {
-        if ( c != -1 ) {
-            outstr("\tld\t(hl),"); outdec(c % 256); nl();
-        } else {
-            ol("ld\t(hl),e");
-        }
+        ol("ld\t(hl),a");
         ol("ld\td,h");
         ol("ld\te,l");
         ol("inc\tde");
-        outstr("\tld\tbc,"); outdec((s % 65536) - 1); nl();
+        outstr("\tld\tbc,"); outdec((n - 1) % 65536); nl();
         ol("ldir");
     }
+}
+
+void gen_builtin_memset(int32_t c, int32_t s)
+{
+    if ( c == -1 ) {
+        /* Entry hl = c, on stack = buffer */
+        ol("ld\ta,l");
+        ol("pop\thl");  /* buffer */
+        Zsp += 2;
+    } else {
+        /* hl is buffer */
+        outstr("\tld\ta,"); outdec(c % 256); nl();
+    }
+    ol("push\thl");
+    gen_block_fill(s);
     ol("pop\thl");
 }
 
@@ -5035,16 +5100,18 @@ void gen_builtin_memcpy(int32_t src, int32_t n)
         ol("pop\tde");  /* dst */
         ol("push\tde");
         Zsp += 2;
-        outstr("\tld\tbc,"); outdec(n % 65536); nl();
-	ol("ldir");
     } else {
         /* hl is dst */
         ol("push\thl");
-        ol("ex\tde,hl");
+        if ( IS_GBZ80() ) {
+            ol("ld\td,h");
+            ol("ld\te,l");
+        } else {
+            ol("ex\tde,hl");
+        }
         outstr("\tld\thl,"); outdec(src % 65536); nl();
-        outstr("\tld\tbc,"); outdec(n % 65536); nl();
-	ol("ldir");
     }
+    gen_block_copy(n);
     ol("pop\thl");
 }
 
@@ -5055,8 +5122,7 @@ void copy_to_stack(char *label, int stack_offset,  int size)
     ol("add\thl,sp");  
     ol("ex\tde,hl");
     outstr("\tld\thl,"); outname(label, 1); nl();
-    outfmt("\tld\tbc,%d\n",size);
-    ol("ldir");
+    gen_block_copy(size);
 }
 
 void copy_to_extern(const char *src, const char *dest, int size)
@@ -5070,8 +5136,7 @@ void copy_to_extern(const char *src, const char *dest, int size)
     } else {
         outfmt("\tld\thl,_%s\n",src);  // 11 bytes
         outfmt("\tld\tde,_%s\n",dest);
-        outfmt("\tld\tbc,%d\n",size);
-        outfmt("\tldir\n",src);
+        gen_block_copy(size);
     }
 }
 
@@ -5481,6 +5546,189 @@ void gen_switch_postamble(Kind kind)
     }
 }
 
+
+/*
+ * Dispatch of char and int switches through a jump table or a binary
+ * search, when better than the linear case table
+ */
+
+typedef struct {
+    int64_t key;        /* case value, biased to compare unsigned */
+    int     label;
+    int     order;      /* position in source, the first duplicate wins */
+} switch_key;
+
+static int switch_key_cmp(const void *a, const void *b)
+{
+    const switch_key *ka = a, *kb = b;
+
+    if ( ka->key != kb->key )
+        return ka->key < kb->key ? -1 : 1;
+    return ka->order - kb->order;
+}
+
+/* Jump through a table indexed by the value - min, A or HL holds the value */
+static void gen_switch_jumptable(int is8bit, int64_t min, switch_key *keys, int nkeys, int range, int deflabel)
+{
+    int tablelabel = getlabel();
+    int i, j;
+
+    if ( is8bit ) {
+        if ( min != 0 ) {
+            ot("sub\t");
+            outdec(min);
+            nl();
+        }
+        if ( range < 256 ) {
+            ot("cp\t");
+            outdec(range);
+            nl();
+            opjump("nc,", deflabel, 0);
+        }
+        ol("ld\tl,a");
+        ol("ld\th,0");
+    } else {
+        if ( min != 0 ) {
+            ot("ld\tde,");
+            outdec((-min) & 0xffff);
+            nl();
+            ol("add\thl,de");
+        }
+        ol("ld\ta,h");
+        ol("and\ta");
+        opjump("nz,", deflabel, 0);
+        if ( range < 256 ) {
+            ol("ld\ta,l");
+            ot("cp\t");
+            outdec(range);
+            nl();
+            opjump("nc,", deflabel, 0);
+        }
+    }
+    ol("add\thl,hl");
+    ot("ld\tde,");
+    printlabel(tablelabel);
+    nl();
+    ol("add\thl,de");
+    ol("ld\ta,(hl)");
+    ol("inc\thl");
+    ol("ld\th,(hl)");
+    ol("ld\tl,a");
+    ol("jp\t(hl)");
+    postlabel(tablelabel);
+    for ( i = 0, j = 0; i < range; i++ ) {
+        while ( j < nkeys && keys[j].key < keys[0].key + i )
+            j++;
+        defword();
+        printlabel(j < nkeys && keys[j].key == keys[0].key + i ? keys[j].label : deflabel);
+        nl();
+    }
+}
+
+/* Compare with the middle case and search each half, A or HL holds the value */
+static void gen_switch_bsearch(int is8bit, switch_key *keys, int nkeys, int deflabel)
+{
+    int mid = nkeys / 2;
+    int lowlabel = 0;
+
+    if ( is8bit ) {
+        ot("cp\t");
+        outdec(keys[mid].key);
+        nl();
+    } else {
+        ot("ld\tde,");
+        outdec(keys[mid].key);
+        nl();
+        ol("and\ta");
+        ol("sbc\thl,de");
+        ol("add\thl,de");
+    }
+    opjump("z,", keys[mid].label, 0);
+    if ( nkeys == 1 ) {
+        gen_jp_label(deflabel, 0);
+        return;
+    }
+    if ( mid == 0 ) {
+        opjump("c,", deflabel, 0);
+    } else {
+        lowlabel = getlabel();
+        opjump("c,", lowlabel, 0);
+    }
+    if ( mid + 1 < nkeys ) {
+        gen_switch_bsearch(is8bit, keys + mid + 1, nkeys - mid - 1, deflabel);
+    } else {
+        gen_jp_label(deflabel, 0);
+    }
+    if ( mid > 0 ) {
+        postlabel(lowlabel);
+        gen_switch_bsearch(is8bit, keys, mid, deflabel);
+    }
+}
+
+/*
+ * Generate the switch dispatch for the value in HL, or return 0 to use the
+ * case table. A jump table is used when it is smaller than the case table
+ * or, with --opt-code-speed=switch, when at least a third of it is used;
+ * a binary search is used for larger sets of cases when optimising for speed.
+ */
+int gen_switch_dispatch(Kind kind, unsigned char isunsigned, SW_TAB *cases, int ncases, int deflabel)
+{
+    int is8bit = (kind == KIND_CHAR);
+    int speed = (c_speed_optimisation & OPT_SWITCH) != 0;
+    switch_key *keys;
+    int64_t bias, mask, range;
+    int i, nkeys, tablesize, jumptablesize;
+
+    if ( IS_808x() || IS_GBZ80() || ncases < 4 )
+        return 0;
+    if ( kind == KIND_LONG || kind == KIND_CPTR || kind == KIND_LONGLONG )
+        return 0;
+
+    /* compare as unsigned values, signed values are biased by the sign bit */
+    mask = is8bit ? 0xff : 0xffff;
+    bias = isunsigned ? 0 : (mask + 1) / 2;
+    keys = MALLOC(ncases * sizeof(keys[0]));
+    for ( i = 0; i < ncases; i++ ) {
+        keys[i].key = (cases[i].value + bias) & mask;
+        keys[i].label = cases[i].label;
+        keys[i].order = i;
+    }
+    qsort(keys, ncases, sizeof(keys[0]), switch_key_cmp);
+    for ( i = 1, nkeys = 1; i < ncases; i++ ) {
+        if ( keys[i].key != keys[nkeys - 1].key )
+            keys[nkeys++] = keys[i];
+    }
+    range = keys[nkeys - 1].key - keys[0].key + 1;
+
+    /* sizes in bytes of the dispatch, including the jump to default */
+    tablesize = is8bit ? 1 + 5 * nkeys + 3 : 3 + 4 * nkeys + 2 + 3;
+    jumptablesize = (is8bit ? 21 : 25) + 2 * range;
+
+    if ( range <= 256 && (jumptablesize <= tablesize || (speed && range <= 3 * nkeys)) ) {
+        if ( is8bit ) {
+            ol("ld\ta,l");
+        }
+        /* the bias cancels out when subtracting the minimum */
+        gen_switch_jumptable(is8bit, (keys[0].key - bias) & mask, keys, nkeys, range, deflabel);
+    } else if ( speed && nkeys >= 8 ) {
+        if ( is8bit ) {
+            ol("ld\ta,l");
+            if ( bias )
+                ol("xor\t128");
+        } else if ( bias ) {
+            ol("ld\ta,h");
+            ol("xor\t128");
+            ol("ld\th,a");
+        }
+        gen_switch_bsearch(is8bit, keys, nkeys, deflabel);
+    } else {
+        FREENULL(keys);
+        return 0;
+    }
+    FREENULL(keys);
+    return 1;
+}
+
 /*
  * Local Variables:
  *  indent-tabs-mode:nil
@@ -5493,3 +5741,738 @@ void gen_switch_postamble(Kind kind)
  *  eval: (c-set-offset 'class-close 4)
  * End:
  */
+
+
+/*
+ * Register variables
+ *
+ * A top level register int or pointer has a two byte slot on the stack.
+ * Its uses are written as marker lines to a buffer holding the rest of
+ * the function. When the function ends the variable with most uses is
+ * given ix, which the slot saves for the caller, as long as the function
+ * doesn't use ix itself or call anything other than runtime helpers that
+ * leave ix alone. Otherwise the variables live in their slots.
+ *
+ * The buffer nests inside those of --opt-dataflow and -frameauto, which
+ * are started first and so see the final code. -frameauto leaves ix alone
+ * in a function where it holds a register variable.
+ */
+
+#define REGVAR_MARKER   '\001'
+#define REGVAR_MAX      8
+
+static t_buffer *regvar_buffer;
+static t_buffer *regvar_outer;      /* Where the function is being written */
+static int       regvar_slots[REGVAR_MAX];
+static int       regvar_count;
+static int       regvar_disabled;
+
+/* Runtime helpers that don't use ix */
+static const char *regvar_safe_calls[] = {
+    "l_and", "l_asl", "l_asr", "l_asr_u", "l_bool", "l_case", "l_cmp",
+    "l_com", "l_div", "l_div_u", "l_eq", "l_gchar", "l_gcharsp",
+    "l_gcharspsp", "l_ge", "l_gint", "l_gintsp", "l_gintspsp", "l_gt",
+    "l_le", "l_lneg", "l_lt", "l_mult", "l_ne", "l_neg", "l_or", "l_pint",
+    "l_sub", "l_sxt", "l_ucmp", "l_uge", "l_ugt", "l_ule", "l_ult", "l_xor",
+    NULL
+};
+
+void gen_register_variables_start(void)
+{
+    regvar_buffer = NULL;
+    regvar_outer = currentbuffer;
+    regvar_count = 0;
+    regvar_disabled = 0;
+}
+
+/* Stop variables from being held in ix, eg when there's a goto */
+void gen_register_variables_disable(void)
+{
+    regvar_disabled = 1;
+}
+
+/* Allocate the slot of a register variable, return 0 if it can't be one */
+int gen_register_variable(void)
+{
+    if ( IS_808x() || IS_GBZ80() || (c_cpu & CPU_RABBIT) )
+        return 0;
+    if ( currfn->ctype->flags & (NAKED|INTERRUPT|SAVEFRAME) )
+        return 0;
+    if ( c_framepointer_is_ix != -1 ) {
+        warningfmt("unsupported-feature", "register is ignored when %s is the frame pointer", c_framepointer_is_ix ? "ix" : "iy");
+        return 0;
+    }
+    if ( regvar_count == REGVAR_MAX ) {
+        warningfmt("unsupported-feature", "register is ignored after %d register variables", REGVAR_MAX);
+        return 0;
+    }
+    /* Anything else being buffered is inside the function */
+    if ( stagenext != NULL || currentbuffer != (regvar_buffer ? regvar_buffer : regvar_outer) ) {
+        warningfmt("unsupported-feature", "register is ignored, the code of the function is already being buffered");
+        return 0;
+    }
+
+    if ( regvar_buffer == NULL )
+        regvar_buffer = startbuffer(100);
+    Zsp -= 2;
+    regvar_slots[regvar_count++] = Zsp;
+    outfmt("%cS%d\n", REGVAR_MARKER, Zsp);
+    return Zsp;
+}
+
+void gen_load_register(SYMBOL *sym)
+{
+    outfmt("%cL%d,%d\n", REGVAR_MARKER, sym->offset.i, sym->offset.i - Zsp);
+}
+
+void gen_store_register(SYMBOL *sym)
+{
+    outfmt("%cT%d,%d\n", REGVAR_MARKER, sym->offset.i, sym->offset.i - Zsp);
+}
+
+/*
+ * Unwind the stack to newsp on leaving the function, restoring ix from
+ * its slot if it was used. Code can follow a return so Zsp is unchanged.
+ */
+void gen_register_variables_leave(Kind vartype, int newsp)
+{
+    int savesp = Zsp;
+    int i;
+
+    for ( i = regvar_count - 1; i >= 0; i-- ) {
+        if ( Zsp <= regvar_slots[i] && regvar_slots[i] < newsp ) {
+            Zsp = modstk(regvar_slots[i], vartype, NO, YES);
+            outfmt("%cR%d\n", REGVAR_MARKER, regvar_slots[i]);
+            Zsp += 2;
+        }
+    }
+    modstk(newsp, vartype, NO, YES);
+    Zsp = savesp;
+}
+
+/*
+ * Return 0 if the line calls anything other than a runtime helper, safe
+ * lists the helpers allowed or is NULL for any that doesn't call back
+ */
+static int helper_call_line(const char *line, const char **safe)
+{
+    const char *p, *name;
+    size_t len;
+    int i;
+
+    if ( strstr(line, "\trst\t") != NULL )
+        return 0;
+    if ( (p = strstr(line, "\tcall\t")) != NULL ) {
+        name = p + 6;
+        if ( (p = strchr(name, ',')) != NULL )
+            name = p + 1;
+        len = strcspn(name, " \t;\n");
+        if ( safe == NULL )
+            return strncmp(name, "l_", 2) == 0 && strncmp(name, "l_jphl", len) != 0;
+        for ( i = 0; safe[i] != NULL; i++ ) {
+            if ( strlen(safe[i]) == len && strncmp(safe[i], name, len) == 0 )
+                return 1;
+        }
+        return 0;
+    }
+    return 1;
+}
+
+static int regvar_safe_line(const char *line)
+{
+    const char *p;
+
+    /* any use of ix or its halves */
+    for ( p = line; (p = strstr(p, "ix")) != NULL; p += 2 ) {
+        const char *q = p + 2;
+
+        if ( *q == 'l' || *q == 'h' )
+            q++;
+        if ( (p == line || !isalnum((unsigned char)p[-1])) && !isalnum((unsigned char)*q) && *q != '_' )
+            return 0;
+    }
+    return helper_call_line(line, regvar_safe_calls);
+}
+
+/* Choose the variable held in ix and write out the function */
+void gen_register_variables_end(void)
+{
+    t_buffer *buf = regvar_buffer;
+    int uses[REGVAR_MAX] = { 0 };
+    int chosen = 0, use_ix = !regvar_disabled;
+    char *line, *end;
+    int i, slot, offs;
+
+    if ( buf == NULL )
+        return;
+    regvar_buffer = NULL;
+    if ( currentbuffer == buf )
+        suspendbuffer();
+    *buf->next = '\0';
+
+    for ( line = buf->start; *line; line = end ) {
+        if ( (end = strchr(line, '\n')) != NULL )
+            end++;
+        else
+            end = line + strlen(line);
+        if ( line[0] == REGVAR_MARKER ) {
+            if ( line[1] == 'L' || line[1] == 'T' ) {
+                slot = atoi(line + 2);
+                for ( i = 0; i < regvar_count; i++ ) {
+                    if ( regvar_slots[i] == slot )
+                        uses[i]++;
+                }
+            }
+        } else {
+            char save = *end;
+            *end = '\0';
+            if ( regvar_safe_line(line) == 0 )
+                use_ix = 0;
+            *end = save;
+        }
+    }
+    for ( i = 1; i < regvar_count; i++ ) {
+        if ( uses[i] > uses[chosen] )
+            chosen = i;
+    }
+    if ( use_ix == 0 || uses[chosen] == 0 )
+        chosen = -1;
+
+    for ( line = buf->start; *line; line = end ) {
+        if ( (end = strchr(line, '\n')) != NULL )
+            end++;
+        else
+            end = line + strlen(line);
+        if ( line[0] != REGVAR_MARKER ) {
+            char save = *end;
+            *end = '\0';
+            outstr(line);
+            *end = save;
+            continue;
+        }
+        slot = atoi(line + 2);
+        offs = strchr(line, ',') ? atoi(strchr(line, ',') + 1) : 0;
+        if ( chosen >= 0 && slot == regvar_slots[chosen] ) {
+            switch ( line[1] ) {
+            case 'S':
+                ol("push\tix");
+                break;
+            case 'L':
+                /* The comment keeps copt from taking it for a pop of the stack */
+                ol("push\tix");
+                ot("pop\thl\t;ix");
+                nl();
+                break;
+            case 'T':
+                ol("push\thl");
+                ol("pop\tix");
+                break;
+            case 'R':
+                ol("pop\tix");
+                break;
+            }
+        } else {
+            switch ( line[1] ) {
+            case 'S':
+                ol("push\tbc");
+                break;
+            case 'L':
+                /* As for any other local, so the peephole rules apply */
+                vconst(offs);
+                ol("add\thl,sp");
+                ot("call\tl_gint\t;");
+                nl();
+                break;
+            case 'T':
+                if ( offs == 0 ) {
+                    ol("pop\tbc");
+                    ol("push\thl");
+                } else if ( offs == 2 ) {
+                    ol("pop\tde");
+                    ol("pop\tbc");
+                    ol("push\thl");
+                    ol("push\tde");
+                } else {
+                    swap();
+                    vconst(offs);
+                    ol("add\thl,sp");
+                    ol("ld\t(hl),e");
+                    ol("inc\thl");
+                    ol("ld\t(hl),d");
+                    swap();
+                }
+                break;
+            case 'R':
+                ol("pop\tbc");
+                break;
+            }
+        }
+    }
+    FREENULL(buf->start);
+    FREENULL(buf);
+}
+
+
+/*
+ * Automatic frame pointer
+ *
+ * With -frameauto the code of a function is collected with a marker line
+ * in place of each address of a local or parameter. When the function
+ * ends the int and char loads and stores through those addresses are
+ * found, and if reaching them as (ix+d) saves more bytes than setting up
+ * ix costs, or more T-states with --opt-code-speed=frame, ix becomes the
+ * frame pointer of the function. As with register variables that's only
+ * when the function doesn't use ix itself or call anything other than
+ * runtime helpers that leave ix alone.
+ *
+ * ix is pushed on entry without changing Zsp, so the locals stay at the
+ * same offsets from sp and the parameters move two bytes further away.
+ */
+
+#define FRAME_MARKER        '\003'
+#define FRAME_ENTER_BYTES   8       /* push ix ; ld ix,0 ; add ix,sp */
+#define FRAME_LEAVE_BYTES   2       /* pop ix at each exit */
+#define FRAME_TSTATES       58      /* Entry and one exit */
+
+/* What's written for a line when ix is the frame pointer */
+enum frame_action {
+    FRAME_KEEP,             /* The line, or the address from sp for a marker */
+    FRAME_DROP,
+    FRAME_GET_INT,          /* ld l,(ix+d) ; ld h,(ix+d+1) */
+    FRAME_GET_CHAR,         /* ld a,(ix+d) ; call l_sxt */
+    FRAME_GET_UCHAR,        /* ld l,(ix+d) */
+    FRAME_PUT_INT,          /* ld (ix+d),l ; ld (ix+d+1),h */
+    FRAME_PUT_CHAR          /* ld (ix+d),a */
+};
+
+/* Bytes and T-states saved by each action over the line it replaces */
+static const struct {
+    int bytes;
+    int tstates;
+} frame_saving[] = {
+    {  0,  0 },
+    {  0,  0 },             /* Depends on the line */
+    { -3, 13 },             /* call l_gint */
+    { -3, -8 },             /* call l_gchar */
+    { -2, -12 },            /* ld l,(hl) */
+    { -3, 17 },             /* call l_pint */
+    { -2, -12 }             /* ld (de),a */
+};
+
+typedef struct {
+    char   *text;
+    char    action;
+    int     disp;           /* d of (ix+d) */
+    int     sp_offset;      /* Of an address, as compiled */
+    int     shift;          /* Added to sp_offset when ix has been pushed */
+} frame_line;
+
+static t_buffer   *frame_buffer;
+static int         frame_disabled;
+static frame_line *frame_lines;
+static int         frame_len;
+static int         frame_size;
+static int         frame_bytes;
+static int         frame_tstates;
+
+void gen_frame_pointer_start(void)
+{
+    frame_buffer = NULL;
+    frame_disabled = 0;
+    if ( c_framepointer_auto == 0 || c_framepointer_is_ix != -1 )
+        return;
+    if ( IS_808x() || IS_GBZ80() || (c_cpu & CPU_RABBIT) )
+        return;
+    if ( currfn->ctype->flags & (NAKED|INTERRUPT|SAVEFRAME) )
+        return;
+    frame_buffer = startbuffer(1000);
+}
+
+/* Keep sp addressing, eg when there's inline assembler */
+void gen_frame_pointer_disable(void)
+{
+    frame_disabled = 1;
+}
+
+/* Write a marker for the address of a local, return 0 when not collecting */
+int gen_frame_pointer_address(int frame_offset, int sp_offset)
+{
+    if ( frame_buffer == NULL )
+        return 0;
+    outfmt("%cA%d,%d\n", FRAME_MARKER, frame_offset, sp_offset);
+    return 1;
+}
+
+void gen_frame_pointer_enter(void)
+{
+    if ( frame_buffer != NULL )
+        outfmt("%cE\n", FRAME_MARKER);
+}
+
+/* On leaving the function, once the locals have been dropped */
+void gen_frame_pointer_leave(void)
+{
+    if ( frame_buffer != NULL )
+        outfmt("%cX\n", FRAME_MARKER);
+}
+
+static const char *frame_text(int i)
+{
+    return i < frame_len ? frame_lines[i].text : "";
+}
+
+/* Test whether the line is the instruction, whatever follows it */
+static int frame_is(const char *line, const char *insn)
+{
+    size_t len = strlen(insn);
+
+    return strncmp(line, insn, len) == 0 && (line[len] == 0 || line[len] == '\t' || line[len] == ';');
+}
+
+static void frame_mark(int i, int action, int disp)
+{
+    frame_lines[i].action = action;
+    frame_lines[i].disp = disp;
+    frame_bytes += frame_saving[(int)action].bytes;
+    frame_tstates += frame_saving[(int)action].tstates;
+}
+
+static void frame_drop(int i, int bytes, int tstates)
+{
+    frame_lines[i].action = FRAME_DROP;
+    frame_bytes += bytes;
+    frame_tstates += tstates;
+}
+
+/* The load through hl at line i, or FRAME_KEEP */
+static int frame_load(int i)
+{
+    if ( frame_is(frame_text(i), "\tcall\tl_gint") )
+        return FRAME_GET_INT;
+    if ( frame_is(frame_text(i), "\tcall\tl_gchar") )
+        return FRAME_GET_CHAR;
+    if ( frame_is(frame_text(i), "\tld\tl,(hl)") && frame_is(frame_text(i + 1), "\tld\th,0") )
+        return FRAME_GET_UCHAR;
+    return FRAME_KEEP;
+}
+
+/* An address followed by a load through it */
+static void frame_address(int i)
+{
+    frame_line *fl = &frame_lines[i];
+    int         frame_offset, load;
+
+    frame_offset = atoi(fl->text + 2);
+    fl->sp_offset = atoi(strchr(fl->text, ',') + 1);
+    fl->shift = frame_offset > 0 ? 2 : 0;
+    fl->disp = frame_offset + fl->shift;
+
+    /* The runtime loads the top two words of the stack more cheaply */
+    if ( fl->disp < -128 || fl->disp > 126 || fl->sp_offset + fl->shift <= 2 )
+        return;
+    if ( (load = frame_load(i + 1)) != FRAME_KEEP ) {
+        frame_drop(i, 4, 21);
+        frame_mark(i + 1, load, fl->disp);
+    }
+}
+
+/*
+ * An address pushed at line i then stored to by the pop de that balances
+ * the push, with nothing between that could branch or move sp. The push
+ * and pop are dropped too if nothing between is addressed from sp.
+ */
+static void frame_store(int i)
+{
+    const char *text;
+    int disp = frame_lines[i].disp;
+    int load = FRAME_KEEP, store, j, depth = 0, from_sp = 0;
+
+    text = frame_text(i + 2);
+    if ( text[0] != FRAME_MARKER && strncmp(text, "\tld\thl,", 7) != 0 ) {
+        /* Otherwise hl still holds the address so it has to be a load */
+        if ( (load = frame_load(i + 2)) == FRAME_KEEP )
+            return;
+    }
+    for ( j = i + 2; j < frame_len; j++ ) {
+        text = frame_text(j);
+        if ( text[0] == FRAME_MARKER ) {
+            if ( text[1] != 'A' )
+                return;
+            if ( frame_lines[j].action == FRAME_KEEP )
+                from_sp = 1;
+        } else if ( text[0] == 0 || text[0] == ';' || frame_is(text, "\tC_LINE") ) {
+            continue;
+        } else if ( text[0] != '\t' || strstr(text, "sp") != NULL || frame_is(text, "\tjp") ||
+                    frame_is(text, "\tjr") || frame_is(text, "\tdjnz") || frame_is(text, "\tret") ) {
+            return;
+        } else if ( frame_is(text, "\tpush") ) {
+            depth++;
+        } else if ( frame_is(text, "\tpop") && depth-- == 0 ) {
+            break;
+        }
+    }
+    if ( strcmp(frame_text(j), "\tpop\tde") != 0 )
+        return;
+    if ( frame_is(frame_text(j + 1), "\tcall\tl_pint") ) {
+        store = j + 1;
+        frame_mark(store, FRAME_PUT_INT, disp);
+    } else if ( strcmp(frame_text(j + 1), "\tld\ta,l") == 0 && strcmp(frame_text(j + 2), "\tld\t(de),a") == 0 ) {
+        store = j + 2;
+        frame_mark(store, FRAME_PUT_CHAR, disp);
+    } else {
+        return;
+    }
+    frame_drop(i, 4, 21);
+    if ( load != FRAME_KEEP )
+        frame_mark(i + 2, load, disp);
+    if ( from_sp == 0 ) {
+        frame_drop(i + 1, 1, 11);
+        frame_drop(j, 1, 10);
+    }
+}
+
+static void frame_write(frame_line *fl, int use_ix)
+{
+    const char *text = fl->text;
+    int d = fl->disp;
+
+    if ( use_ix == 0 || fl->action == FRAME_KEEP ) {
+        if ( text[0] != FRAME_MARKER ) {
+            outstr(text);
+            nl();
+        } else if ( text[1] == 'A' ) {
+            vconst(fl->sp_offset + (use_ix ? fl->shift : 0));
+            ol("add\thl,sp");
+        } else if ( use_ix && text[1] == 'E' ) {
+            ol("push\tix");
+            ol("ld\tix,0");
+            ol("add\tix,sp");
+        } else if ( use_ix && text[1] == 'X' ) {
+            ol("pop\tix");
+        }
+        return;
+    }
+    switch ( fl->action ) {
+    case FRAME_GET_INT:
+        outfmt("\tld\tl,(ix%+d)\n", d);
+        outfmt("\tld\th,(ix%+d)\n", d + 1);
+        break;
+    case FRAME_GET_CHAR:
+        outfmt("\tld\ta,(ix%+d)\n", d);
+        ol("call\tl_sxt");
+        break;
+    case FRAME_GET_UCHAR:
+        outfmt("\tld\tl,(ix%+d)\n", d);
+        break;
+    case FRAME_PUT_INT:
+        outfmt("\tld\t(ix%+d),l\n", d);
+        outfmt("\tld\t(ix%+d),h\n", d + 1);
+        break;
+    case FRAME_PUT_CHAR:
+        outfmt("\tld\t(ix%+d),a\n", d);
+        break;
+    }
+}
+
+/* Decide whether to use ix as the frame pointer and write out the function */
+void gen_frame_pointer_end(void)
+{
+    t_buffer *buf = frame_buffer;
+    char *line, *end;
+    int i, exits = 0, use_ix = !frame_disabled;
+
+    if ( buf == NULL )
+        return;
+    frame_buffer = NULL;
+    if ( currentbuffer == buf )
+        suspendbuffer();
+    *buf->next = '\0';
+
+    frame_len = 0;
+    for ( line = buf->start; *line; line = end ) {
+        if ( (end = strchr(line, '\n')) != NULL )
+            *end++ = '\0';
+        else
+            end = line + strlen(line);
+        if ( frame_len == frame_size ) {
+            frame_size = frame_size ? frame_size * 2 : 256;
+            frame_lines = REALLOC(frame_lines, frame_size * sizeof(frame_line));
+        }
+        memset(&frame_lines[frame_len], 0, sizeof(frame_line));
+        frame_lines[frame_len++].text = line;
+    }
+
+    frame_bytes = frame_tstates = 0;
+    for ( i = 0; i < frame_len; i++ ) {
+        line = frame_lines[i].text;
+        if ( line[0] != FRAME_MARKER ) {
+            if ( regvar_safe_line(line) == 0 )
+                use_ix = 0;
+        } else if ( line[1] == 'X' ) {
+            exits++;
+        } else if ( line[1] == 'A' ) {
+            frame_address(i);
+        }
+    }
+    /* Inner assignments first, so an outer one knows what's left using sp */
+    for ( i = frame_len - 1; i >= 0; i-- ) {
+        frame_line *fl = &frame_lines[i];
+
+        if ( fl->text[0] == FRAME_MARKER && fl->text[1] == 'A' && fl->action == FRAME_KEEP &&
+             fl->disp >= -128 && fl->disp <= 126 && strcmp(frame_text(i + 1), "\tpush\thl") == 0 ) {
+            frame_store(i);
+        }
+    }
+
+    if ( use_ix ) {
+        if ( c_speed_optimisation & OPT_FRAME )
+            use_ix = frame_tstates > FRAME_TSTATES;
+        else
+            use_ix = frame_bytes > FRAME_ENTER_BYTES + exits * FRAME_LEAVE_BYTES;
+    }
+    for ( i = 0; i < frame_len; i++ ) {
+        frame_write(&frame_lines[i], use_ix);
+    }
+    FREENULL(buf->start);
+    FREENULL(buf);
+}
+
+
+/*
+ * Pointers for subscripts by the variable of a for loop
+ *
+ * The code of each subscript is written between marker lines naming the
+ * loop and its pointer. When the body has been parsed the pointers are
+ * held in statics, so they're only used when nothing in the loop can
+ * call back into the function, and the marked code is replaced by a
+ * load of the pointer.
+ */
+
+#define LOOP_MARKER     '\002'
+
+void gen_loop_pointer(WHILE_TAB *wq, int idx, const char *code)
+{
+    outfmt("%cR%d,%d\n", LOOP_MARKER, wq->exit, idx);
+    outstr(code);
+    outfmt("%cE%d\n", LOOP_MARKER, wq->exit);
+}
+
+static int loop_safe_buffer(t_buffer *buf)
+{
+    char *line, *end;
+    int safe = 1;
+
+    *buf->next = '\0';
+    for ( line = buf->start; *line && safe; line = end ) {
+        if ( (end = strchr(line, '\n')) != NULL )
+            end++;
+        else
+            end = line + strlen(line);
+        if ( line[0] != LOOP_MARKER && line[0] != REGVAR_MARKER ) {
+            char save = *end;
+            *end = '\0';
+            safe = helper_call_line(line, NULL);
+            *end = save;
+        }
+    }
+    return safe;
+}
+
+/* Set up the pointers before the loop starts */
+void gen_loop_pointers_init(WHILE_TAB *wq, t_buffer *cond, t_buffer *modify, t_buffer *body)
+{
+    char namebuf[NAMESIZE * 2 + 10];
+    char *before, *start;
+    t_buffer *buf;
+    SYMBOL *sym;
+    zdouble val;
+    int vconst, i;
+    Type *type;
+
+    if ( wq->unsafe || wq->nreduce == 0 )
+        return;
+    if ( loop_safe_buffer(cond) == 0 || loop_safe_buffer(modify) == 0 || loop_safe_buffer(body) == 0 )
+        return;
+
+    for ( i = 0; i < wq->nreduce; i++ ) {
+        if ( wq->reduce_assigned[i] )
+            continue;
+        snprintf(namebuf, sizeof(namebuf), "sr_%s_%d_%d", currfn->name, wq->exit, i);
+        sym = addglb(namebuf, type_uint, ID_VARIABLE, KIND_INT, 0, LSTATIC);
+        sym->bss_section = STRDUP(get_section_name(NULL, c_bss_section));
+        wq->reduce_ptr[i] = sym;
+
+        buf = getbuffer();
+        bufferstr(buf, "&", 1);
+        bufferstr(buf, wq->reduce_base[i]->name, strlen(wq->reduce_base[i]->name));
+        bufferstr(buf, "[", 1);
+        bufferstr(buf, wq->induction->name, strlen(wq->induction->name));
+        bufferstr(buf, "];\n", 3);
+        loop_reducing = 1;
+        set_temporary_input(buf);
+        setstage(&before, &start);
+        expression(&vconst, &val, &type);
+        gen_store_static(sym);
+        clearstage(before, start);
+        restore_input();
+        loop_reducing = 0;
+        releasebuffer(buf);
+    }
+}
+
+/* Step the pointers along with the variable */
+void gen_loop_pointers_step(WHILE_TAB *wq)
+{
+    LVALUE lval = {0};
+    int i;
+
+    lval.val_type = KIND_INT;
+    for ( i = 0; i < wq->nreduce; i++ ) {
+        if ( wq->reduce_ptr[i] != NULL ) {
+            gen_load_static(wq->reduce_ptr[i]);
+            zadd_const(&lval, wq->step * wq->reduce_size[i]);
+            gen_store_static(wq->reduce_ptr[i]);
+        }
+    }
+}
+
+/* Write out the body, loading the pointers in place of the subscripts */
+void gen_loop_pointers_body(WHILE_TAB *wq, t_buffer *body)
+{
+    char *line, *end, *next;
+    int idx;
+
+    *body->next = '\0';
+    for ( line = body->start; *line; line = end ) {
+        if ( (end = strchr(line, '\n')) != NULL )
+            end++;
+        else
+            end = line + strlen(line);
+        if ( line[0] != LOOP_MARKER || atoi(line + 2) != wq->exit ) {
+            char save = *end;
+            *end = '\0';
+            outstr(line);
+            *end = save;
+            continue;
+        }
+        if ( line[1] != 'R' )
+            continue;
+        idx = atoi(strchr(line, ',') + 1);
+        if ( wq->reduce_ptr[idx] == NULL )
+            continue;
+        /* The end marker goes if the code was thrown away after all */
+        for ( next = end; *next; ) {
+            if ( next[0] == LOOP_MARKER && next[1] == 'E' && atoi(next + 2) == wq->exit )
+                break;
+            if ( (next = strchr(next, '\n')) == NULL )
+                break;
+            next++;
+        }
+        if ( next != NULL && *next ) {
+            gen_load_static(wq->reduce_ptr[idx]);
+            end = strchr(next, '\n');
+            end = end ? end + 1 : next + strlen(next);
+        }
+    }
+    discardbuffer(body);
+}
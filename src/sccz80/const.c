@@ -143,7 +143,7 @@ int fnumber(LVALUE *lval)
         }
     }
     for ( i = 0; i < buffer_fps_num; i++ ) 
-        fprintf(buffer_fps[i], "%.*s", (int)(line+lptr-start), start);
+        bufferstr(buffer_fps[i], start, line+lptr-start);
 
     lval->const_val = dval;
 
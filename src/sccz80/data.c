@@ -86,6 +86,12 @@ FILE    *saveout; /* holds output ptr when diverted to console */
 
 
 SYMBOL  *currfn; /* ptr to symtab entry for current fn. */
+int      currfn_static_locals; /* locals of currfn held in static storage */
+int      currfn_recursive; /* currfn has called itself */
+int      currfn_statements; /* statements parsed in currfn */
+int      decl_inline; /* the declaration being parsed is inline */
+int      loop_stores; /* count of variables assigned */
+int      loop_reducing; /* writing the set up of loop pointers */
 
 
 /*
@@ -107,6 +113,7 @@ int c_double_strings;
  *        Framepointer stuff - tis broken!
  */
 int c_framepointer_is_ix;
+int c_framepointer_auto;
 
 
 int c_use_r2l_calling_convention;
@@ -118,7 +125,7 @@ int c_use_r2l_calling_convention;
 uint32_t scanf_format_option;
 uint32_t printf_format_option;
 
-FILE *buffer_fps[200];
+t_buffer *buffer_fps[200];
 int   buffer_fps_num = 0 ;
 
 struct parser_stack *pstack; /**< Stack of previous saved parsers */
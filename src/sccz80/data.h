@@ -52,15 +52,22 @@ extern FILE *output;
 extern FILE *inpt2;
 extern FILE *saveout;
 extern SYMBOL *currfn;
+extern int currfn_static_locals;
+extern int currfn_recursive;
+extern int currfn_statements;
+extern int decl_inline;
+extern int loop_stores;
+extern int loop_reducing;
 
 extern int debuglevel;
 extern int c_assembler_type;
 extern int c_framepointer_is_ix;
+extern int c_framepointer_auto;
 extern int c_double_strings;
 extern int c_standard_escapecodes;
 extern uint32_t scanf_format_option;
 extern uint32_t printf_format_option;
-extern FILE * buffer_fps[];
+extern struct t_buffer_s *buffer_fps[];
 extern int buffer_fps_num;
 extern struct parser_stack *pstack;
 extern int c_use_r2l_calling_convention;
@@ -70,6 +77,9 @@ extern char *c_bss_section;
 extern char *c_data_section;
 extern char *c_rodata_section;
 extern int c_disable_builtins;
+extern int c_static_locals;
+extern int c_opt_dataflow;
+extern char *c_profile_use;
 extern uint32_t c_speed_optimisation;
 extern int c_fp_size;
 extern int c_fp_fudge_offset;
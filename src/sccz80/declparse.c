@@ -514,6 +514,8 @@ static Type *parse_type(void)
 
     swallow("register");
     swallow("auto");
+    if (swallow("inline") || swallow("__inline") || swallow("__inline__"))
+        decl_inline = 1;
 
     type->len = 1;
     if ( swallow("const")) {
@@ -632,6 +634,9 @@ static void parse_trailing_modifiers(Type *type)
         } else if ( amatch("__critical")) {
             type->flags |= CRITICAL;
             continue;
+        } else if ( amatch("__reentrant")) {
+            type->flags |= REENTRANT;
+            continue;
         } else if ( amatch("__interrupt")) {
             type->flags |= INTERRUPT;
             type->funcattrs.interrupt = -1;  // Not set
@@ -972,9 +977,84 @@ Type *parse_expr_type()
     return type;
 }
 
+/** \brief Check whether an automatic variable is held in static storage
+ *
+ * With --static-locals the locals of functions that aren't __reentrant
+ * are held in static storage and accessed directly. Initialised arrays
+ * and structures are still copied to the stack.
+ */
+static int local_in_static_storage(Type *type)
+{
+    if ( c_static_locals == 0 || currfn == NULL || currfn_recursive )
+        return 0;
+    if ( currfn->ctype->flags & (REENTRANT|NAKED) )
+        return 0;
+    if ( type->kind == KIND_FUNC )
+        return 0;
+    if ( (type->kind == KIND_STRUCT || type->kind == KIND_ARRAY) && rcmatch('=') )
+        return 0;
+    return 1;
+}
+
+/** \brief Declare a register variable
+ *
+ * Int and pointer variables in the outermost block of the function may
+ * be held in ix, see gen_register_variables_end(). Returns 0 to declare
+ * the variable as usual.
+ */
+static int declare_register_local(Type *type)
+{
+    SYMBOL *sym;
+    int     slot;
+
+    if ( ncmp != 1 )
+        return 0;
+    if ( type->kind != KIND_INT && !(type->kind == KIND_PTR && type->ptr->kind != KIND_FUNC) )
+        return 0;
+
+    Zsp = modstk(Zsp - declared, KIND_NONE, NO, YES);
+    declared = 0;
+    if ( (slot = gen_register_variable()) == 0 )
+        return 0;
+    sym = addloc(type->name, type, ID_VARIABLE, type->kind, slot);
+    sym->storage = REGLOC;
+    if ( cmatch('=') ) {
+        Kind expr;
+        Type *expr_type;
+        char *before, *start;
+        int   vconst;
+        zdouble val;
+
+        sym->isassigned = 1;
+        setstage(&before, &start);
+        expr = expression(&vconst, &val, &expr_type);
+
+        if ( expr_type->kind == KIND_VOID ) {
+            warningfmt("void","Assigning from a void expression");
+        }
+
+        check_pointer_namespace(type, expr_type);
+
+        if ( vconst && expr != type->kind ) {
+            // It's a constant that doesn't match the right type
+            LVALUE  lval={0};
+            clearstage(before, 0);
+            lval.ltype = type;
+            lval.val_type = type->kind;
+            lval.const_val = val;
+            load_constant(&lval);
+        } else {
+            clearstage(before, start);
+            force(type->kind, expr, type->isunsigned, expr_type->isunsigned, 0);
+        }
+        gen_store_register(sym);
+    }
+    return 1;
+}
+
 /** \brief Declare a local variableif we need to
  */
-int declare_local(int local_static)
+int declare_local(int local_static, int local_register)
 {
     Type *type;
     Type *base_type = NULL;
@@ -996,6 +1076,48 @@ int declare_local(int local_static)
             } else {
                 sym->bss_section = STRDUP(get_section_name(sym->ctype->namespace, c_bss_section));
             }
+        } else if ( local_register && declare_register_local(type) ) {
+            /* Declared */
+        } else if ( local_in_static_storage(type) ) {
+            char  namebuf[NAMESIZE * 2 + 10];
+            snprintf(namebuf, sizeof(namebuf),"sl_%s_%d_%s", currfn->name, scope_block, type->name);
+            sym = addglb(namebuf, type, ID_VARIABLE, type->kind, 0, LSTATIC);
+            sym->bss_section = STRDUP(get_section_name(sym->ctype->namespace, c_bss_section));
+            addlocstatic(type->name, sym);
+            currfn_static_locals++;
+            if ( cmatch('=')) {
+                Kind expr;
+                Type *expr_type;
+                char *before, *start;
+                int   vconst;
+                zdouble val;
+
+                sym->isassigned = 1;
+                Zsp = modstk(Zsp - declared, KIND_NONE, NO, YES);
+                declared = 0;
+                setstage(&before, &start);
+                expr = expression(&vconst, &val, &expr_type);
+
+                if ( expr_type->kind == KIND_VOID ) {
+                    warningfmt("void","Assigning from a void expression");
+                }
+
+                check_pointer_namespace(type, expr_type);
+
+                if ( vconst && expr != type->kind ) {
+                    // It's a constant that doesn't match the right type
+                    LVALUE  lval={0};
+                    clearstage(before, 0);
+                    lval.ltype = type;
+                    lval.val_type = type->kind;
+                    lval.const_val = val;
+                    load_constant(&lval);
+                } else {
+                    clearstage(before, start);
+                    force(type->kind, expr, type->isunsigned, expr_type->isunsigned, 0);
+                }
+                gen_store_static(sym);
+            }
         } else {
             int size = type->size;
 
@@ -1801,6 +1923,14 @@ static void declfunc(Type *functype, enum storage_type storage)
 
     // Reset all local variables
     locptr = STARTLOC;
+    currfn_static_locals = 0;
+    currfn_recursive = 0;
+    currfn_statements = 0;
+    profile_function_start(currfn);
+    ir_function_start();
+    gen_frame_pointer_start();
+    gen_register_variables_start();
+    inline_function_start(currfn, functype);
     // Setup local variables
     gen_switch_section(c_code_section);
     
@@ -1968,7 +2098,12 @@ static void declfunc(Type *functype, enum storage_type storage)
         /* cleaning up the stack */
         gen_leave_function(KIND_NONE, NO, 0);
     }
+    profile_function_end();
     goto_cleanup();
+    gen_register_variables_end();
+    gen_frame_pointer_end();
+    ir_function_end();
+    inline_function_end(currfn);
     function_appendix(currfn);
 
 #ifdef INBUILT_OPTIMIZER
@@ -156,7 +156,8 @@ enum storage_type {
     EXTERNAL,      /* External to this file */
     EXTERNP,       /* Extern @ */
     LSTATIC,       /* Static to this file */
-    TYPDEF
+    TYPDEF,
+    REGLOC         /* Register variable */
 };
 
 
@@ -179,7 +180,8 @@ enum symbol_flags {
         SHORTCALL_HL = 0x8000,   /* Use ld HL,$addr style of shortcall */
         BANKED = 0x10000,      /* Call via the banked_call function */
         HL_CALL = 0x20000,    /* Call via ld hl, (module) call (addr) */
-        INTERRUPT = 0x40000   /* Function is used for interrupts */
+        INTERRUPT = 0x40000,  /* Function is used for interrupts */
+        REENTRANT = 0x80000   /* Keep locals on the stack with --static-locals */
 };
 
 
@@ -209,6 +211,7 @@ struct symbol_s {
         int  size ;          /* djm, storage reqd! */
         char isconst;        /* Set if const, affects the section the data goes into */
         char isassigned;     /* Set if we have assigned to it once */
+        char isaddressed;    /* Set if its address has been taken */
         char initialised;    /* Initialised at compile time */
         char func_defined;   /* The function has been defined */
         enum symbol_flags flags ;         /* djm, various flags:
@@ -218,6 +221,7 @@ struct symbol_s {
                               */
         int level;           /* Compound level that this variable is declared at */
         int scope_block;     /* Scope block throughout file? */
+        char *inline_body;   /* Return expression of a function that can be expanded inline */
         UT_hash_handle  hh;
 
 };
@@ -255,12 +259,27 @@ struct switchtab_s {
 #define WQMAX           wqueue+(NUMWHILE-1)
 typedef struct whiletab_s WHILE_TAB;
 
+#define NUMREDUCE       4
+
 struct whiletab_s {
         int sp ;                /* stack pointer */
         int loop ;              /* label for top of loop */
         int exit ;              /* label at end of loop */
+        SYMBOL *induction ;     /* for loop variable stepped by one */
+        int step ;              /* and the step, 1 or -1 */
+        SYMBOL *locals ;        /* locptr when the body starts */
+        char unsafe ;           /* body changes the variable, has labels or asm */
+        int nreduce ;           /* subscripts by the variable held in pointers */
+        SYMBOL *reduce_base[NUMREDUCE] ;
+        int reduce_size[NUMREDUCE] ;
+        char reduce_assigned[NUMREDUCE] ;
+        SYMBOL *reduce_ptr[NUMREDUCE] ;
 } ;
 
+/*      Else clauses moved to the end of a function by --profile-use   */
+
+#define NUMCOLD         32
+
 #define NUMGOTO         100
 
 typedef struct gototab_s GOTO_TAB;
@@ -379,6 +398,9 @@ struct parser_stack;
 
 struct parser_stack {
     FILE *sinput;
+    char *sinbuf;         /* copy of the argument buffer being read */
+    char *sinbuf_end;
+    int  seof;
     char sline[LINESIZE]; /* copy of line when swapping out */
     int  slptr;           /* copy of the save line pointer when swapping out */
     int  slineno;
@@ -421,6 +443,11 @@ enum optimisation {
         OPT_UCHAR_MULT     = (1 << 7),
         OPT_DOUBLE_CONST   = (1 << 8),
         OPT_CHAR_COMPARE   = (1 << 9),
+        OPT_SWITCH         = (1 << 10),
+        OPT_INLINE         = (1 << 11),
+        OPT_INDUCTION      = (1 << 12),
+        OPT_COPY           = (1 << 13),
+        OPT_FRAME          = (1 << 14),
 };
 
 enum maths_mode {
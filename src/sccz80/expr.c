@@ -481,7 +481,7 @@ int heira(LVALUE *lval)
             needchar(')');
             cast_lval.cast_type = ctype;
             for ( j = 0; j < save_fps_num; j++ ) {
-                 fprintf(buffer_fps[j],"%.*s",lptr-klptr,line+klptr);
+                 bufferstr(buffer_fps[j],line+klptr,lptr-klptr);
             }
             buffer_fps_num = save_fps_num;
             k = heira(lval);
@@ -554,9 +554,14 @@ int heira(LVALUE *lval)
 
         if (lval->symbol) {
             lval->symbol->isassigned = YES;
+            lval->symbol->isaddressed = YES;
+            loop_assigned(lval->symbol);
         }
         if (lval->indirect_kind)
             return 0;
+        if (lval->symbol->storage == REGLOC) {
+            errorfmt("Cannot take the address of register variable '%s'", 0, lval->symbol->name);
+        }
         /* global & non-array */
         address(lval->symbol);
         lval->indirect_kind = lval->symbol->ctype->kind;
@@ -595,7 +600,13 @@ int heirb(LVALUE* lval)
         while (1) {
             if (cmatch('[')) {
                 Type *type;
+                WHILE_TAB *loop = NULL;
+                SYMBOL *base = lval->symbol;
+                int size = 0, idx;
 
+                /* a[i] with i the variable of a for loop */
+                if (ptr && base == ptr && lval->ltype == ptr->ctype)
+                    loop = loop_subscript(lval, &size);
                 if (k && ispointer(lval->ltype)) {
                     rvalue(lval);
                 } else if ( !ispointer(lval->ltype) && lval->ltype->kind != KIND_ARRAY) {
@@ -669,17 +680,28 @@ int heirb(LVALUE* lval)
                         zpop();
                     }
                     zadd(lval);
+                    if (loop != NULL && (idx = loop_reduce(loop, base, size)) != -1) {
+                        char *code;
+
+                        *stagenext = 0;
+                        code = STRDUP(start1);
+                        clearstage(start1, 0);
+                        gen_loop_pointer(loop, idx, code);
+                        FREENULL(code);
+                    }
                 }
                 ptr = deref(lval, YES);
                 k = lval->ltype->kind == KIND_ARRAY ? 0 : 1;
             } else if (cmatch('(')) {
                 Type *return_type = type_void;
                 int   flags = 0;
+                int   inlined = 0;
+                zdouble inline_val = 0;
                 if ( ispointer(lval->ltype) ) {
                      if (k && lval->const_val == 0)
                         rvalue(lval);
                     // Functino pointer call
-                    callfunction(NULL,lval->ltype);
+                    callfunction(NULL,lval->ltype,NULL);
                     return_type = lval->ltype->ptr->return_type;
                     if ( return_type == NULL ) {
                         return_type = lval->ltype->ptr;
@@ -689,9 +711,9 @@ int heirb(LVALUE* lval)
                     // Normal function call
                     if ( ptr == NULL ) {
                         // However, we've turned it into a function pointer call
-                        callfunction(NULL,make_pointer(lval->ltype));
+                        callfunction(NULL,make_pointer(lval->ltype),NULL);
                     } else {
-                        callfunction(ptr,NULL);
+                        inlined = callfunction(ptr,NULL,&inline_val);
                     }
                     return_type = lval->ltype->return_type;
                     flags = lval->ltype->flags;
@@ -714,6 +736,11 @@ int heirb(LVALUE* lval)
                 lval->ptr_type = KIND_NONE;
                 lval->val_type = lval->ltype->kind;
                 lval->symbol = NULL;
+                if ( inlined ) {
+                    // Expanded inline to a constant
+                    lval->is_const = 1;
+                    lval->const_val = inline_val;
+                }
                 // Function returing pointer
                 if ( lval->ltype->kind == KIND_PTR || lval->ltype->kind == KIND_CPTR ) {
                     lval->val_type = lval->ltype->kind;
@@ -59,6 +59,7 @@ int dolabel()
                 ptr->type = KIND_PTR;
             }
             debug(DBG_GOTO, "Adding label not called %s\n", sname);
+            loop_unsafe();
             ptr->offset.i = Zsp; /* Save stack for label */
             postlabel(ptr->size = getlabel());
             return (1);
@@ -85,6 +86,7 @@ void dogoto()
     if (symname(sname) == 0)
         illname(sname);
     debug(DBG_GOTO, "goto is -->%s<--\n", sname);
+    gen_register_variables_disable();
     if ((ptr = findgoto(sname)) && ptr->ident == ID_GOTOLABEL) {
         /* Label found, but is it actually defined? */
         if (ptr->type == KIND_PTR) {
@@ -118,7 +118,7 @@ t_buffer* startbuffer(size_t blocks)
     size_t  size = blocks * STAGESIZE;
     buf->size = size;
     buf->start = (char*)MALLOC(size);
-    buf->end = buf->start + blocks * size - 1;
+    buf->end = buf->start + size - 1;
     buf->next = buf->start;
     buf->before = currentbuffer; /* <-- DON'T USE NULL HERE TO SUPPRESS WARNING !!  */
     currentbuffer = buf;
@@ -158,17 +158,60 @@ void discardbuffer(t_buffer* buf)
 
 int outbuffer(char c)
 {
-    if (currentbuffer->next == currentbuffer->end) {
-        size_t size = currentbuffer->size * 2;
+    bufferchar(currentbuffer, c);
+    return c;
+}
+
+/* append to a buffer, doubling its size when full */
+void bufferchar(t_buffer* buf, char c)
+{
+    if (buf->next == buf->end) {
+        size_t size = buf->size * 2;
         char* tmp = (char*)MALLOC(size);
-        memcpy(tmp, currentbuffer->start, currentbuffer->size);
-        FREENULL(currentbuffer->start);
-        currentbuffer->next = tmp + (currentbuffer->start - currentbuffer->next);
-        currentbuffer->start = tmp;
-        currentbuffer->end = tmp + size - 1;
-        currentbuffer->size = size;
+        memcpy(tmp, buf->start, buf->size);
+        buf->next = tmp + (buf->next - buf->start);
+        FREENULL(buf->start);
+        buf->start = tmp;
+        buf->end = tmp + size - 1;
+        buf->size = size;
+    }
+    *(buf->next++) = c;
+}
+
+void bufferstr(t_buffer* buf, const char* str, size_t len)
+{
+    while (len-- > 0)
+        bufferchar(buf, *str++);
+}
+
+/* buffers for the source text of function arguments, kept in a pool
+   and reused by the next call */
+
+static t_buffer* bufferpool = NULL;
+
+t_buffer* getbuffer(void)
+{
+    t_buffer* buf = bufferpool;
+
+    if (buf != NULL) {
+        bufferpool = buf->before;
+    } else {
+        buf = (t_buffer*)MALLOC(sizeof(t_buffer));
+        buf->size = STAGESIZE;
+        buf->start = (char*)MALLOC(buf->size);
+        buf->end = buf->start + buf->size - 1;
     }
-    return *(currentbuffer->next++) = c;
+    buf->next = buf->start;
+    buf->before = NULL;
+    return buf;
+}
+
+void releasebuffer(t_buffer* buf)
+{
+    if (buf == NULL)
+        return;
+    buf->before = bufferpool;
+    bufferpool = buf;
 }
 
 /* initialise staging buffer */
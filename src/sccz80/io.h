@@ -43,5 +43,9 @@ extern t_buffer * startbuffer(size_t blocks);
 extern void clearbuffer(t_buffer *buf);
 extern void suspendbuffer(void);
 extern int outbuffer(char c);
+extern void bufferchar(t_buffer *buf, char c);
+extern void bufferstr(t_buffer *buf, const char *str, size_t len);
+extern t_buffer *getbuffer(void);
+extern void releasebuffer(t_buffer *buf);
 extern t_buffer *currentbuffer;
 
@@ -0,0 +1,579 @@
+/*
+ *      Small C+ Compiler
+ *
+ *      Dataflow optimisation of the code of a function
+ *
+ *      With --opt-dataflow the code of each function is collected in a
+ *      buffer and read back as a list of instructions split into basic
+ *      blocks at labels and branches. Within a block the contents of
+ *      the primary (hl) and secondary (de) registers are followed so that:
+ *
+ *      - loading a register with the constant it already holds is dropped
+ *      - loading hl from a local it already holds is dropped
+ *      - a constant load or 16 bit inc/dec whose result is never read is
+ *        dropped
+ *
+ *      and a call to a C function straight before a ret becomes a jp.
+ *
+ *      Anything that isn't understood ends the block and forgets what's
+ *      known, so functions with inline assembler are left alone. Branches
+ *      to ASMPC+N land somewhere in the next N bytes, so the instructions
+ *      they skip are kept as they are and treated as labels.
+ */
+
+#include "ccdefs.h"
+
+#define IR_HL       1
+#define IR_DE       2
+#define IR_ALL      (IR_HL|IR_DE)
+
+/* Other effects of an instruction */
+#define IR_MEM      1       /* Writes memory */
+#define IR_END      2       /* Ends the block */
+#define IR_SP       4       /* Changes sp other than by push/pop */
+#define IR_COND     8       /* Branch is conditional */
+#define IR_SWAP     16      /* ex de,hl */
+
+enum ir_kind {
+    IR_NONE,        /* Blank, comment or C_LINE */
+    IR_LABEL,       /* Label or anything else not an instruction */
+    IR_INSN
+};
+
+typedef struct {
+    char           *text;       /* Line as written */
+    enum ir_kind    kind;
+    char            op[8];      /* Mnemonic */
+    char            dst[64];    /* First operand */
+    char            src[64];    /* Second operand */
+    char            deleted;
+    char            fixed;      /* Skipped by an ASMPC relative branch */
+} ir_insn;
+
+/* What a register is known to hold */
+typedef struct {
+    char            constant[64];   /* Constant or address of a symbol, or empty */
+    char            has_local;      /* Holds the contents of a local... */
+    int             local;          /* ...at this sp offset from the start of the block */
+} ir_reg;
+
+static t_buffer *ir_buffer;
+static int       ir_disabled;
+
+static ir_insn  *ir_code;
+static int       ir_len;
+static int       ir_size;
+
+
+/* Start collecting the code of a function */
+void ir_function_start(void)
+{
+    ir_buffer = NULL;
+    ir_disabled = 0;
+    if ( c_opt_dataflow == 0 || (currfn->ctype->flags & NAKED) )
+        return;
+    ir_buffer = startbuffer(1000);
+}
+
+/* The function has inline assembler */
+void ir_function_asm(void)
+{
+    ir_disabled = 1;
+}
+
+static void ir_trim(char *dest, const char *src, size_t len, size_t size)
+{
+    while ( len > 0 && isspace((unsigned char)src[len - 1]) )
+        len--;
+    while ( len > 0 && isspace((unsigned char)*src) ) {
+        src++;
+        len--;
+    }
+    if ( len >= size )
+        len = size - 1;
+    memcpy(dest, src, len);
+    dest[len] = 0;
+}
+
+static void ir_parse(ir_insn *insn, char *text)
+{
+    char *p, *end, *comma;
+
+    memset(insn, 0, sizeof(*insn));
+    insn->text = text;
+    if ( *text == 0 || *text == ';' ) {
+        insn->kind = IR_NONE;
+        return;
+    }
+    if ( *text != '\t' ) {
+        insn->kind = IR_LABEL;
+        return;
+    }
+    p = text + 1;
+    end = p + strcspn(p, " \t;");
+    if ( end == p || (size_t)(end - p) >= sizeof(insn->op) ) {
+        insn->kind = IR_LABEL;
+        return;
+    }
+    memcpy(insn->op, p, end - p);
+    insn->op[end - p] = 0;
+    if ( strcmp(insn->op, "C_LINE") == 0 ) {
+        insn->kind = IR_NONE;
+        return;
+    }
+    insn->kind = IR_INSN;
+
+    /* Operands up to any comment */
+    p = end + strspn(end, " \t");
+    end = p + strcspn(p, ";");
+    if ( (comma = memchr(p, ',', end - p)) != NULL ) {
+        ir_trim(insn->dst, p, comma - p, sizeof(insn->dst));
+        ir_trim(insn->src, comma + 1, end - comma - 1, sizeof(insn->src));
+    } else {
+        ir_trim(insn->dst, p, end - p, sizeof(insn->dst));
+    }
+}
+
+/* The register pair an operand names, full is set for the whole pair */
+static int ir_regpair(const char *operand, int *full)
+{
+    *full = 1;
+    if ( strcmp(operand, "hl") == 0 )
+        return IR_HL;
+    if ( strcmp(operand, "de") == 0 )
+        return IR_DE;
+    *full = 0;
+    if ( strcmp(operand, "h") == 0 || strcmp(operand, "l") == 0 )
+        return IR_HL;
+    if ( strcmp(operand, "d") == 0 || strcmp(operand, "e") == 0 )
+        return IR_DE;
+    return 0;
+}
+
+/* The registers an operand reads, whether as a value or an address */
+static int ir_reads(const char *operand)
+{
+    int full;
+
+    if ( strcmp(operand, "(hl)") == 0 )
+        return IR_HL;
+    if ( strcmp(operand, "(de)") == 0 )
+        return IR_DE;
+    return ir_regpair(operand, &full);
+}
+
+static int ir_is_constant(const char *operand)
+{
+    if ( strstr(operand, "sp") != NULL )
+        return 0;
+    return isdigit((unsigned char)*operand) || *operand == '-' || *operand == '_' || *operand == '$' ||
+           strncmp(operand, "i_", 2) == 0;
+}
+
+static int ir_match(const char *op, const char *const *list)
+{
+    while ( *list ) {
+        if ( strcmp(op, *list++) == 0 )
+            return 1;
+    }
+    return 0;
+}
+
+/*
+ * Work out the registers an instruction reads (uses), the registers it
+ * writes all of (defs) and any part of (writes) and its other effects,
+ * return the change to sp
+ */
+static int ir_effects(ir_insn *insn, int *uses, int *defs, int *writes, int *flags)
+{
+    static const char *const none[] = { "nop", "rla", "rra", "rlca", "rrca", "cpl", "neg", "ccf", "scf",
+                                        "daa", "di", "ei", "halt", NULL };
+    static const char *const alu[] = { "sub", "and", "or", "xor", "cp", NULL };
+    static const char *const arith[] = { "add", "adc", "sbc", NULL };
+    static const char *const shift[] = { "rl", "rr", "rlc", "rrc", "sla", "sra", "srl", "sll", NULL };
+    static const char *const block[] = { "ldir", "ldi", "lddr", "ldd", "cpir", "cpi", "cpdr", "cpd", NULL };
+    const char *op = insn->op;
+    int reg, full;
+
+    *uses = *defs = *writes = *flags = 0;
+
+    if ( strcmp(op, "ld") == 0 ) {
+        if ( strcmp(insn->dst, "sp") == 0 ) {
+            *uses = ir_reads(insn->src);
+            *flags = IR_SP;
+        } else if ( insn->dst[0] == '(' ) {
+            *uses = ir_reads(insn->dst) | ir_reads(insn->src);
+            *flags = IR_MEM;
+        } else {
+            *uses = ir_reads(insn->src);
+            if ( (reg = ir_regpair(insn->dst, &full)) != 0 ) {
+                *writes = reg;
+                if ( full )
+                    *defs = reg;
+                else
+                    *uses |= reg;
+            }
+        }
+        return 0;
+    } else if ( strcmp(op, "push") == 0 ) {
+        *uses = ir_regpair(insn->dst, &full);
+        return -2;
+    } else if ( strcmp(op, "pop") == 0 ) {
+        *defs = *writes = ir_regpair(insn->dst, &full);
+        return 2;
+    } else if ( strcmp(op, "ex") == 0 ) {
+        if ( strcmp(insn->dst, "de") == 0 && strcmp(insn->src, "hl") == 0 ) {
+            *uses = *defs = *writes = IR_ALL;
+            *flags = IR_SWAP;
+            return 0;
+        } else if ( strcmp(insn->dst, "(sp)") == 0 && strcmp(insn->src, "hl") == 0 ) {
+            *uses = *writes = IR_HL;
+            *flags = IR_MEM;
+            return 0;
+        } else if ( strcmp(insn->dst, "af") == 0 ) {
+            return 0;
+        }
+    } else if ( strcmp(op, "inc") == 0 || strcmp(op, "dec") == 0 ) {
+        if ( strcmp(insn->dst, "sp") == 0 )
+            return op[0] == 'i' ? 1 : -1;
+        if ( insn->dst[0] == '(' ) {
+            *uses = ir_reads(insn->dst);
+            *flags = IR_MEM;
+        } else {
+            *uses = *writes = ir_regpair(insn->dst, &full);
+        }
+        return 0;
+    } else if ( ir_match(op, arith) ) {
+        if ( insn->src[0] == 0 ) {
+            *uses = ir_reads(insn->dst);
+        } else {
+            *uses = ir_reads(insn->dst) | ir_reads(insn->src);
+            *writes = ir_regpair(insn->dst, &full);
+        }
+        return 0;
+    } else if ( ir_match(op, alu) || strcmp(op, "bit") == 0 ) {
+        *uses = ir_reads(insn->dst) | ir_reads(insn->src);
+        return 0;
+    } else if ( ir_match(op, shift) || strcmp(op, "set") == 0 || strcmp(op, "res") == 0 ) {
+        const char *operand = insn->src[0] ? insn->src : insn->dst;
+
+        if ( operand[0] == '(' ) {
+            *uses = ir_reads(operand);
+            *flags = IR_MEM;
+        } else {
+            *uses = *writes = ir_regpair(operand, &full);
+        }
+        return 0;
+    } else if ( ir_match(op, block) ) {
+        *uses = *writes = IR_ALL;
+        *flags = IR_MEM;
+        return 0;
+    } else if ( ir_match(op, none) ) {
+        return 0;
+    } else if ( strcmp(op, "jp") == 0 || strcmp(op, "jr") == 0 ) {
+        *uses = IR_ALL;
+        *flags = IR_END | (insn->src[0] ? IR_COND : 0);
+        return 0;
+    } else if ( strcmp(op, "ret") == 0 ) {
+        *uses = IR_ALL;
+        *flags = IR_END | (insn->dst[0] ? IR_COND : 0);
+        return 0;
+    } else if ( strcmp(op, "djnz") == 0 ) {
+        *uses = IR_ALL;
+        *flags = IR_END | IR_COND;
+        return 0;
+    } else if ( strcmp(op, "call") == 0 && strcmp(insn->dst, "l_gint") == 0 ) {
+        *uses = *defs = *writes = IR_HL;
+        return 0;
+    } else if ( strcmp(op, "call") == 0 && strcmp(insn->dst, "l_pint") == 0 ) {
+        *uses = IR_ALL;
+        *writes = IR_DE;
+        *flags = IR_MEM;
+        return 0;
+    }
+    /* call, rst and anything else */
+    *uses = *defs = *writes = IR_ALL;
+    *flags = IR_MEM | IR_END;
+    return 0;
+}
+
+/* Next instruction after i that's still there */
+static int ir_next(int i)
+{
+    for ( i++; i < ir_len; i++ ) {
+        if ( ir_code[i].deleted == 0 && ir_code[i].kind != IR_NONE )
+            return i;
+    }
+    return -1;
+}
+
+/* Does the instruction read the carry or the other flags left by the one before? */
+static int ir_reads_flags(int i)
+{
+    static const char *const list[] = { "adc", "sbc", "rla", "rra", "rl", "rr", "ccf", "daa", NULL };
+    ir_insn *insn;
+
+    if ( i == -1 || ir_code[i].kind != IR_INSN )
+        return 1;
+    insn = &ir_code[i];
+    if ( ir_match(insn->op, list) || (strcmp(insn->op, "push") == 0 && strcmp(insn->dst, "af") == 0) )
+        return 1;
+    if ( strcmp(insn->op, "jp") == 0 || strcmp(insn->op, "jr") == 0 || strcmp(insn->op, "call") == 0 )
+        return insn->src[0] != 0;
+    if ( strcmp(insn->op, "ret") == 0 )
+        return insn->dst[0] != 0;
+    return 0;
+}
+
+/* ld hl,N ; add hl,sp ; call l_gint loads the local at sp+N, return N */
+static int ir_load_local(int i, int *n, int *last)
+{
+    int j, k;
+
+    if ( strcmp(ir_code[i].op, "ld") || strcmp(ir_code[i].dst, "hl") || !isdigit((unsigned char)ir_code[i].src[0]) )
+        return 0;
+    if ( (j = ir_next(i)) == -1 || strcmp(ir_code[j].op, "add") || strcmp(ir_code[j].dst, "hl") || strcmp(ir_code[j].src, "sp") )
+        return 0;
+    if ( (k = ir_next(j)) == -1 || strcmp(ir_code[k].op, "call") || strcmp(ir_code[k].dst, "l_gint") )
+        return 0;
+    *n = atoi(ir_code[i].src);
+    *last = k;
+    return 1;
+}
+
+static void ir_forget(ir_reg *reg)
+{
+    reg->constant[0] = 0;
+    reg->has_local = 0;
+}
+
+/*
+ * A branch to ASMPC+N can land on any of the next N instructions (each is
+ * at least a byte), so mark them as fixed
+ */
+static void ir_mark_asmpc(void)
+{
+    const char *target;
+    int i, j, n;
+
+    for ( i = 0; i < ir_len; i++ ) {
+        ir_insn *insn = &ir_code[i];
+
+        if ( insn->kind != IR_INSN )
+            continue;
+        if ( (target = strstr(insn->src[0] ? insn->src : insn->dst, "ASMPC")) == NULL )
+            continue;
+        n = target[5] == '+' ? atoi(target + 6) : 0;
+        for ( j = i + 1; j < ir_len && n > 0; j++ ) {
+            if ( ir_code[j].kind != IR_NONE ) {
+                ir_code[j].fixed = 1;
+                n--;
+            }
+        }
+    }
+}
+
+/* Follow constants and locals through hl and de, dropping loads of what's already there */
+static void ir_propagate(void)
+{
+    ir_reg hl, de, tmp;
+    int sp = 0, sp_known = 1;
+    int i, j, n, last, uses, defs, writes, flags;
+    ir_reg *reg;
+
+    ir_forget(&hl);
+    ir_forget(&de);
+    for ( i = 0; i < ir_len; i++ ) {
+        ir_insn *insn = &ir_code[i];
+
+        if ( insn->deleted || insn->kind == IR_NONE )
+            continue;
+        if ( insn->kind == IR_LABEL || insn->fixed ) {
+            ir_forget(&hl);
+            ir_forget(&de);
+            sp = 0;
+            sp_known = 1;
+            if ( insn->kind == IR_LABEL )
+                continue;
+        }
+
+        if ( sp_known && ir_load_local(i, &n, &last) ) {
+            for ( j = i + 1; j <= last && ir_code[j].fixed == 0; j++ )
+                ;
+            if ( j > last && insn->fixed == 0 &&
+                 hl.has_local && hl.local == sp + n && ir_reads_flags(ir_next(last)) == 0 ) {
+                for ( j = i; j <= last; j++ )
+                    ir_code[j].deleted = 1;
+            } else {
+                ir_forget(&hl);
+                hl.has_local = 1;
+                hl.local = sp + n;
+            }
+            i = last;
+            continue;
+        }
+
+        reg = strcmp(insn->dst, "hl") == 0 ? &hl : strcmp(insn->dst, "de") == 0 ? &de : NULL;
+        if ( strcmp(insn->op, "ld") == 0 && reg != NULL && ir_is_constant(insn->src) ) {
+            if ( insn->fixed == 0 && strcmp(reg->constant, insn->src) == 0 ) {
+                insn->deleted = 1;
+            } else {
+                ir_forget(reg);
+                strcpy(reg->constant, insn->src);
+            }
+            continue;
+        }
+
+        sp += ir_effects(insn, &uses, &defs, &writes, &flags);
+        if ( flags & IR_SWAP ) {
+            tmp = hl;
+            hl = de;
+            de = tmp;
+            continue;
+        }
+        if ( writes & IR_HL )
+            ir_forget(&hl);
+        if ( writes & IR_DE )
+            ir_forget(&de);
+        if ( flags & IR_MEM ) {
+            hl.has_local = 0;
+            de.has_local = 0;
+        }
+        if ( flags & IR_SP ) {
+            sp_known = 0;
+            hl.has_local = 0;
+            de.has_local = 0;
+        }
+        if ( sp_known && strcmp(insn->op, "push") == 0 ) {
+            /* The push writes over whatever was popped from there */
+            if ( hl.has_local && hl.local == sp )
+                hl.has_local = 0;
+            if ( de.has_local && de.local == sp )
+                de.has_local = 0;
+            if ( reg != NULL ) {
+                reg->has_local = 1;
+                reg->local = sp;
+            }
+        } else if ( sp_known && strcmp(insn->op, "pop") == 0 && reg != NULL ) {
+            reg->has_local = 1;
+            reg->local = sp - 2;
+        }
+        if ( (flags & IR_END) && (flags & IR_COND) == 0 ) {
+            ir_forget(&hl);
+            ir_forget(&de);
+        }
+    }
+}
+
+/* Drop constant loads and 16 bit inc/dec of registers that are written again before being read */
+static void ir_dead_stores(void)
+{
+    int live = IR_ALL;
+    int i, uses, defs, writes, flags;
+
+    for ( i = ir_len - 1; i >= 0; i-- ) {
+        ir_insn *insn = &ir_code[i];
+
+        if ( insn->deleted || insn->kind == IR_NONE )
+            continue;
+        if ( insn->kind == IR_LABEL ) {
+            live = IR_ALL;
+            continue;
+        }
+        ir_effects(insn, &uses, &defs, &writes, &flags);
+        if ( flags & IR_END ) {
+            live = IR_ALL;
+            continue;
+        }
+        if ( flags & IR_SWAP ) {
+            live = ((live & IR_HL) ? IR_DE : 0) | ((live & IR_DE) ? IR_HL : 0);
+            continue;
+        }
+        if ( insn->fixed ) {
+            live = IR_ALL;
+            continue;
+        }
+        /* These don't change the flags */
+        if ( writes && (writes & live) == 0 && (flags & IR_MEM) == 0 &&
+             ((strcmp(insn->op, "ld") == 0 && defs && ir_is_constant(insn->src)) ||
+              ((strcmp(insn->op, "inc") == 0 || strcmp(insn->op, "dec") == 0) && defs == 0 &&
+               (strcmp(insn->dst, "hl") == 0 || strcmp(insn->dst, "de") == 0))) ) {
+            insn->deleted = 1;
+            continue;
+        }
+        live = (live & ~defs) | uses;
+    }
+}
+
+/* call _func ; ret becomes jp _func for a function that leaves its arguments to the caller */
+static void ir_tail_calls(void)
+{
+    SYMBOL *sym;
+    int i, j;
+
+    for ( i = 0; i < ir_len; i++ ) {
+        ir_insn *insn = &ir_code[i];
+
+        if ( insn->deleted || insn->kind != IR_INSN || strcmp(insn->op, "call") || insn->src[0] || insn->dst[0] != '_' )
+            continue;
+        if ( (j = ir_next(i)) == -1 || strcmp(ir_code[j].op, "ret") || ir_code[j].dst[0] || ir_code[j].fixed )
+            continue;
+        if ( (sym = findglb(insn->dst + 1)) == NULL || sym->ctype->kind != KIND_FUNC )
+            continue;
+        if ( sym->ctype->flags & (CALLEE|SHORTCALL|BANKED|HL_CALL) )
+            continue;
+        /* \tcall\t_func becomes \tjp\t_func in place */
+        insn->text += 2;
+        memcpy(insn->text, "\tjp", 3);
+        ir_code[j].deleted = 1;
+    }
+}
+
+/* Optimise the code of the function and write it out */
+void ir_function_end(void)
+{
+    t_buffer *buf = ir_buffer;
+    char *line, *end;
+    int i;
+
+    if ( buf == NULL )
+        return;
+    ir_buffer = NULL;
+    if ( currentbuffer == buf )
+        suspendbuffer();
+    *buf->next = '\0';
+
+    if ( ir_disabled ) {
+        outstr(buf->start);
+        FREENULL(buf->start);
+        FREENULL(buf);
+        return;
+    }
+
+    ir_len = 0;
+    for ( line = buf->start; *line; line = end ) {
+        if ( (end = strchr(line, '\n')) != NULL )
+            *end++ = '\0';
+        else
+            end = line + strlen(line);
+        if ( ir_len == ir_size ) {
+            ir_size = ir_size ? ir_size * 2 : 256;
+            ir_code = REALLOC(ir_code, ir_size * sizeof(ir_insn));
+        }
+        ir_parse(&ir_code[ir_len++], line);
+    }
+
+    ir_mark_asmpc();
+    ir_propagate();
+    ir_dead_stores();
+    ir_tail_calls();
+
+    for ( i = 0; i < ir_len; i++ ) {
+        if ( ir_code[i].deleted == 0 ) {
+            outstr(ir_code[i].text);
+            outstr("\n");
+        }
+    }
+    FREENULL(buf->start);
+    FREENULL(buf);
+}
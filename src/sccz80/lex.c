@@ -50,7 +50,7 @@ int match(char* lit)
     blanks();
     if ((k = streq(line + lptr, lit))) {
         for ( i = 0; i < buffer_fps_num; i++ )
-             fprintf(buffer_fps[i],"%s",lit);
+             bufferstr(buffer_fps[i],lit,strlen(lit));
         lptr += k;
         return 1;
     }
@@ -65,7 +65,7 @@ int cmatch(char lit)
         errorfmt("Unexpected end of file", 1);
     if (toupper(line[lptr]) == toupper(lit)) {
         for ( i = 0; i < buffer_fps_num; i++ ) {
-             fprintf(buffer_fps[i],"%c",line[lptr]);
+             bufferchar(buffer_fps[i],line[lptr]);
         }
         ++lptr;
         return 1;
@@ -81,7 +81,7 @@ int acmatch(char lit)
         errorfmt("Unexpected end of file", 1);
     if (line[lptr] == lit) {
         for ( i = 0; i < buffer_fps_num; i++ )
-             fprintf(buffer_fps[i],"%c",line[lptr]);
+             bufferchar(buffer_fps[i],line[lptr]);
         ++lptr;
         return 1;
     }
@@ -128,7 +128,7 @@ int amatch_impl(char* lit,int buffer)
         lptr += k;
         if ( buffer ) {
             for ( k = 0; k < buffer_fps_num; k++ ) {
-                fprintf(buffer_fps[k],"%s",lit);
+                bufferstr(buffer_fps[k],lit,strlen(lit));
             }
         }
         return 1;
@@ -38,6 +38,10 @@ int c_notaltreg; /* No alternate registers */
 int c_standard_escapecodes = 0; /* \n = 10, \r = 13 */
 int c_disable_builtins = 0;
 int c_cline_directive = 0;
+int c_function_sections = 0;
+int c_static_locals = 0;
+int c_opt_dataflow = 0;
+char *c_profile_use = NULL;
 int c_cpu = CPU_Z80;
 int c_old_diagnostic_fmt = 0;
 char *c_zcc_opt = "zcc_opt.def";
@@ -119,10 +123,15 @@ static option  sccz80_opts[] = {
     { 0, "dataseg", OPT_STRING|OPT_DOUBLE_DASH, "=<name> Set the data section name", &c_data_section, NULL, 0 },
     { 0, "initseg", OPT_STRING|OPT_DOUBLE_DASH, "=<name> Set the initialisation section name", &c_init_section, NULL, 0 },
     { 0, "gcline", OPT_BOOL, "Generate C_LINE directives", &c_cline_directive, NULL, 0 },
+    { 0, "function-sections", OPT_BOOL|OPT_DOUBLE_DASH, "Allow the linker to remove unused functions (z80asm -gc-sections)", &c_function_sections, NULL, 0 },
     { 0, "opt-code-speed", OPT_FUNCTION|OPT_STRING|OPT_DOUBLE_DASH, "Optimise for speed not size", NULL, opt_code_speed, 0},
+    { 0, "static-locals", OPT_BOOL|OPT_DOUBLE_DASH, "Hold locals of non __reentrant functions in static storage", &c_static_locals, NULL, 0},
+    { 0, "opt-dataflow", OPT_BOOL|OPT_DOUBLE_DASH, "Optimise the register dataflow of each function, register variables included", &c_opt_dataflow, NULL, 0},
+    { 0, "profile-use", OPT_STRING|OPT_DOUBLE_DASH, "=<file> Optimise for the z88dk-ticks profile in <file>", &c_profile_use, NULL, 0},
     { 0, "", OPT_HEADER, "Framepointer configuration (for debugging):", NULL, NULL, 0 },
-    { 0, "frameix", OPT_ASSIGN|OPT_INT, "Use ix as the frame pointer", &c_framepointer_is_ix, NULL, 1},
-    { 0, "frameiy", OPT_ASSIGN|OPT_INT, "Use iy as the frame pointer", &c_framepointer_is_ix, NULL, 0},
+    { 0, "frameix", OPT_ASSIGN|OPT_INT, "Use ix as the frame pointer (register is ignored)", &c_framepointer_is_ix, NULL, 1},
+    { 0, "frameiy", OPT_ASSIGN|OPT_INT, "Use iy as the frame pointer (register is ignored)", &c_framepointer_is_ix, NULL, 0},
+    { 0, "frameauto", OPT_BOOL, "Use ix as the frame pointer in functions where it's smaller and ix isn't holding a register variable", &c_framepointer_auto, NULL, 0},
     { 0, "zcc-opt", OPT_STRING, "Location for zcc_opt.def", &c_zcc_opt, NULL, (intptr_t)(void *)"zcc_opt.def"},
 
     { 0, "", OPT_HEADER, "Error/warning handling:", NULL, NULL, 0 },
@@ -282,6 +291,10 @@ int main(int argc, char** argv)
         WriteDefined("CPU_GBZ80", 1);
     }
 
+    if ( c_profile_use != NULL ) {
+        profile_read(c_profile_use);
+    }
+
     utstring_new(debug_utstr);
     utstring_new(debug2_utstr);
 
@@ -340,6 +353,9 @@ void ccabort()
 void parse()
 {
     while (eof == 0) { /* do until no more input */
+        decl_inline = 0;
+        while (amatch("inline") || amatch("__inline") || amatch("__inline__"))
+            decl_inline = 1;
         if (amatch("extern")) {
             dodeclare(EXTERNAL);
         } else if (amatch("static")) {
@@ -908,6 +924,16 @@ static void opt_code_speed(option *arg, char* val)
             c_speed_optimisation |= OPT_UCHAR_MULT;
         } else if ( strncmp(ptr, "floatconst", 10) == 0 ) {
             c_speed_optimisation |= OPT_DOUBLE_CONST;
+        } else if ( strncmp(ptr, "switch", 6) == 0 ) {
+            c_speed_optimisation |= OPT_SWITCH;
+        } else if ( strncmp(ptr, "inline", 6) == 0 ) {
+            c_speed_optimisation |= OPT_INLINE;
+        } else if ( strncmp(ptr, "induction", 9) == 0 ) {
+            c_speed_optimisation |= OPT_INDUCTION;
+        } else if ( strncmp(ptr, "copy", 4) == 0 ) {
+            c_speed_optimisation |= OPT_COPY;
+        } else if ( strncmp(ptr, "frame", 5) == 0 ) {
+            c_speed_optimisation |= OPT_FRAME;
         }
     } while ( (ptr = strchr(ptr, ',')) != NULL );
 }
@@ -15,6 +15,8 @@ static int        findmac(char *sname);
 
 static int iflevel = 0; /* current #if nest level */
 static int skiplevel = 0; /* level at which #if skipping started */
+static char *inbuf = NULL; /* argument buffer being read, instead of input */
+static char *inbuf_end = NULL;
 
 
 void junk()
@@ -48,7 +50,7 @@ char gch()
     int i;
     if (ch()) {
         for ( i = 0; i < buffer_fps_num; i++ )  {
-            fprintf(buffer_fps[i],"%c", line[lptr]);
+            bufferchar(buffer_fps[i], line[lptr]);
         }
         return line[lptr++];
     }
@@ -71,20 +73,28 @@ char inbyte()
     return gch();
 }
 
+/* Read a character from an argument buffer or from the input file */
+static int input_getc(FILE *unit)
+{
+    if (inbuf != NULL)
+        return inbuf < inbuf_end ? (unsigned char)*inbuf++ : EOF;
+    return getc(unit);
+}
+
 void vinline()
 {
     FILE* unit;
     int k;
 
     while (1) {
-        if (input == NULL)
+        if (input == NULL && inbuf == NULL)
             openin();
         if (eof)
             return;
         if ((unit = inpt2) == NULL)
             unit = input;
         clear();
-        while ((k = getc(unit)) > 0) {
+        while ((k = input_getc(unit)) > 0) {
             if (k == '\n' || k == '\r' || lptr >= LINEMAX)
                 break;
             line[lptr++] = k;
@@ -93,12 +103,16 @@ void vinline()
         if (k != '\r')
             ++lineno; /* read one more line */
         if (k <= 0) {
-            fclose(unit);
-            if (inpt2 != NULL)
-                endinclude();
+            if (inbuf != NULL)
+                eof = 1; /* end of argument, restore_input() continues */
             else {
-                input = 0;
-                eof = 1;
+                fclose(unit);
+                if (inpt2 != NULL)
+                    endinclude();
+                else {
+                    input = 0;
+                    eof = 1;
+                }
             }
         }
         if (lptr) {
@@ -308,7 +322,7 @@ void defmac(char* text)
 }
 
 
-void set_temporary_input(FILE *temp)
+void set_temporary_input(t_buffer *temp)
 {
     struct parser_stack *stack = MALLOC(sizeof(*stack));
     /* Save the current positions */
@@ -316,9 +330,13 @@ void set_temporary_input(FILE *temp)
     stack->slineno = lineno;
     stack->slptr = lptr;
     stack->sinput = input;
+    stack->sinbuf = inbuf;
+    stack->sinbuf_end = inbuf_end;
+    stack->seof = eof;
     stack->next = pstack;
     pstack = stack;
-    input = temp;
+    inbuf = temp->start;
+    inbuf_end = temp->next;
     preprocess();
 }
 
@@ -331,13 +349,16 @@ void restore_input(void)
         lineno = stack->slineno;
         lptr = stack->slptr;
         input = stack->sinput;
+        inbuf = stack->sinbuf;
+        inbuf_end = stack->sinbuf_end;
+        eof = stack->seof;
         FREENULL(stack);
      }
 }
 
-void push_buffer_fp(FILE *fp)
+void push_buffer_fp(t_buffer *buf)
 {
-    buffer_fps[buffer_fps_num++] = fp;
+    buffer_fps[buffer_fps_num++] = buf;
 }
 
 void pop_buffer_fp()
@@ -52,7 +52,17 @@ int primary(LVALUE* lval)
             immedlit(litlab,lval->const_val);
             nl();
             return 0;
-        } else if ((ptr = findloc(sname))) {
+        } else if ((ptr = findloc(sname)) && ptr->storage == REGLOC) {
+            lval->symbol = ptr;
+            lval->ltype = ptr->ctype;
+            lval->indirect_kind = KIND_NONE;
+            lval->val_type = ptr->ctype->kind;
+            lval->flags = ptr->flags;
+            if ( ispointer(lval->ltype) ) {
+                lval->ptr_type = ptr->ctype->ptr->kind;
+            }
+            return (1);
+        } else if (ptr && ptr->storage != LSTATIC) {
             lval->base_offset = getloc(ptr, 0);
             lval->offset = 0;
             lval->symbol = ptr;
@@ -74,10 +84,15 @@ int primary(LVALUE* lval)
             } else
                 return (1);
         }
-        /* djm search for local statics */
-        ptr = findstc(sname);
-        if (!ptr)
-            ptr = findglb(sname);
+        if (ptr) {
+            /* local held in static storage */
+            ptr = ptr->offset.p;
+        } else {
+            /* djm search for local statics */
+            ptr = findstc(sname);
+            if (!ptr)
+                ptr = findglb(sname);
+        }
         if (ptr && ptr->ctype ) {
             if (ptr->ctype->kind != KIND_FUNC && !(ptr->ctype->kind == KIND_PTR && ptr->ctype->ptr->kind == KIND_FUNC) ) {
                 if (ptr->ident == ID_ENUM)
@@ -624,10 +639,14 @@ void store(LVALUE* lval)
         if ( lval->symbol->isassigned )
             errorfmt("Attempt to modify const lvalue \'%s\'",0,lval->symbol->name);
     }
-    if ( lval->symbol ) 
+    if ( lval->symbol ) {
         lval->symbol->isassigned = YES;
+        loop_assigned(lval->symbol);
+    }
     if (lval->symbol && (lval->symbol->type == KIND_PORT8 || lval->symbol->type == KIND_PORT16) ) {
         gen_intrinsic_out(lval->symbol);
+    } else if (lval->symbol && lval->symbol->storage == REGLOC) {
+        gen_store_register(lval->symbol);
     } else if (lval->indirect_kind == KIND_NONE)
         gen_store_static(lval->symbol);
     else
@@ -649,6 +668,9 @@ void smartpush(LVALUE* lval, char* before)
         switch ((lval->symbol->offset.i) - Zsp) {
         case 0:
         case 2:
+            /* A parameter moves if ix is pushed on entry */
+            if ( lval->symbol->offset.i > 0 )
+                gen_frame_pointer_disable();
             if (before)
                 clearstage(before, 0);
             break;
@@ -675,6 +697,7 @@ void smartstore(LVALUE* lval)
             } else {
                 lval->symbol->isassigned = YES;
             }
+            loop_assigned(lval->symbol);
             puttos();
             break;
         case 2:
@@ -683,6 +706,7 @@ void smartstore(LVALUE* lval)
             } else {
                 lval->symbol->isassigned = YES;
             }
+            loop_assigned(lval->symbol);
             put2tos();
             break;
         default:
@@ -699,6 +723,8 @@ void rvalue(LVALUE* lval)
     }
     if (lval->symbol && (lval->symbol->type == KIND_PORT8  || lval->symbol->type == KIND_PORT16) ) {
         gen_intrinsic_in(lval->symbol);
+    } else if (lval->symbol && lval->symbol->storage == REGLOC) {
+        gen_load_register(lval->symbol);
     } else if (lval->symbol && lval->indirect_kind == KIND_NONE) {
         gen_load_static(lval->symbol);
     } else {           
@@ -0,0 +1,199 @@
+/*
+ *      Small C+ Compiler
+ *
+ *      Profile guided optimisation
+ *
+ *      --profile-use reads the profile written by z88dk-ticks -profile,
+ *      made up of lines of tab separated fields:
+ *
+ *          function <name> <instructions> <tstates>
+ *          line <file> <line> <instructions> <tstates>
+ *
+ *      The functions that between them take PROFILE_HOT_PERCENT of the time
+ *      are compiled with all of the --opt-code-speed optimisations, those
+ *      that never ran with none of them. Functions not in the profile keep
+ *      the options given on the command line.
+ *
+ *      In a function that ran, an else clause that never did is moved after
+ *      the end of the function so that the path taken doesn't have to jump
+ *      over it.
+ */
+
+#include "ccdefs.h"
+
+#define PROFILE_HOT_PERCENT     90      /* Share of the time spent in hot functions */
+
+enum profile_temperature {
+    PROFILE_COLD = -1,
+    PROFILE_UNKNOWN,
+    PROFILE_WARM,
+    PROFILE_HOT
+};
+
+typedef struct {
+    char           *key;        /* Function name or file<tab>line */
+    double          count;
+    double          tstates;
+    int             temperature;
+    UT_hash_handle  hh;
+} profile_entry;
+
+static profile_entry *profile_functions;
+static profile_entry *profile_lines;
+
+static int        profile_current;          /* Temperature of the function being compiled */
+static uint32_t   profile_saved_speed;
+static t_buffer  *profile_cold[NUMCOLD];    /* Else clauses moved to the end of the function */
+static int        profile_ncold;
+
+
+static profile_entry *profile_add(profile_entry **table, const char *key)
+{
+    profile_entry *entry;
+
+    HASH_FIND_STR(*table, key, entry);
+    if ( entry == NULL ) {
+        entry = CALLOC(1, sizeof(*entry));
+        entry->key = STRDUP(key);
+        HASH_ADD_KEYPTR(hh, *table, entry->key, strlen(entry->key), entry);
+    }
+    return entry;
+}
+
+static int profile_compare(profile_entry *a, profile_entry *b)
+{
+    if ( a->tstates > b->tstates ) return -1;
+    if ( a->tstates < b->tstates ) return 1;
+    return 0;
+}
+
+void profile_read(const char *filename)
+{
+    profile_entry *entry, *tmp;
+    char           buf[1024], name[1024];
+    double         count, tstates, total, sofar;
+    int            line;
+    FILE          *fp;
+
+    if ( (fp = fopen(filename, "r")) == NULL ) {
+        fprintf(stderr, "Cannot open profile file: %s\n", filename);
+        exit(1);
+    }
+
+    total = 0;
+    while ( fgets(buf, sizeof(buf), fp) != NULL ) {
+        if ( sscanf(buf, "function\t%1023s\t%lf\t%lf", name, &count, &tstates) == 3 ) {
+            entry = profile_add(&profile_functions, name);
+            entry->count += count;
+            entry->tstates += tstates;
+            total += tstates;
+        } else if ( sscanf(buf, "line\t%1023[^\t]\t%d\t%lf\t%lf", name, &line, &count, &tstates) == 4 ) {
+            size_t len = strlen(name);
+
+            snprintf(name + len, sizeof(name) - len, "\t%d", line);
+            entry = profile_add(&profile_lines, name);
+            entry->count += count;
+            entry->tstates += tstates;
+        }
+    }
+    fclose(fp);
+
+    /* The hottest functions up to PROFILE_HOT_PERCENT of the time are hot */
+    HASH_SORT(profile_functions, profile_compare);
+    sofar = 0;
+    HASH_ITER(hh, profile_functions, entry, tmp) {
+        if ( entry->count == 0 ) {
+            entry->temperature = PROFILE_COLD;
+        } else if ( sofar < total * PROFILE_HOT_PERCENT / 100 ) {
+            entry->temperature = PROFILE_HOT;
+        } else {
+            entry->temperature = PROFILE_WARM;
+        }
+        sofar += entry->tstates;
+    }
+}
+
+
+/* Pick the optimisations for a function from its temperature */
+void profile_function_start(SYMBOL *fn)
+{
+    profile_entry *entry;
+    char           name[NAMESIZE + 2];
+
+    profile_current = PROFILE_UNKNOWN;
+    profile_ncold = 0;
+    profile_saved_speed = c_speed_optimisation;
+    if ( profile_functions == NULL ) {
+        return;
+    }
+
+    snprintf(name, sizeof(name), "_%s", fn->name);
+    HASH_FIND_STR(profile_functions, name, entry);
+    if ( entry != NULL ) {
+        profile_current = entry->temperature;
+        if ( profile_current == PROFILE_HOT ) {
+            c_speed_optimisation = ~0;
+        } else if ( profile_current == PROFILE_COLD ) {
+            c_speed_optimisation = 0;
+        }
+    }
+}
+
+/* Place the cold blocks after the code of the function */
+void profile_function_end(void)
+{
+    int   i;
+
+    for ( i = 0; i < profile_ncold; i++ ) {
+        clearbuffer(profile_cold[i]);
+    }
+    profile_ncold = 0;
+    c_speed_optimisation = profile_saved_speed;
+}
+
+/* Test whether none of the lines first to last ran while line did */
+int profile_cold_block(int line, int first, int last)
+{
+    profile_entry *entry;
+    WHILE_TAB     *wq;
+    char           filen[FILENAME_LEN], key[FILENAME_LEN + 20], *ptr;
+
+    if ( profile_lines == NULL || profile_current <= PROFILE_UNKNOWN || profile_ncold == NUMCOLD ) {
+        return 0;
+    }
+    /* The body of a loop with pointers is scanned before it's written */
+    for ( wq = wqueue; wq < wqptr; wq++ ) {
+        if ( wq->induction != NULL ) {
+            return 0;
+        }
+    }
+
+    snprintf(filen, sizeof(filen), "%s", Filename[0] == '\"' ? Filename + 1 : Filename);
+    if ( (ptr = strrchr(filen, '\"')) != NULL ) {
+        *ptr = 0;
+    }
+
+    snprintf(key, sizeof(key), "%s\t%d", filen, line);
+    HASH_FIND_STR(profile_lines, key, entry);
+    if ( entry == NULL || entry->count == 0 ) {
+        return 0;
+    }
+    /* The jump over the block is on the line that the block starts on */
+    if ( last > first ) {
+        first++;
+    }
+    for ( line = first; line <= last; line++ ) {
+        snprintf(key, sizeof(key), "%s\t%d", filen, line);
+        HASH_FIND_STR(profile_lines, key, entry);
+        if ( entry != NULL && entry->count != 0 ) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+/* Keep a cold block to be written at the end of the function */
+void profile_defer(t_buffer *buf)
+{
+    profile_cold[profile_ncold++] = buf;
+}
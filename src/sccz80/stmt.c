@@ -55,7 +55,9 @@ int statement()
 {
     int st;
     int locstatic; /* have we had the static keyword */
+    int locregister; /* have we had the register keyword */
 
+    ++currfn_statements;
     blanks();
     if (lineno != lastline) {
         lastline = lineno;
@@ -70,14 +72,14 @@ int statement()
             dodeclare(EXTERNAL);
             return lastst;
         }
-        /* Ignore the register and auto keywords! */
-        swallow("register");
+        /* Ignore the auto keyword! */
+        locregister = amatch("register");
         swallow("auto");
 
         /* Check to see if specified as static, and also for far and near */
         locstatic = amatch("static");
 
-        if ( declare_local(locstatic) ) {
+        if ( declare_local(locstatic, locregister) ) {
             return lastst;
         }        
         /* not a definition */
@@ -237,7 +239,7 @@ void compound()
         statement(); /* do one */
     --ncmp; /* close current level */
     if (lastst != STRETURN) {
-        modstk(stkstor[ncmp], KIND_NONE, NO, YES); /* delete local variable space */
+        gen_register_variables_leave(KIND_NONE, stkstor[ncmp]); /* delete local variable space */
     }
     Zsp = stkstor[ncmp];
     locptr = savloc; /* delete local symbols */
@@ -282,6 +284,7 @@ void doif()
 {
     int flab1, flab2;
     int testtype;
+    int line = lineno;
     t_buffer *buf;
     
     flab1 = getlabel(); /* get label for false branch */
@@ -317,6 +320,33 @@ void doif()
     } 
     /* an "if...else" statement. */
     flab2 = getlabel();
+    if ( testtype < 0 && c_profile_use != NULL ) {
+        int thenst = lastst;
+        int first = lineno;
+
+        buf = startbuffer(100);
+        statement(); /* 'else' clause */
+        suspendbuffer();
+        if ( profile_cold_block(line, first, lineno) ) {
+            /* It never ran so move it to the end of the function */
+            t_buffer *cold = startbuffer(100);
+            postlabel(flab1);
+            clearbuffer(buf);
+            if (lastst != STRETURN) {
+                gen_jp_label(flab2,1);
+            }
+            suspendbuffer();
+            profile_defer(cold);
+        } else {
+            if (thenst != STRETURN) {
+                gen_jp_label(flab2,1);
+            }
+            postlabel(flab1);
+            clearbuffer(buf);
+        }
+        postlabel(flab2);
+        return;
+    }
     if (lastst != STRETURN) {
         /* if last statement of 'if' was 'return' we needn't skip 'else' code */
         gen_jp_label(flab2,1);
@@ -414,7 +444,9 @@ void dofor()
     int testresult = 1; // Default is true
 
     SYMBOL *savedloc;
-    t_buffer *buf2, *buf3,*buf4;
+    SYMBOL *induction = NULL;
+    int step = 0, stores;
+    t_buffer *buf2, *buf3,*buf4, *body;
 
     addwhile(&wq);
     l_condition = getlabel();
@@ -424,13 +456,14 @@ void dofor()
     needchar('(');
     ++ncmp;
     if (cmatch(';') == 0) {
-        if ( declare_local(0) == 0 ) {
+        if ( declare_local(0, 0) == 0 ) {
             doexpr(); /*         initialization             */
             ns();
         }
         (wqptr-1)->sp = wq.sp = Zsp;
     }
 
+    stores = loop_stores;
     buf2 = startbuffer(1); /* save condition to buf2 */
     if (cmatch(';') == 0) {
         testresult = test(wq.exit, NO); /* expr 2 */
@@ -440,18 +473,35 @@ void dofor()
 
     buf3 = startbuffer(1); /* save modification to buf3 */
     if (cmatch(')') == 0) {
+        if (loop_stores == stores)
+            induction = loop_induction(&step);
         doexpr(); /* expr 3 */
         needchar(')');
     }
     suspendbuffer();
 
     if ( testresult != 0 ) {  /* So it's either true or non-constant */
+        if (induction != NULL) {
+            /* Parse the body first to find the subscripts by the variable */
+            (wqptr-1)->induction = induction;
+            (wqptr-1)->step = step;
+            (wqptr-1)->locals = locptr;
+            body = startbuffer(100);
+            statement();
+            suspendbuffer();
+            gen_loop_pointers_init(wqptr-1, buf2, buf3, body);
+        }
         gen_jp_label(l_condition,1); /*         goto condition             */
         postlabel(wq.loop); /* .loop                              */
         clearbuffer(buf3); /*         modification               */
+        if (induction != NULL)
+            gen_loop_pointers_step(wqptr-1);
         postlabel(l_condition); /* .condition                         */
         clearbuffer(buf2); /*         if (!condition) goto exit  */
-        statement(); /*         statement                  */
+        if (induction != NULL)
+            gen_loop_pointers_body(wqptr-1, body);
+        else
+            statement(); /*         statement                  */
         gen_jp_label(wq.loop,1); /*         goto loop                  */
         postlabel(wq.exit); /* .exit                              */
     } else {
@@ -498,16 +548,18 @@ void doswitch()
     suspendbuffer();
 
     postlabel(endlab);
-    gen_switch_preamble(switch_type->kind);
-    while (swptr < swnext ) {
-        gen_switch_case(switch_type->kind, swptr->value, swptr->label);
-        ++swptr;
+    if ( gen_switch_dispatch(switch_type->kind, switch_type->isunsigned, swptr, swnext - swptr, swdefault ? swdefault : wq.exit) == 0 ) {
+        gen_switch_preamble(switch_type->kind);
+        while (swptr < swnext ) {
+            gen_switch_case(switch_type->kind, swptr->value, swptr->label);
+            ++swptr;
+        }
+        gen_switch_postamble(switch_type->kind);
+        if (swdefault)
+            gen_jp_label(swdefault,1);
+        else
+            gen_jp_label(wq.exit,1);
     }
-    gen_switch_postamble(switch_type->kind);
-    if (swdefault)
-        gen_jp_label(swdefault,1);
-    else
-        gen_jp_label(wq.exit,1);
 
     clearbuffer(buf);
 
@@ -565,7 +617,9 @@ void doreturn(char type)
 
         while (1) {
             setstage(&before, &start);
+            inline_return_start();
             expression(&vconst, &val, &type_ptr);
+            inline_return_end(ch() != ',');
             // If it's a constant and last, clear the load and load as a constant of the right
             // type
             if ( vconst && ch() != ',') {
@@ -660,6 +714,9 @@ void doasmfunc(char wantbr)
     int  lastwasLF = 0;
     if (wantbr)
         needchar('(');
+    loop_unsafe();
+    ir_function_asm();
+    gen_frame_pointer_disable();
 
     outbyte('\t');
     needchar('"');
@@ -695,6 +752,9 @@ void doasmfunc(char wantbr)
 void doasm()
 {
     cmode = 0; /* mark mode as "asm" */
+    loop_unsafe();
+    ir_function_asm();
+    gen_frame_pointer_disable();
 
 #ifdef INBUILT_OPTIMIZER
     generate(); /* Dump queued stuff to be opt'd */
@@ -119,6 +119,31 @@ SYMBOL* addloc(
     return cptr;
 }
 
+/*
+ * Add a local variable held in static storage, the local entry gives
+ * the block scope and refers to the static symbol
+ */
+SYMBOL* addlocstatic(char *sname, SYMBOL *target)
+{
+    SYMBOL* cptr;
+
+    if ((cptr = findloc(sname)) && cptr->level == ncmp ) {
+        multidef(sname);
+        return cptr;
+    }
+    if (locptr >= ENDLOC) {
+        errorfmt("Local symbol table overflow", 1);
+        return 0;
+    }
+    cptr = locptr++;
+    initialise_sym(cptr, sname, target->ident, target->type, LSTATIC);
+    cptr->ctype = target->ctype;
+    cptr->level = ncmp;
+    cptr->scope_block = scope_block;
+    cptr->offset.p = target;
+    return cptr;
+}
+
 
 
 /*
@@ -137,5 +162,6 @@ static void initialise_sym(
     ptr->type = kind;
     ptr->storage = storage;
     ptr->flags = FLAGS_NONE;
+    ptr->isaddressed = 0;
     snprintf(ptr->declared_location, sizeof(ptr->declared_location),"%s:%d", Filename, lineno);
 }
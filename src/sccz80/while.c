@@ -13,6 +13,9 @@ void addwhile(WHILE_TAB* ptr)
     wqptr->sp = ptr->sp = Zsp; /* record stk ptr */
     wqptr->loop = ptr->loop = getlabel(); /* and looping label */
     wqptr->exit = ptr->exit = getlabel(); /* and exit label */
+    wqptr->induction = NULL;
+    wqptr->unsafe = 0;
+    wqptr->nreduce = 0;
     if (wqptr >= WQMAX) {
         errorfmt("Too many active whiles", 1 );
         return;
@@ -35,3 +38,186 @@ WHILE_TAB *readwhile(WHILE_TAB *ptr)
     } else
         return (ptr - 1);
 }
+
+
+/*
+ * Strength reduction of subscripts by the variable of a for loop
+ *
+ * With --opt-code-speed=induction, a[i] where i is stepped by one in the
+ * modification of an enclosing for loop is calculated once before the
+ * loop and held in a pointer that is stepped by the size of an element
+ * along with i. The body is parsed before the loop is written out, so
+ * the code of each such subscript is marked and either replaced by a
+ * load of the pointer or kept, see gen_loop_pointers_init().
+ */
+
+static SYMBOL *loop_symbol(char *sname)
+{
+    SYMBOL *ptr;
+
+    if ((ptr = findloc(sname)) == NULL)
+        ptr = findglb(sname);
+    return ptr;
+}
+
+/* Read a name from the input without consuming it */
+static int loop_peekname(int *pos, char *sname)
+{
+    int k = 0;
+
+    while (line[*pos] == ' ' || line[*pos] == '\t')
+        (*pos)++;
+    if (alpha(line[*pos]) == 0)
+        return 0;
+    while (an(line[*pos])) {
+        if (k < NAMESIZE - 1)
+            sname[k++] = line[*pos];
+        (*pos)++;
+    }
+    sname[k] = 0;
+    while (line[*pos] == ' ' || line[*pos] == '\t')
+        (*pos)++;
+    return 1;
+}
+
+/*
+ * Look at the modification of a for loop, before it's parsed, for
+ * i++, ++i, i--, --i, i += 1 or i -= 1 of an int variable
+ */
+SYMBOL *loop_induction(int *step)
+{
+    char sname[NAMESIZE];
+    int pos, pre = 0;
+    SYMBOL *ptr;
+
+    if ((c_speed_optimisation & OPT_INDUCTION) == 0)
+        return NULL;
+    blanks();
+    pos = lptr;
+    if (strncmp(line + pos, "++", 2) == 0 || strncmp(line + pos, "--", 2) == 0) {
+        pre = line[pos] == '+' ? 1 : -1;
+        pos += 2;
+    }
+    if (loop_peekname(&pos, sname) == 0)
+        return NULL;
+    if (pre) {
+        *step = pre;
+    } else if (strncmp(line + pos, "++", 2) == 0 || strncmp(line + pos, "--", 2) == 0) {
+        *step = line[pos] == '+' ? 1 : -1;
+        pos += 2;
+    } else if (strncmp(line + pos, "+=", 2) == 0 || strncmp(line + pos, "-=", 2) == 0) {
+        *step = line[pos] == '+' ? 1 : -1;
+        pos += 2;
+        while (line[pos] == ' ' || line[pos] == '\t')
+            pos++;
+        if (line[pos] != '1' || an(line[pos + 1]))
+            return NULL;
+        pos++;
+    } else {
+        return NULL;
+    }
+    while (line[pos] == ' ' || line[pos] == '\t')
+        pos++;
+    if (line[pos] != ')')
+        return NULL;
+
+    /* Only a local whose address isn't taken can't be changed behind our back */
+    ptr = loop_symbol(sname);
+    if (ptr == NULL || ptr->ident != ID_VARIABLE || ptr->ctype->kind != KIND_INT || ptr->ctype->isvolatile)
+        return NULL;
+    if ((ptr->storage != STKLOC && ptr->storage != REGLOC) || ptr->isaddressed)
+        return NULL;
+    return ptr;
+}
+
+/*
+ * About to parse a subscript of lval: if it's just the variable of an
+ * enclosing for loop return that loop and the size of an element
+ */
+WHILE_TAB *loop_subscript(LVALUE *lval, int *size)
+{
+    char sname[NAMESIZE];
+    int pos = lptr;
+    SYMBOL *ptr, *base = lval->symbol;
+    Type *type = lval->ltype;
+    WHILE_TAB *wq;
+
+    if (loop_reducing || wqptr == wqueue || base == NULL || base->ident != ID_VARIABLE || base->ctype->isvolatile || lval->offset)
+        return NULL;
+    if (loop_peekname(&pos, sname) == 0 || line[pos] != ']')
+        return NULL;
+    if ((ptr = loop_symbol(sname)) == NULL)
+        return NULL;
+
+    if (type->kind == KIND_PTR) {
+        /* A pointer must stay the same, as for the variable of the loop */
+        if ((base->storage != STKLOC && base->storage != REGLOC) || base->isaddressed)
+            return NULL;
+        if (type->ptr->kind == KIND_FUNC)
+            return NULL;
+        *size = type->ptr->size;
+    } else if (type->kind == KIND_ARRAY) {
+        *size = type->size != -1 ? type->size / type->len : type->ptr->size;
+    } else {
+        return NULL;
+    }
+    if (*size <= 0)
+        return NULL;
+
+    for (wq = wqptr - 1; wq >= wqueue; wq--) {
+        if (wq->induction == ptr) {
+            /* A local of the body has a different value each time round */
+            if (base >= STARTLOC && base < ENDLOC && base >= wq->locals)
+                return NULL;
+            return wq;
+        }
+    }
+    return NULL;
+}
+
+/* Hold the subscript in a pointer, return its index or -1 */
+int loop_reduce(WHILE_TAB *wq, SYMBOL *base, int size)
+{
+    int i;
+
+    for (i = 0; i < wq->nreduce; i++) {
+        if (wq->reduce_base[i] == base && wq->reduce_size[i] == size)
+            return i;
+    }
+    if (wq->nreduce == NUMREDUCE)
+        return -1;
+    wq->reduce_base[i] = base;
+    wq->reduce_size[i] = size;
+    wq->reduce_assigned[i] = 0;
+    wq->reduce_ptr[i] = NULL;
+    wq->nreduce++;
+    return i;
+}
+
+/* A variable is being assigned or having its address taken */
+void loop_assigned(SYMBOL *sym)
+{
+    WHILE_TAB *wq;
+    int i;
+
+    if (sym == NULL)
+        return;
+    loop_stores++;
+    for (wq = wqueue; wq < wqptr; wq++) {
+        if (wq->induction == sym)
+            wq->unsafe = 1;
+        for (i = 0; i < wq->nreduce; i++) {
+            if (wq->reduce_base[i] == sym)
+                wq->reduce_assigned[i] = 1;
+        }
+    }
+}
+
+/* The body has code that can't be followed, eg labels or asm */
+void loop_unsafe(void)
+{
+    WHILE_TAB *wq;
+
+    for (wq = wqueue; wq < wqptr; wq++)
+        wq->unsafe = 1;
+}
@@ -122,7 +122,13 @@ void debug_add_cline(const char *filename, int lineno, int level, int scope_bloc
 
 int debug_find_source_location(int address, const char **filename, int *lineno)
 {
-    while ( clines[address] == NULL && address > 0 ) {
+    return debug_find_source_line(0, address, filename, lineno);
+}
+
+// Find the C line for address without going back beyond start
+int debug_find_source_line(int start, int address, const char **filename, int *lineno)
+{
+    while ( clines[address] == NULL && address > start ) {
         address--;
     }
     if ( clines[address] == NULL) return -1;
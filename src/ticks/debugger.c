@@ -110,6 +110,7 @@ static int cmd_list(int argc, char **argv);
 static int cmd_help(int argc, char **argv);
 static int cmd_quit(int argc, char **argv);
 static void print_hotspots();
+static void write_profile();
 static const char *resolve_to_label(int addr);
 
 
@@ -146,6 +147,7 @@ static int last_hotspot_addr;
 static int last_hotspot_st;
 static int hotspots[65536];
 static int hotspots_t[65536];
+static char *profile_filename = NULL;
 
 static int interact_with_tty = 0;
 
@@ -156,6 +158,7 @@ void debugger_init()
     linenoiseSetCompletionCallback(completion, NULL);
     linenoiseHistoryLoad(HISTORY_FILE); /* Load the history at startup */
     atexit(print_hotspots);
+    atexit(write_profile);
     memset(hotspots, 0, sizeof(hotspots));
     interact_with_tty = isatty(fileno(stdin)) && isatty(fileno(stdout)); // Only colors with active tty
 }
@@ -230,7 +233,7 @@ void debugger()
             printf("%s\n",buf);         // Unchanged in case of non-active tty
     }
 
-    if ( hotspot ) {
+    if ( hotspot || profile_filename ) {
         if ( pc > max_hotspot_addr) {
             max_hotspot_addr = pc;
         }
@@ -923,3 +926,74 @@ static void print_hotspots()
         fclose(fp);
     }
 }
+
+
+/* Counts for a function or a source line in the profile */
+typedef struct {
+    char           *key;
+    long long       count;
+    long long       tstates;
+    UT_hash_handle  hh;
+} profile_entry;
+
+void debugger_profile(const char *filename)
+{
+    profile_filename = strdup(filename);
+}
+
+static profile_entry *profile_add(profile_entry **table, const char *key, int count, int tstates)
+{
+    profile_entry *entry;
+
+    HASH_FIND_STR(*table, key, entry);
+    if ( entry == NULL ) {
+        entry = calloc(1,sizeof(*entry));
+        entry->key = strdup(key);
+        HASH_ADD_KEYPTR(hh, *table, entry->key, strlen(entry->key), entry);
+    }
+    entry->count += count;
+    entry->tstates += tstates;
+    return entry;
+}
+
+// Write the execution counts of each function and C line for sccz80 --profile-use
+static void write_profile()
+{
+    profile_entry *functions = NULL, *lines = NULL, *func = NULL, *entry, *tmp;
+    const char    *name, *filename;
+    char           key[FILENAME_MAX + 20];
+    int            i, start = 0, lineno;
+    FILE          *fp;
+
+    if ( profile_filename == NULL ) return;
+    memory_reset_paging();
+
+    // Walk up memory keeping track of the code symbol each address is part of,
+    // listing every symbol so that functions that never ran can be told apart
+    for ( i = 0; i < 65536; i++ ) {
+        if ( (name = symbol_find_code(i)) != NULL ) {
+            func = profile_add(&functions, name, 0, 0);
+            start = i;
+        }
+        if ( i > max_hotspot_addr || hotspots[i] == 0 || func == NULL ) {
+            continue;
+        }
+        func->count += hotspots[i];
+        func->tstates += hotspots_t[i];
+        if ( debug_find_source_line(start, i, &filename, &lineno) == 0 ) {
+            snprintf(key, sizeof(key), "%s\t%d", filename, lineno);
+            profile_add(&lines, key, hotspots[i], hotspots_t[i]);
+        }
+    }
+
+    if ( (fp = fopen(profile_filename, "w")) != NULL ) {
+        fprintf(fp, "; z88dk-ticks profile\n");
+        HASH_ITER(hh, functions, entry, tmp) {
+            fprintf(fp, "function\t%s\t%lld\t%lld\n", entry->key, entry->count, entry->tstates);
+        }
+        HASH_ITER(hh, lines, entry, tmp) {
+            fprintf(fp, "line\t%s\t%lld\t%lld\n", entry->key, entry->count, entry->tstates);
+        }
+        fclose(fp);
+    }
+}
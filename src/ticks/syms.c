@@ -166,6 +166,19 @@ int symbol_find_lower(int addr, symboltype preferred_type, char *buf, size_t buf
     }
 }
 
+// Find the code symbol that starts at addr, skipping compiler labels
+const char *symbol_find_code(int addr)
+{
+    symbol *sym;
+
+    for ( sym = symbols[addr % 65536]; sym != NULL; sym = sym->next ) {
+        if ( sym->symtype == SYM_ADDRESS && strncmp(sym->name,"i_",2) ) {
+            return sym->name;
+        }
+    }
+    return NULL;
+}
+
 const char *find_symbol(int addr, symboltype preferred_type)
 {
     symbol *sym;
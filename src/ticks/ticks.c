@@ -700,6 +700,7 @@ int main (int argc, char **argv){
     printf("  -mz80n         Emulate a Spectrum Next z80n\n"),
     printf("  -mez80         Emulate an ez80 (z80 mode)\n"),
     printf("  -x <file>      Symbol file to read\n"),
+    printf("  -profile <file> Write function and line counts for sccz80 --profile-use\n"),
     printf("  -ide0 <file>   Set file to be ide device 0\n"),
     printf("  -ide1 <file>   Set file to be ide device 1\n"),
     printf("  -iochar X      Set port X to be character input/output\n"),
@@ -719,7 +720,11 @@ int main (int argc, char **argv){
           memory_model = argv[1];
           break;
         case 'p':
-          pc= strtol(argv[1], NULL, 16);
+          if ( strcmp(&argv[0][1], "profile") == 0 ) {
+            debugger_profile(argv[1]);
+          } else {
+            pc= strtol(argv[1], NULL, 16);
+          }
           break;
         case 's':
           start= strtol(argv[1], NULL, 16);
@@ -121,6 +121,7 @@ extern void      debugger_init();
 extern void      debugger();
 extern void      debugger_write_memory(int addr, uint8_t val);
 extern void      debugger_read_memory(int addr);
+extern void      debugger_profile(const char *filename);
 extern int       disassemble2(int pc, char *buf, size_t buflen, int compact);
 extern void      read_symbol_file(char *filename);
 extern const char     *find_symbol(int addr, symboltype preferred_symtype);
@@ -128,6 +129,7 @@ extern symbol   *find_symbol_byname(const char *name);
 extern int symbol_resolve(char *name);
 extern char **parse_words(char *line, int *argc);
 extern int symbol_find_lower(int addr, symboltype preferred_type, char *buf, size_t buflen);
+extern const char *symbol_find_code(int addr);
 
 extern void memory_init(char *model);
 extern void memory_handle_paging(int port, int value);
@@ -165,6 +167,7 @@ extern void srcfile_display(const char *filename, int start_line, int count, int
 // debug
 extern void debug_add_info_encoded(char *encoded);
 extern int debug_find_source_location(int address, const char **filename, int *lineno);
+extern int debug_find_source_line(int start, int address, const char **filename, int *lineno);
 extern void debug_add_cline(const char *filename, int lineno, int level, int scope, const char *address);
 extern int debug_resolve_source(char *name);
 
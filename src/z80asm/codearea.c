@@ -60,6 +60,7 @@ void Section_init (Section *self)
 	self->section_split = false;
 	self->asmpc = 0;
 	self->asmpc_phase = -1;
+	self->flow_end = -1;
 	self->opcode_size = 0;
 	
 	self->bytes = OBJ_NEW(ByteArray);
@@ -70,6 +71,12 @@ void Section_init (Section *self)
 
 	self->module_start = OBJ_NEW(intArray);
 	OBJ_AUTODELETE( self->module_start ) = false;
+
+	self->saved_origin = self->origin;
+	self->saved_align = self->align;
+	self->saved_origin_found = self->origin_found;
+	self->saved_section_split = self->section_split;
+	self->saved_align_found = self->align_found;
 }
 
 void Section_copy (Section *self, Section *other)	
@@ -279,6 +286,84 @@ static int section_module_size(  Section *section, int module_id )
 int get_cur_module_start( void ) { return section_module_start( g_cur_section, g_cur_module ); }
 int get_cur_module_size(  void ) { return section_module_size(  g_cur_section, g_cur_module ); }
 
+/*-----------------------------------------------------------------------------
+*   remove the bytes from start to end-1, relative to the start of the given
+*	module, from the section; the following modules are moved down
+*----------------------------------------------------------------------------*/
+void remove_module_bytes(Section *section, int module_id, int start, int end)
+{
+	int  last_module_id = get_last_module_id();
+	int addr, size, section_size, i;
+	byte_t *data;
+
+	init_module();
+	size = end - start;
+	if (size <= 0)
+		return;
+
+	(void)section_module_start(section, last_module_id);	/* expand module_start[] */
+
+	addr = section_module_start(section, module_id) + start;
+	section_size = get_section_size(section);
+	xassert(addr + size <= section_size);
+
+	data = ByteArray_item(section->bytes, 0);
+	memmove(data + addr, data + addr + size, section_size - addr - size);
+	ByteArray_set_size(section->bytes, section_size - size);
+
+	for (i = module_id + 1; i <= last_module_id; i++)
+		*(intArray_item(section->module_start, i)) -= size;
+}
+
+/*-----------------------------------------------------------------------------
+*   save the state of all sections at the start of the current module;
+*	restore it and discard the code of the module to assemble it again
+*----------------------------------------------------------------------------*/
+void save_module_sections(void)
+{
+	Section *section;
+	SectionHashElem *iter;
+
+	init_module();
+	for (section = get_first_section(&iter); section != NULL;
+		section = get_next_section(&iter))
+	{
+		section->saved_origin = section->origin;
+		section->saved_align = section->align;
+		section->saved_origin_found = section->origin_found;
+		section->saved_section_split = section->section_split;
+		section->saved_align_found = section->align_found;
+	}
+}
+
+void restore_module_sections(void)
+{
+	Section *section;
+	SectionHashElem *iter;
+
+	init_module();
+	xassert(g_cur_module == get_last_module_id());
+
+	for (section = get_first_section(&iter); section != NULL;
+		section = get_next_section(&iter))
+	{
+		ByteArray_set_size(section->bytes, section_module_start(section, g_cur_module));
+
+		section->origin = section->saved_origin;
+		section->align = section->saved_align;
+		section->origin_found = section->saved_origin_found;
+		section->section_split = section->saved_section_split;
+		section->align_found = section->saved_align_found;
+
+		section->asmpc = 0;
+		section->asmpc_phase = -1;
+		section->flow_end = -1;
+		section->opcode_size = 0;
+	}
+
+	set_cur_section(g_default_section);
+}
+
 /*-----------------------------------------------------------------------------
 *   allocate the addr of each of the sections, concatenating the sections in
 *   consecutive addresses, or starting from a new address if a section
@@ -335,6 +420,7 @@ int new_module_id( void )
 	{
 		section->asmpc = 0;
 		section->asmpc_phase = -1;
+		section->flow_end = -1;
 		section->opcode_size = 0;
 		(void) section_module_start( section, module_id );
 	}
@@ -381,6 +467,22 @@ int get_phased_PC(void)
 	return g_cur_section->asmpc_phase;
 }
 
+void set_opcode_flow(bool falls, int operand_size)
+{
+	init_module();
+	if (falls)
+		g_cur_section->flow_end = -2;
+	else
+		g_cur_section->flow_end = g_cur_section->asmpc + g_cur_section->opcode_size + operand_size;
+}
+
+bool at_flow_end(void)
+{
+	init_module();
+	return g_cur_section->opcode_size == 0 &&
+		(g_cur_section->flow_end == -1 || g_cur_section->asmpc == g_cur_section->flow_end);
+}
+
 static void inc_PC( int num_bytes )
 {
     init_module();
@@ -51,6 +51,9 @@ CLASS( Section )
 									// of the current module, reset to 0 at start
 									// of each module
 	int			 asmpc_phase;		// asmpc within a PHASE/DEPHASE block, -1 otherwise
+	int			 flow_end;			// asmpc after the last opcode if it is an
+									// unconditional jump or return, -1 if no
+									// opcode yet in the module, -2 otherwise
 	int			 opcode_size;		// number of bytes added after last
 									// set_PC() or next_PC()
 	ByteArray	*bytes;				// binary code of section, used to compute 
@@ -58,6 +61,11 @@ CLASS( Section )
 	intArray	*reloc;				// list of addresses in module containg relocable addreses
 	intArray	*module_start;		// at module_addr[ID] is the start offset from
 									// addr of module ID
+	int			 saved_origin;		// origin, align and flags at start of module,
+	int			 saved_align;		// restored to assemble the module again
+	bool		 saved_origin_found : 1;
+	bool		 saved_section_split : 1;
+	bool		 saved_align_found : 1;
 END_CLASS;
 
 CLASS_HASH( Section );
@@ -112,6 +120,15 @@ extern void set_cur_module_id( int module_id );
 extern int get_cur_module_start( void );
 extern int get_cur_module_size( void );
 
+/* remove the bytes from start to end-1, relative to the start of the given module,
+   from the section; the following modules are moved down */
+extern void remove_module_bytes(Section *section, int module_id, int start, int end);
+
+/* save the state of all sections at the start of the current module;
+   restore it and discard the code of the module to assemble it again */
+extern void save_module_sections(void);
+extern void restore_module_sections(void);
+
 /*-----------------------------------------------------------------------------
 *   Handle ASMPC
 *	set_PC() defines the instruction start address
@@ -123,6 +140,11 @@ extern int next_PC( void );
 extern int get_PC(void);
 extern int get_phased_PC(void);
 
+/* tell if the opcode being added, followed by operand_size bytes, runs into
+   the next one; check if no code runs into ASMPC */
+extern void set_opcode_flow(bool falls, int operand_size);
+extern bool at_flow_end(void);
+
 /*-----------------------------------------------------------------------------
 *   patch a value at a position, or append to the end of the code area
 *	the patch address is relative to current module and current section
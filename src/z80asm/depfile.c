@@ -0,0 +1,248 @@
+/*
+Z88DK Z80 Macro Assembler
+
+Copyright (C) Paulo Custodio, 2011-2020
+License: The Artistic License 2.0, http://www.perlfoundation.org/artistic_license_2_0
+Repository: https://github.com/z88dk/z88dk
+
+Dependency files (-MD) and content checks for -d.
+*/
+
+#include "depfile.h"
+#include "fileutil.h"
+#include "init.h"
+#include "options.h"
+#include "strutil.h"
+#include "symtab.h"
+#include "utstring.h"
+#include "zutils.h"
+#include <inttypes.h>
+#include <stdint.h>
+
+#define DEPFILE_HASH	"# z80asm-hash: "
+
+static argv_t *g_deps;				/* files read by the module */
+
+/*-----------------------------------------------------------------------------
+*   Initialize and Terminate module
+*----------------------------------------------------------------------------*/
+DEFINE_init_module()
+{
+	g_deps = argv_new();
+}
+
+DEFINE_dtor_module()
+{
+	argv_free(g_deps);
+}
+
+/*-----------------------------------------------------------------------------
+*   collect files
+*----------------------------------------------------------------------------*/
+void depfile_start(void)
+{
+	init_module();
+	argv_clear(g_deps);
+}
+
+void depfile_add(const char *filename)
+{
+	init_module();
+	filename = path_canon(filename);
+	for (char **p = argv_front(g_deps); *p; p++) {
+		if (strcmp(*p, filename) == 0)
+			return;						/* already listed, e.g. -relax pass */
+	}
+	argv_push(g_deps, filename);
+}
+
+/*-----------------------------------------------------------------------------
+*   FNV-1a hash of the files, the -D defines and the options
+*	return false if a file cannot be read
+*----------------------------------------------------------------------------*/
+#define FNV_OFFSET	UINT64_C(14695981039346656037)
+#define FNV_PRIME	UINT64_C(1099511628211)
+
+static uint64_t hash_bytes(uint64_t hash, const void *data, size_t size)
+{
+	const byte_t *p = (const byte_t *)data;
+
+	while (size-- > 0) {
+		hash ^= *p++;
+		hash *= FNV_PRIME;
+	}
+	return hash;
+}
+
+static uint64_t hash_cstr(uint64_t hash, const char *str)
+{
+	return hash_bytes(hash, str, strlen(str) + 1);	/* include terminator */
+}
+
+static uint64_t hash_int(uint64_t hash, long value)
+{
+	char buffer[32];
+
+	snprintf(buffer, sizeof(buffer), "%ld", value);
+	return hash_cstr(hash, buffer);
+}
+
+static bool hash_file(uint64_t *hash, const char *filename)
+{
+	byte_t buffer[0x4000];
+	size_t size;
+	FILE *fp;
+
+	fp = fopen(filename, "rb");
+	if (!fp)
+		return false;
+
+	*hash = hash_cstr(*hash, filename);
+	while ((size = fread(buffer, 1, sizeof(buffer), fp)) > 0)
+		*hash = hash_bytes(*hash, buffer, size);
+
+	fclose(fp);
+	return true;
+}
+
+static bool hash_module(uint64_t *hash, argv_t *deps)
+{
+	SymbolHashElem *iter;
+	Symbol *sym;
+
+	*hash = FNV_OFFSET;
+
+	for (char **p = argv_front(deps); *p; p++) {
+		if (!hash_file(hash, *p))
+			return false;
+	}
+
+	/* -D defines, including the ones defined by the CPU options */
+	for (iter = SymbolHash_first(static_symtab); iter; iter = SymbolHash_next(iter)) {
+		sym = (Symbol *)iter->value;
+		*hash = hash_cstr(*hash, sym->name);
+		*hash = hash_int(*hash, sym->value);
+	}
+
+	/* options that change the object code */
+	*hash = hash_int(*hash, opts.cpu);
+	*hash = hash_int(*hash, opts.swap_ix_iy);
+	*hash = hash_int(*hash, opts.opt_speed);
+	*hash = hash_int(*hash, opts.relax);
+	*hash = hash_int(*hash, opts.ti83plus);
+	*hash = hash_int(*hash, opts.debug_info);
+	*hash = hash_int(*hash, opts.filler);
+
+	return true;
+}
+
+/*-----------------------------------------------------------------------------
+*   write the dependency file
+*----------------------------------------------------------------------------*/
+static void write_escaped(const char *filename, FILE *fp)
+{
+	for (const char *p = filename; *p; p++) {
+		switch (*p) {
+		case ' ':  fputs("\\ ", fp); break;
+		case '#':  fputs("\\#", fp); break;
+		case '$':  fputs("$$", fp); break;
+		default:   fputc(*p, fp);
+		}
+	}
+}
+
+void depfile_write(const char *src_filename, const char *obj_filename)
+{
+	uint64_t hash;
+	FILE *fp;
+
+	init_module();
+
+	fp = xfopen(get_dep_filename(src_filename), "w");
+
+	write_escaped(path_canon(obj_filename), fp);
+	fputc(':', fp);
+	for (char **p = argv_front(g_deps); *p; p++) {
+		fputc(' ', fp);
+		write_escaped(*p, fp);
+	}
+	fputc('\n', fp);
+
+	if (hash_module(&hash, g_deps))
+		fprintf(fp, DEPFILE_HASH "%016" PRIx64 "\n", hash);
+
+	xfclose(fp);
+}
+
+/*-----------------------------------------------------------------------------
+*   read the dependency file and check the hash
+*----------------------------------------------------------------------------*/
+static void read_deps(const char *line, argv_t *deps)
+{
+	UT_string *name;
+	const char *p;
+
+	/* skip target */
+	p = strstr(line, ": ");
+	if (!p)
+		return;
+	p++;
+
+	name = utstr_new();
+	for (;;) {
+		while (*p == ' ')
+			p++;
+		if (*p == '\0')
+			break;
+
+		utstr_clear(name);
+		while (*p != '\0' && *p != ' ') {
+			if (p[0] == '\\' && (p[1] == ' ' || p[1] == '#'))
+				p++;
+			else if (p[0] == '$' && p[1] == '$')
+				p++;
+			utstr_append_n(name, p++, 1);
+		}
+		argv_push(deps, utstr_body(name));
+	}
+	utstr_free(name);
+}
+
+bool depfile_up_to_date(const char *src_filename)
+{
+	UT_string *line;
+	argv_t *deps;
+	uint64_t hash, file_hash = 0;
+	bool has_hash = false;
+	FILE *fp;
+
+	init_module();
+
+	fp = fopen(get_dep_filename(src_filename), "r");
+	if (!fp)
+		return false;
+
+	line = utstr_new();
+	deps = argv_new();
+
+	if (utstr_fgets(line, fp)) {
+		utstr_chomp(line);
+		read_deps(utstr_body(line), deps);
+
+		if (utstr_fgets(line, fp) &&
+			strncmp(utstr_body(line), DEPFILE_HASH, strlen(DEPFILE_HASH)) == 0 &&
+			sscanf(utstr_body(line) + strlen(DEPFILE_HASH), "%" SCNx64, &file_hash) == 1)
+			has_hash = true;
+	}
+	fclose(fp);
+
+	bool up_to_date = has_hash &&
+		argv_len(deps) > 0 &&
+		hash_module(&hash, deps) &&
+		hash == file_hash;
+
+	argv_free(deps);
+	utstr_free(line);
+
+	return up_to_date;
+}
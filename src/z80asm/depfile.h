@@ -0,0 +1,31 @@
+/*
+Z88DK Z80 Macro Assembler
+
+Copyright (C) Paulo Custodio, 2011-2020
+License: The Artistic License 2.0, http://www.perlfoundation.org/artistic_license_2_0
+Repository: https://github.com/z88dk/z88dk
+
+Dependency files (-MD) and content checks for -d.
+The dependency file lists, in make syntax, the source file and every file
+read by INCLUDE and BINARY, followed by a comment with a hash of the
+contents of these files, the -D defines and the options that change the
+object code. With -d the module is assembled again if the hash of the
+listed files no longer matches.
+*/
+
+#pragma once
+
+#include "types.h"
+
+/* start collecting the files read by a new module */
+extern void depfile_start(void);
+
+/* add a file read by the module */
+extern void depfile_add(const char *filename);
+
+/* write the dependency file of the module just assembled */
+extern void depfile_write(const char *src_filename, const char *obj_filename);
+
+/* check the dependency file of the source file; return true if it exists
+   and the hash of the files it lists is unchanged */
+extern bool depfile_up_to_date(const char *src_filename);
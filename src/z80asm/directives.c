@@ -10,6 +10,7 @@ Assembly directives.
 */
 
 #include "codearea.h"
+#include "depfile.h"
 #include "die.h"
 #include "directives.h"
 #include "errors.h"
@@ -22,6 +23,7 @@ Assembly directives.
 #include "types.h"
 #include "utstring.h"
 #include "z80asm.h"
+#include "../zx0/pack.h"
 
 static void check_org_align();
 
@@ -38,6 +40,18 @@ void asm_LABEL_offset(const char* name, int offset)
 		sym = define_symbol(name, get_PC() + offset, TYPE_ADDRESS);
 
 	sym->is_touched = true;
+
+	/* tell -gc-sections that the code before the label does not fall into it;
+	   written to the object file only if the label is global */
+	if (sym->type == TYPE_ADDRESS && offset == 0 && at_flow_end() &&
+		find_local_symbol(GC_SPLIT_KW) != NULL) {
+		STR_DEFINE(marker, STR_SIZE);
+
+		Str_sprintf(marker, "%s%s", GC_NOFALL_KW, name);
+		define_symbol(Str_data(marker), get_PC(), TYPE_ADDRESS);
+
+		STR_DELETE(marker);
+	}
 }
 
 void asm_LABEL(const char* name)
@@ -96,6 +110,7 @@ static int DEFVARS_GLOBAL_PC;	/* DEFVARS address counter for global structs
 static int DEFVARS_STRUCT_PC;	/* DEFVARS address counter for zero based structs
 								*  restared on each DEFVARS 0 */
 static int* DEFVARS_PC = &DEFVARS_STRUCT_PC;	/* select current DEFVARS PC*/
+static int DEFVARS_SAVED[3];	/* DEFVARS context at start of module */
 
 /* start a new DEFVARS context, closing any previously open one */
 void asm_DEFVARS_start(int start_addr)
@@ -116,6 +131,22 @@ void asm_DEFVARS_start(int start_addr)
 		error_int_range(start_addr);
 }
 
+/* save the DEFVARS context at the start of a module, restore it to assemble
+   the module again */
+void asm_DEFVARS_save(void)
+{
+	DEFVARS_SAVED[0] = DEFVARS_GLOBAL_PC;
+	DEFVARS_SAVED[1] = DEFVARS_STRUCT_PC;
+	DEFVARS_SAVED[2] = (DEFVARS_PC == &DEFVARS_GLOBAL_PC);
+}
+
+void asm_DEFVARS_restore(void)
+{
+	DEFVARS_GLOBAL_PC = DEFVARS_SAVED[0];
+	DEFVARS_STRUCT_PC = DEFVARS_SAVED[1];
+	DEFVARS_PC = DEFVARS_SAVED[2] ? &DEFVARS_GLOBAL_PC : &DEFVARS_STRUCT_PC;
+}
+
 /* define one constant in the current context */
 void asm_DEFVARS_define_const(const char* name, int elem_size, int count)
 {
@@ -217,11 +248,43 @@ void asm_BINARY(const char* filename)
 		error_read_file(filename);
 	}
 	else {
+		depfile_add(filename);
 		append_file_contents(binfile, -1);		/* read binary code */
 		xfclose(binfile);
 	}
 }
 
+/* BINARY "file", zx0 - compressed as it is included */
+void asm_BINARY_packed(const char* filename, int method)
+{
+	byte_t* data;
+	byte_t* packed;
+	long size;
+
+	filename = path_search(filename, opts.inc_path);
+	FILE* binfile = fopen(filename, "rb");
+	if (!binfile) {
+		error_read_file(filename);
+	}
+	else {
+		depfile_add(filename);
+
+		fseek(binfile, 0, SEEK_END);
+		size = ftell(binfile);
+		fseek(binfile, 0, SEEK_SET);
+		data = m_malloc(size > 0 ? size : 1);
+		xfread_bytes(data, size, binfile);
+		xfclose(binfile);
+
+		packed = pack(method, data, size, &size);
+		if (packed) {
+			memcpy(append_reserve(size), packed, size);
+			free(packed);
+		}
+		m_free(data);
+	}
+}
+
 /*-----------------------------------------------------------------------------
 *   directives with name argument
 *----------------------------------------------------------------------------*/
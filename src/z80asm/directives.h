@@ -31,6 +31,11 @@ extern void asm_cond_LABEL(Str* label);		// define label if not empty
 /* start a new DEFVARS context, closing any previously open one */
 extern void asm_DEFVARS_start(int start_addr);
 
+/* save the DEFVARS context at the start of a module, restore it to assemble
+   the module again */
+extern void asm_DEFVARS_save(void);
+extern void asm_DEFVARS_restore(void);
+
 /* define one constant in the current context */
 extern void asm_DEFVARS_define_const(const char* name, int elem_size, int count);
 
@@ -53,6 +58,7 @@ extern void asm_DEPHASE();
 /* directives with string argument */
 extern void asm_INCLUDE(const char* filename);
 extern void asm_BINARY(const char* filename);
+extern void asm_BINARY_packed(const char* filename, int method);
 
 /* directives with name argument */
 extern void asm_MODULE(const char* name);
@@ -33,6 +33,15 @@ void error_include_recursion(const char *filename)
 	
 	STR_DELETE(msg);
 }
+void error_unknown_compression(const char *method)
+{
+	STR_DEFINE(msg, STR_SIZE);
+
+	Str_append_sprintf( msg, "unknown compression method '%s'", method );
+	do_error( ErrError, Str_data(msg) );
+	
+	STR_DELETE(msg);
+}
 void error_no_src_file(void)
 {
 	STR_DEFINE(msg, STR_SIZE);
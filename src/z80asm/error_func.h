@@ -5,6 +5,7 @@
 extern void error_read_file(const char *filename);
 extern void error_write_file(const char *filename);
 extern void error_include_recursion(const char *filename);
+extern void error_unknown_compression(const char *method);
 extern void error_no_src_file(void);
 extern void error_illegal_option(const char *option);
 extern void error_glob(const char *filename, const char *error);
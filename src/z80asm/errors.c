@@ -43,6 +43,16 @@ typedef struct ErrorFile
 
 static ErrorFile error_file;		/* currently open error file */
 
+
+typedef struct HeldErrors
+{
+	bool		 holding;			/* true while messages are held */
+	int			 count;				/* error count when hold started */
+	UT_string	*msgs;				/* held messages */
+} HeldErrors;
+
+static HeldErrors held_errors;		/* messages of a pass that may be repeated */
+
 /*-----------------------------------------------------------------------------
 *   Initialize and Terminate module
 *----------------------------------------------------------------------------*/
@@ -58,6 +68,12 @@ DEFINE_init_module()
 
 DEFINE_dtor_module()
 {
+	/* output any held messages */
+	release_errors(true);
+	if (held_errors.msgs != NULL)
+		utstring_free(held_errors.msgs);
+	held_errors.msgs = NULL;
+
     /* close error file, delete it if no errors */
     close_error_file();
 }
@@ -167,6 +183,40 @@ static void puts_error_file( char *string )
         fputs( string, error_file.file );
 }
 
+/*-----------------------------------------------------------------------------
+*	Hold messages of an assembly pass that may be repeated
+*----------------------------------------------------------------------------*/
+void hold_errors( void )
+{
+	init_module();
+
+	if (held_errors.msgs == NULL)
+		utstring_new(held_errors.msgs);
+	else
+		utstring_clear(held_errors.msgs);
+
+	held_errors.holding = true;
+	held_errors.count = errors.count;
+}
+
+void release_errors( bool output )
+{
+	init_module();
+
+	if (!held_errors.holding)
+		return;
+	held_errors.holding = false;
+
+	if (output) {
+		fputs(utstring_body(held_errors.msgs), stderr);
+		puts_error_file(utstring_body(held_errors.msgs));
+	}
+	else {
+		errors.count = held_errors.count;	/* pass is repeated */
+	}
+	utstring_clear(held_errors.msgs);
+}
+
 /*-----------------------------------------------------------------------------
 *   Output error message
 *----------------------------------------------------------------------------*/
@@ -216,11 +266,16 @@ void do_error( enum ErrType err_type, char *message )
     Str_append( msg, message );
     Str_append_char( msg, '\n' );
 
-    /* CH_0001 : Assembly error messages should appear on stderr */
-    fputs( Str_data(msg), stderr );
+    if ( held_errors.holding )
+        utstring_bincpy( held_errors.msgs, Str_data(msg), Str_len(msg) );
+    else
+    {
+        /* CH_0001 : Assembly error messages should appear on stderr */
+        fputs( Str_data(msg), stderr );
 
-    /* send to error file */
-    puts_error_file( Str_data(msg) );
+        /* send to error file */
+        puts_error_file( Str_data(msg) );
+    }
 
     if ( err_type == ErrError )
         errors.count++;		/* count number of errors */
@@ -12,6 +12,7 @@ Error handling.
 #pragma once
 
 #include "error_func.h"
+#include "types.h"
 #include <stdio.h>
 
 enum ErrType { ErrInfo, ErrWarn, ErrError };
@@ -47,6 +48,13 @@ extern int  get_num_errors( void );
 extern void open_error_file(const char *src_filename );
 extern void close_error_file( void );   /* deletes the file if no errors */
 
+/*-----------------------------------------------------------------------------
+*	Hold messages of an assembly pass that may be repeated; release them
+*	to output, or discard them and the error count of the pass
+*----------------------------------------------------------------------------*/
+extern void hold_errors( void );
+extern void release_errors( bool output );
+
 /*-----------------------------------------------------------------------------
 *   Execute an error
 *----------------------------------------------------------------------------*/
@@ -21,6 +21,8 @@ Repository: https://github.com/z88dk/z88dk
 #include "strutil.h"
 #include "sym.h"
 #include "symbol.h"
+#include "utarray.h"
+#include "uthash.h"
 #include "utstring.h"
 #include "z80asm.h"
 #include "zutils.h"
@@ -31,22 +33,37 @@ Repository: https://github.com/z88dk/z88dk
 #include <stdlib.h>
 #include <string.h>
 
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
 // list of objects/libraries to search during linking
 typedef struct obj_file_t {
 	struct obj_file_t* next, *prev;		// doubly linked list
 	const char*		filename;			// library file name (strpool)
 	int				size;				// size of library file
 	byte_t*			data;				// contents of library file, loaded before linking
+	bool			mapped;				// data is mapped to the file, read-only
 	int				i;					// point to next position to parse
 	Module*			module;				// weak pointer to main module information, if object file
 } obj_file_t;
 
 
 /* local functions */
-static void link_lib_module(const char* modname, obj_file_t* obj, StrHash* extern_syms);
+static void link_lib_module(const char* modname, obj_file_t* obj, const char* symbol_name,
+	StrHash* extern_syms);
 static void merge_modules(StrHash* extern_syms);
 static void object_module_append(obj_file_t* obj, Module* module);
 static void obj_files_free(obj_file_t** plist);
+static bool gc_relocate_expr(Module* module, const char* section_name, const char* target_name,
+	int* p_asmpc, int* p_code_pos);
+static void gc_free(void);
+static void link_trace_add(Module* module, const char* lib_filename, const char* symbol_name,
+	Module* referrer);
+static void link_trace_free(void);
+static void write_why_linked_file(void);
 void CreateBinFile(void);
 
 /* global variables */
@@ -56,12 +73,17 @@ extern char* reloctable, * relocptr;
 
 int totaladdr, curroffset;
 
+static int sym_first(int c) { return c == '_' || isalpha(c); }
+static int sym_next(int c) { return c == '_' || isalnum(c); }
+
 static obj_file_t*	g_objects;				// list of objects to link
 static obj_file_t*	g_libraries;			// list of libraries to link
 
 static void dtor(void) {
 	obj_files_free(&g_objects);
 	obj_files_free(&g_libraries);
+	gc_free();
+	link_trace_free();
 }
 
 static void init(void) {
@@ -155,24 +177,49 @@ static void obj_files_append(obj_file_t** plist, const char* filename, Module* m
 	obj->module = module;
 }
 
+// map the file to memory, so that only the pages of the modules parsed and
+// linked are read; read the whole file if mapping is not available
+static bool obj_file_read_data(obj_file_t* obj) {
+	obj->size = file_size(obj->filename);
+	if (obj->size < 0) {
+		error_read_file(obj->filename);
+		return false;
+	}
+
+#ifndef _WIN32
+	if (obj->size > 0) {
+		int fd = open(obj->filename, O_RDONLY);
+		if (fd >= 0) {
+			void* data = mmap(NULL, obj->size, PROT_READ, MAP_PRIVATE, fd, 0);
+			close(fd);
+			if (data != MAP_FAILED) {
+				obj->data = (byte_t*)data;
+				obj->mapped = true;
+				return true;
+			}
+		}
+	}
+#endif
+
+	obj->data = xmalloc(obj->size);
+	obj->mapped = false;
+	FILE* fp = fopen(obj->filename, "rb");
+	if (!fp){
+		error_read_file(obj->filename);
+		return false;
+	}
+	xfread(obj->data, 1, obj->size, fp);
+	fclose(fp);
+
+	return true;
+}
+
 static bool obj_files_read_data(obj_file_t** plist) {
 	init();
 
 	for (obj_file_t* obj = *plist; obj; obj = obj->next) {
-		obj->size = file_size(obj->filename);
-		if (obj->size < 0) {
-			error_read_file(obj->filename);
-			return false;
-		}
-
-		obj->data = xmalloc(obj->size);
-		FILE* fp = fopen(obj->filename, "rb");
-		if (!fp){
-			error_read_file(obj->filename);
+		if (!obj_file_read_data(obj))
 			return false;
-		}
-		xfread(obj->data, 1, obj->size, fp);
-		fclose(fp);
 	}
 
 	return true;
@@ -182,7 +229,12 @@ static void obj_files_free(obj_file_t** plist) {
 	while (*plist) {
 		obj_file_t* elem = *plist;
 		DL_DELETE(*plist, elem);
-		xfree(elem->data);
+#ifndef _WIN32
+		if (elem->mapped)
+			munmap(elem->data, elem->size);
+		else
+#endif
+			xfree(elem->data);
 		xfree(elem);
 	}
 }
@@ -346,6 +398,10 @@ static void read_cur_module_exprs(ExprList* exprs, obj_file_t* obj) {
 		const char* target_name = parse_bcount_str(obj);
 		const char* expr_text_1 = parse_wcount_str(obj);
 
+		// skip expressions of code removed by -gc-sections, move the others
+		if (!gc_relocate_expr(CURRENTMODULE, section_name, target_name, &asmpc, &code_pos))
+			continue;
+
 		// call parser to interpret expression followed by newline
 		utstring_clear(expr_text_2);
 		utstring_printf(expr_text_2, "%s\n", expr_text_1);
@@ -761,7 +817,7 @@ static bool linked_module(obj_file_t* obj, StrHash* extern_syms) {
 
 			// link module if one defined symbol matches pending externals
 			if (scope == 'G' && StrHash_exists(extern_syms, symbol_name)) {
-				link_lib_module(modname, obj, extern_syms);
+				link_lib_module(modname, obj, symbol_name, extern_syms);
 				linked = true;
 			}
 		}
@@ -810,6 +866,700 @@ static void link_libraries(StrHash* extern_syms) {
 	}
 }
 
+/*-----------------------------------------------------------------------------
+*   remove unreferenced code and data (-gc-sections)
+*	The code of each module in each section is a chunk. Chunks of modules that
+*	define GC_SPLIT_KW are split in one node at each global address label,
+*	all the chunks of other modules form one node that is kept or removed
+*	as a whole. Nodes of the first module and of -gc-keep sections are kept,
+*	together with all the nodes they refer to in expressions, including
+*	relative jumps, and the node after each one that does not end in an
+*	unconditional jump or return (no GC_NOFALL_KW label); the others are
+*	removed before the section addresses are allocated.
+*----------------------------------------------------------------------------*/
+typedef struct gc_node_t {
+	Module*			module;
+	Section*		section;
+	int				start, end;			// offsets relative to module start in section
+	int				removed_before;		// bytes removed before start in the same chunk
+	int				group, group_size;	// nodes kept or removed together
+	const char*		name;				// global label at start, NULL if none
+	bool			fall_in;			// previous node falls into this one
+	bool			live;
+	UT_array*		refs;				// Symbol* referred to by expressions in the node
+} gc_node_t;
+
+typedef struct gc_chunk_t {
+	int				first, count;		// nodes of this chunk
+	UT_array*		labels;				// Symbol* of global labels that split the chunk
+} gc_chunk_t;
+
+typedef struct gc_sym_t {
+	Symbol*			sym;
+	bool			live;
+	UT_array*		refs;				// Symbol* referred to by the EQU expression
+	UT_hash_handle	hh;
+} gc_sym_t;
+
+static bool			g_gc_active;		// code was removed, relocate expressions
+static UT_array*	g_gc_nodes;			// gc_node_t, by module, section and offset
+static StrHash*		g_gc_chunks;		// "module_id@section" -> gc_chunk_t*
+static gc_sym_t*	g_gc_syms;			// symbols reached and EQU references
+
+static void gc_node_dtor(void* elt) {
+	gc_node_t* node = (gc_node_t*)elt;
+	utarray_free(node->refs);
+}
+
+static UT_icd ut_gc_node_icd = { sizeof(gc_node_t), NULL, NULL, gc_node_dtor };
+static UT_icd ut_gc_sym_icd = { sizeof(Symbol*), NULL, NULL, NULL };
+
+static void gc_chunk_free(void* elt) {
+	gc_chunk_t* chunk = (gc_chunk_t*)elt;
+	utarray_free(chunk->labels);
+	xfree(chunk);
+}
+
+static void gc_free(void) {
+	if (g_gc_nodes)
+		utarray_free(g_gc_nodes);
+	g_gc_nodes = NULL;
+
+	OBJ_DELETE(g_gc_chunks);
+
+	gc_sym_t* elem, * tmp;
+	HASH_ITER(hh, g_gc_syms, elem, tmp) {
+		HASH_DEL(g_gc_syms, elem);
+		utarray_free(elem->refs);
+		xfree(elem);
+	}
+
+	g_gc_active = false;
+}
+
+static gc_sym_t* gc_symbol(Symbol* sym) {
+	gc_sym_t* elem;
+	HASH_FIND_PTR(g_gc_syms, &sym, elem);
+	if (elem == NULL) {
+		elem = xnew(gc_sym_t);
+		elem->sym = sym;
+		utarray_new(elem->refs, &ut_gc_sym_icd);
+		HASH_ADD_PTR(g_gc_syms, sym, elem);
+	}
+	return elem;
+}
+
+static Symbol* gc_lookup_symbol(Module* module, const char* name) {
+	Symbol* sym = SymbolHash_get(module->local_symtab, name);
+	if (sym == NULL)
+		sym = SymbolHash_get(global_symtab, name);
+	return sym;
+}
+
+static bool gc_module_split(Module* module) {
+	return SymbolHash_get(module->local_symtab, GC_SPLIT_KW) != NULL;
+}
+
+static bool gc_keep_section(Section* section) {
+	for (char** p = argv_front(opts.gc_keep); *p; p++) {
+		if (strcmp(*p, section->name) == 0)
+			return true;
+	}
+	return false;
+}
+
+static gc_chunk_t* gc_find_chunk(Module* module, Section* section) {
+	if (module == NULL || section == NULL)
+		return NULL;
+
+	STR_DEFINE(key, STR_SIZE);
+	Str_sprintf(key, "%d@%s", module->module_id, section->name);
+	gc_chunk_t* chunk = (gc_chunk_t*)StrHash_get(g_gc_chunks, Str_data(key));
+	STR_DELETE(key);
+	return chunk;
+}
+
+// return node that contains the offset, NULL if module has no code in section
+static gc_node_t* gc_find_node(Module* module, Section* section, int offset) {
+	gc_chunk_t* chunk = gc_find_chunk(module, section);
+	if (chunk == NULL)
+		return NULL;
+
+	// binary search last node starting at or before offset
+	int lo = chunk->first;
+	int hi = chunk->first + chunk->count - 1;
+	while (lo < hi) {
+		int mid = (lo + hi + 1) / 2;
+		gc_node_t* node = (gc_node_t*)utarray_eltptr(g_gc_nodes, mid);
+		if (node->start <= offset)
+			lo = mid;
+		else
+			hi = mid - 1;
+	}
+	return (gc_node_t*)utarray_eltptr(g_gc_nodes, lo);
+}
+
+static void gc_add_node(Module* module, Section* section, int start, int end, const char* name,
+	bool fall_in) {
+	gc_node_t node;
+	memset(&node, 0, sizeof(node));
+	node.module = module;
+	node.section = section;
+	node.start = start;
+	node.end = end;
+	node.name = name;
+	node.fall_in = fall_in;
+	utarray_new(node.refs, &ut_gc_sym_icd);
+	utarray_push_back(g_gc_nodes, &node);
+}
+
+// check for the label that tells that the code before sym does not fall into it
+static bool gc_no_fall_in(Symbol* sym) {
+	STR_DEFINE(name, STR_SIZE);
+	Str_sprintf(name, "%s%s", GC_NOFALL_KW, sym->name);
+
+	bool found = SymbolHash_get(sym->module->local_symtab, Str_data(name)) != NULL;
+
+	STR_DELETE(name);
+	return found;
+}
+
+static int gc_compare_labels(const void* a, const void* b) {
+	const Symbol* sym_a = *(const Symbol**)a;
+	const Symbol* sym_b = *(const Symbol**)b;
+	return sym_a->value < sym_b->value ? -1 : sym_a->value > sym_b->value ? 1 : 0;
+}
+
+static void gc_build_nodes(void) {
+	Module* module;
+	ModuleListElem* it;
+	Section* section;
+	SectionHashElem* s_it;
+	SymbolHashElem* iter;
+
+	utarray_new(g_gc_nodes, &ut_gc_node_icd);
+	g_gc_chunks = OBJ_NEW(StrHash);
+	g_gc_chunks->free_data = gc_chunk_free;
+
+	// one chunk per module and section with code
+	for (module = get_first_module(&it); module != NULL; module = get_next_module(&it)) {
+		set_cur_module(module);
+		for (section = get_first_section(&s_it); section != NULL; section = get_next_section(&s_it)) {
+			set_cur_section(section);
+			if (get_cur_module_size() > 0) {
+				STR_DEFINE(key, STR_SIZE);
+				Str_sprintf(key, "%d@%s", module->module_id, section->name);
+
+				gc_chunk_t* chunk = xnew(gc_chunk_t);
+				utarray_new(chunk->labels, &ut_gc_sym_icd);
+				StrHash_set(&g_gc_chunks, Str_data(key), chunk);
+
+				STR_DELETE(key);
+			}
+		}
+	}
+
+	// collect global labels of split modules
+	for (iter = SymbolHash_first(global_symtab); iter != NULL; iter = SymbolHash_next(iter)) {
+		Symbol* sym = (Symbol*)iter->value;
+		if (sym->type == TYPE_ADDRESS && sym->module != NULL && gc_module_split(sym->module)) {
+			gc_chunk_t* chunk = gc_find_chunk(sym->module, sym->section);
+			if (chunk != NULL)
+				utarray_push_back(chunk->labels, &sym);
+		}
+	}
+
+	// create nodes in module, section and offset order
+	for (module = get_first_module(&it); module != NULL; module = get_next_module(&it)) {
+		int group = utarray_len(g_gc_nodes);
+		bool split = gc_module_split(module);
+
+		set_cur_module(module);
+		for (section = get_first_section(&s_it); section != NULL; section = get_next_section(&s_it)) {
+			gc_chunk_t* chunk = gc_find_chunk(module, section);
+			if (chunk == NULL)
+				continue;
+
+			set_cur_section(section);
+			int size = get_cur_module_size();
+			int start = 0;
+			const char* name = NULL;
+			bool fall_in = false;
+
+			chunk->first = utarray_len(g_gc_nodes);
+			utarray_sort(chunk->labels, gc_compare_labels);
+			for (Symbol** p = (Symbol**)utarray_front(chunk->labels); p != NULL;
+				p = (Symbol**)utarray_next(chunk->labels, p)) {
+				int value = (int)(*p)->value;
+				if (value > start && value < size) {
+					gc_add_node(module, section, start, value, name, fall_in);
+					start = value;
+					name = (*p)->name;
+					fall_in = true;
+				}
+				else if (value == start && name == NULL) {
+					name = (*p)->name;
+				}
+
+				if (gc_no_fall_in(*p))
+					fall_in = false;
+			}
+			gc_add_node(module, section, start, size, name, fall_in);
+			chunk->count = utarray_len(g_gc_nodes) - chunk->first;
+		}
+
+		int count = utarray_len(g_gc_nodes) - group;
+		for (int i = group; i < group + count; i++) {
+			gc_node_t* node = (gc_node_t*)utarray_eltptr(g_gc_nodes, i);
+			node->group = split ? i : group;
+			node->group_size = split ? 1 : count;
+		}
+	}
+}
+
+// add all symbols referred to in the expression text
+static void gc_add_refs(UT_array* refs, Module* module, const char* text) {
+	STR_DEFINE(name, STR_SIZE);
+	const char* p = text;
+
+	while (*p) {
+		if (sym_first(*p)) {
+			const char* q = p + 1;
+			while (*q && sym_next(*q))
+				q++;
+			Str_set_n(name, p, q - p);
+
+			Symbol* sym = gc_lookup_symbol(module, Str_data(name));
+			if (sym != NULL && (sym->type == TYPE_ADDRESS || sym->type == TYPE_COMPUTED))
+				utarray_push_back(refs, &sym);
+			p = q;
+		}
+		else if (isdigit(*p)) {			// skip number, e.g. 0FFh
+			while (*p && sym_next(*p))
+				p++;
+		}
+		else {
+			p++;
+		}
+	}
+
+	STR_DELETE(name);
+}
+
+static void gc_read_refs(obj_file_t* obj) {
+	Module* module = obj->module;
+
+	if (!goto_exprs(obj))
+		return;
+
+	while (true) {
+		int type = parse_byte(obj);
+		if (type == 0)
+			break;			// end marker
+
+		parse_wcount_str(obj);							// skip source file name
+		obj->i += 4;									// skip line number
+		const char* section_name = parse_bcount_str(obj);
+		obj->i += 2;									// skip ASMPC
+		int code_pos = parse_word(obj);
+		const char* target_name = parse_bcount_str(obj);
+		const char* text = parse_wcount_str(obj);
+
+		if (type == '=') {
+			Symbol* sym = gc_lookup_symbol(module, target_name);
+			if (sym != NULL)
+				gc_add_refs(gc_symbol(sym)->refs, module, text);
+		}
+		else {
+			gc_node_t* node = gc_find_node(module, new_section(section_name), code_pos);
+			if (node != NULL)
+				gc_add_refs(node->refs, module, text);
+		}
+	}
+}
+
+static void gc_mark_node(gc_node_t* node, UT_array* pending) {
+	while (node != NULL) {
+		for (int i = node->group; i < node->group + node->group_size; i++) {
+			gc_node_t* member = (gc_node_t*)utarray_eltptr(g_gc_nodes, i);
+			if (!member->live) {
+				member->live = true;
+				utarray_concat(pending, member->refs);
+			}
+		}
+
+		// keep the node that the code runs into
+		unsigned next = node->group + node->group_size;
+		node = next < utarray_len(g_gc_nodes) ? (gc_node_t*)utarray_eltptr(g_gc_nodes, next) : NULL;
+		if (node != NULL && (!node->fall_in || node->live))
+			node = NULL;
+	}
+}
+
+static void gc_mark_symbols(UT_array* pending) {
+	while (utarray_len(pending) > 0) {
+		Symbol* sym = *(Symbol**)utarray_back(pending);
+		utarray_pop_back(pending);
+
+		gc_sym_t* elem = gc_symbol(sym);
+		if (elem->live)
+			continue;
+		elem->live = true;
+
+		if (sym->type == TYPE_ADDRESS) {
+			gc_node_t* node = gc_find_node(sym->module, sym->section, (int)sym->value);
+			if (node != NULL)
+				gc_mark_node(node, pending);
+		}
+		else {
+			utarray_concat(pending, elem->refs);
+		}
+	}
+}
+
+static void gc_push_computed_symbols(SymbolHash* symtab, Module* module, UT_array* pending) {
+	for (SymbolHashElem* iter = SymbolHash_first(symtab); iter != NULL; iter = SymbolHash_next(iter)) {
+		Symbol* sym = (Symbol*)iter->value;
+		if (sym->type == TYPE_COMPUTED && sym->module == module)
+			utarray_push_back(pending, &sym);
+	}
+}
+
+// remove symbols of removed nodes and unreferenced EQU symbols, move the others
+static void gc_relocate_symtab(SymbolHash* symtab) {
+	SymbolHashElem* iter, * next;
+
+	for (iter = SymbolHash_first(symtab); iter != NULL; iter = next) {
+		next = SymbolHash_next(iter);
+		Symbol* sym = (Symbol*)iter->value;
+		bool removed = false;
+
+		if (sym->type == TYPE_ADDRESS && sym->module != NULL) {
+			gc_node_t* node = gc_find_node(sym->module, sym->section, (int)sym->value);
+			if (node != NULL && !node->live)
+				removed = true;
+			else if (node != NULL)
+				sym->value -= node->removed_before;
+		}
+		else if (sym->type == TYPE_COMPUTED && sym->module != NULL) {
+			if (!gc_symbol(sym)->live)
+				removed = true;
+		}
+
+		if (removed)
+			SymbolHash_remove_elem(symtab, iter);
+	}
+}
+
+static void gc_sections(void) {
+	Module* module;
+	ModuleListElem* it;
+	UT_array* pending;
+	gc_node_t* node;
+	int removed_size = 0;
+
+	gc_build_nodes();
+
+	for (obj_file_t* obj = g_objects; obj != NULL; obj = obj->next)
+		gc_read_refs(obj);
+
+	// mark from the first module and the -gc-keep sections
+	utarray_new(pending, &ut_gc_sym_icd);
+	module = get_first_module(NULL);
+	for (node = (gc_node_t*)utarray_front(g_gc_nodes); node != NULL;
+		node = (gc_node_t*)utarray_next(g_gc_nodes, node)) {
+		if (node->module == module || gc_keep_section(node->section))
+			gc_mark_node(node, pending);
+	}
+	gc_push_computed_symbols(module->local_symtab, module, pending);
+	gc_push_computed_symbols(global_symtab, module, pending);
+	gc_mark_symbols(pending);
+	utarray_free(pending);
+
+	// count removed bytes before each node of each chunk
+	for (StrHashElem* elem = StrHash_first(g_gc_chunks); elem != NULL; elem = StrHash_next(elem)) {
+		gc_chunk_t* chunk = (gc_chunk_t*)elem->value;
+		int removed = 0;
+		for (int i = chunk->first; i < chunk->first + chunk->count; i++) {
+			node = (gc_node_t*)utarray_eltptr(g_gc_nodes, i);
+			node->removed_before = removed;
+			if (!node->live)
+				removed += node->end - node->start;
+		}
+		removed_size += removed;
+	}
+
+	if (removed_size == 0)
+		return;
+
+	if (opts.verbose) {
+		for (node = (gc_node_t*)utarray_front(g_gc_nodes); node != NULL;
+			node = (gc_node_t*)utarray_next(g_gc_nodes, node)) {
+			if (!node->live)
+				printf("Removing unreferenced '%s' from section '%s' of module '%s' (%d bytes)\n",
+					node->name ? node->name : node->module->modname,
+					node->section->name, node->module->modname, node->end - node->start);
+		}
+		printf("Removed %d bytes of unreferenced code and data\n", removed_size);
+	}
+
+	// remove and relocate symbols
+	for (module = get_first_module(&it); module != NULL; module = get_next_module(&it))
+		gc_relocate_symtab(module->local_symtab);
+	gc_relocate_symtab(global_symtab);
+
+	// remove code, from the end of each chunk so that offsets stay valid
+	for (int i = (int)utarray_len(g_gc_nodes) - 1; i >= 0; i--) {
+		node = (gc_node_t*)utarray_eltptr(g_gc_nodes, i);
+		if (!node->live)
+			remove_module_bytes(node->section, node->module->module_id, node->start, node->end);
+	}
+
+	g_gc_active = true;
+}
+
+// remove the GC_NOFALL_KW labels, not needed after -gc-sections
+static void gc_remove_nofall_symbols(void) {
+	Module* module;
+	ModuleListElem* it;
+	SymbolHashElem* iter, * next;
+	size_t len = strlen(GC_NOFALL_KW);
+
+	for (module = get_first_module(&it); module != NULL; module = get_next_module(&it)) {
+		if (!gc_module_split(module))
+			continue;
+
+		for (iter = SymbolHash_first(module->local_symtab); iter != NULL; iter = next) {
+			next = SymbolHash_next(iter);
+			Symbol* sym = (Symbol*)iter->value;
+			if (strncmp(sym->name, GC_NOFALL_KW, len) == 0)
+				SymbolHash_remove_elem(module->local_symtab, iter);
+		}
+	}
+}
+
+// return false if the expression belongs to removed code or to a removed EQU,
+// otherwise move its offsets down by the bytes removed before it
+static bool gc_relocate_expr(Module* module, const char* section_name, const char* target_name,
+	int* p_asmpc, int* p_code_pos) {
+	if (!g_gc_active)
+		return true;
+
+	Section* section = new_section(section_name);
+	if (*target_name) {
+		Symbol* sym = gc_lookup_symbol(module, target_name);
+		if (sym == NULL)
+			return false;
+
+		gc_node_t* node = gc_find_node(module, section, *p_asmpc);
+		if (node != NULL) {
+			if (node->live)
+				*p_asmpc -= node->removed_before;
+			else
+				*p_asmpc = node->start - node->removed_before;
+		}
+		return true;
+	}
+	else {
+		gc_node_t* node = gc_find_node(module, section, *p_code_pos);
+		if (node == NULL)
+			return true;
+		if (!node->live)
+			return false;
+
+		*p_asmpc -= node->removed_before;
+		*p_code_pos -= node->removed_before;
+		return true;
+	}
+}
+
+/*-----------------------------------------------------------------------------
+*   link trace (-why-linked)
+*	Each library module linked is recorded with the pending external symbol
+*	that pulled it in and the module that referred to that symbol. The report
+*	is a tree rooted at the object modules, where the total of each node is
+*	the size of the module and of all the modules it pulled in, or a JSON
+*	list of the modules in link order.
+*----------------------------------------------------------------------------*/
+typedef struct link_trace_t {
+	Module*			module;				// library module linked
+	const char*		lib_filename;		// library where it was found
+	const char*		symbol_name;		// external symbol that pulled it in
+	Module*			referrer;			// first module that referred to the symbol
+} link_trace_t;
+
+static UT_icd ut_link_trace_icd = { sizeof(link_trace_t), NULL, NULL, NULL };
+static UT_array*	g_link_trace;		// link_trace_t, in link order
+
+static void link_trace_add(Module* module, const char* lib_filename, const char* symbol_name,
+	Module* referrer) {
+	if (g_link_trace == NULL)
+		utarray_new(g_link_trace, &ut_link_trace_icd);
+
+	link_trace_t trace = { module, spool_add(lib_filename), spool_add(symbol_name), referrer };
+	utarray_push_back(g_link_trace, &trace);
+}
+
+static void link_trace_free(void) {
+	if (g_link_trace)
+		utarray_free(g_link_trace);
+	g_link_trace = NULL;
+}
+
+static link_trace_t* link_trace_find(Module* module) {
+	if (g_link_trace == NULL)
+		return NULL;
+
+	for (link_trace_t* trace = (link_trace_t*)utarray_front(g_link_trace); trace != NULL;
+		trace = (link_trace_t*)utarray_next(g_link_trace, trace)) {
+		if (trace->module == module)
+			return trace;
+	}
+	return NULL;
+}
+
+static void write_json_str(FILE* file, const char* str) {
+	fputc('"', file);
+	for (const char* p = str; *p; p++) {
+		if (*p == '"' || *p == '\\')
+			fprintf(file, "\\%c", *p);
+		else if ((unsigned char)*p < ' ')
+			fprintf(file, "\\u%04x", (unsigned char)*p);
+		else
+			fputc(*p, file);
+	}
+	fputc('"', file);
+}
+
+// write the size of the module in each section, return the module size
+static int write_module_sizes(FILE* file, Module* module) {
+	Section* section;
+	SectionHashElem* s_it;
+	const char* sep = "";
+	int total = 0;
+
+	set_cur_module(module);
+	for (section = get_first_section(&s_it); section != NULL; section = get_next_section(&s_it)) {
+		set_cur_section(section);
+		int size = get_cur_module_size();
+		if (size > 0) {
+			if (opts.why_linked == WHY_LINKED_JSON) {
+				fputs(sep, file);
+				write_json_str(file, section->name);
+				fprintf(file, ": %d", size);
+			}
+			else if (*section->name)
+				fprintf(file, "%s%s %d", sep, section->name, size);
+			else
+				fprintf(file, "%s\"\" %d", sep, size);
+			sep = ", ";
+			total += size;
+		}
+	}
+	return total;
+}
+
+// size of the module and of all modules pulled in by it
+static int module_total_size(Module* module) {
+	Section* section;
+	SectionHashElem* s_it;
+	int total = 0;
+
+	set_cur_module(module);
+	for (section = get_first_section(&s_it); section != NULL; section = get_next_section(&s_it)) {
+		set_cur_section(section);
+		total += get_cur_module_size();
+	}
+
+	if (g_link_trace != NULL) {
+		for (link_trace_t* trace = (link_trace_t*)utarray_front(g_link_trace); trace != NULL;
+			trace = (link_trace_t*)utarray_next(g_link_trace, trace)) {
+			if (trace->referrer == module)
+				total += module_total_size(trace->module);
+		}
+	}
+	return total;
+}
+
+static void write_why_linked_tree(FILE* file, Module* module, link_trace_t* trace, int level) {
+	fprintf(file, "%*s", level * 4, "");
+	if (trace)
+		fprintf(file, "%s (%s) for '%s': ", module->modname, trace->lib_filename, trace->symbol_name);
+	else
+		fprintf(file, "%s (%s): ", module->modname, module->filename);
+	write_module_sizes(file, module);
+	fprintf(file, "; total %d bytes\n", module_total_size(module));
+
+	if (g_link_trace != NULL) {
+		for (link_trace_t* child = (link_trace_t*)utarray_front(g_link_trace); child != NULL;
+			child = (link_trace_t*)utarray_next(g_link_trace, child)) {
+			if (child->referrer == module)
+				write_why_linked_tree(file, child->module, child, level + 1);
+		}
+	}
+}
+
+static void write_why_linked_json(FILE* file) {
+	Module* module;
+	ModuleListElem* it;
+	const char* sep = "";
+
+	fprintf(file, "{\n  \"modules\": [");
+	for (module = get_first_module(&it); module != NULL; module = get_next_module(&it)) {
+		link_trace_t* trace = link_trace_find(module);
+
+		fprintf(file, "%s\n    { \"name\": ", sep);
+		write_json_str(file, module->modname);
+		if (trace) {
+			fprintf(file, ", \"library\": ");
+			write_json_str(file, trace->lib_filename);
+			fprintf(file, ", \"symbol\": ");
+			write_json_str(file, trace->symbol_name);
+			fprintf(file, ", \"referenced_by\": ");
+			if (trace->referrer)
+				write_json_str(file, trace->referrer->modname);
+			else
+				fprintf(file, "null");
+		}
+		else {
+			fprintf(file, ", \"file\": ");
+			write_json_str(file, module->filename);
+		}
+		fprintf(file, ", \"sections\": { ");
+		int size = write_module_sizes(file, module);
+		fprintf(file, " }, \"size\": %d, \"total\": %d }", size, module_total_size(module));
+		sep = ",";
+	}
+	fprintf(file, "\n  ]\n}\n");
+}
+
+static void write_why_linked_file(void) {
+	Module* old_module = get_cur_module();
+	Section* old_section = get_cur_section();
+	Module* module;
+	ModuleListElem* it;
+
+	FILE* file = xfopen(get_why_filename(get_first_module(NULL)->filename), "w");
+
+	if (opts.why_linked == WHY_LINKED_JSON) {
+		write_why_linked_json(file);
+	}
+	else {
+		for (module = get_first_module(&it); module != NULL; module = get_next_module(&it)) {
+			link_trace_t* trace = link_trace_find(module);
+			if (trace == NULL || trace->referrer == NULL)
+				write_why_linked_tree(file, module, trace, 0);
+		}
+	}
+
+	xfclose(file);
+
+	if (old_module) {
+		set_cur_module(old_module);
+		set_cur_section(old_section);
+	}
+}
+
 /*-----------------------------------------------------------------------------
 *   link
 *----------------------------------------------------------------------------*/
@@ -894,18 +1644,24 @@ static void link_module(obj_file_t* obj, StrHash* extern_syms) {
 	if (goto_external_names(obj)) {
 		while (obj->i < end_external_names) {
 			const char* name = parse_bcount_str(obj);
-			StrHash_set(&extern_syms, name, (void*)name);	// remember all extern references
+			if (!StrHash_exists(extern_syms, name))			// remember all extern references
+				StrHash_set(&extern_syms, name, CURRENTMODULE);	// and the first module referring to them
 		}
 	}
 }
 
-static void link_lib_module(const char* modname, obj_file_t* obj, StrHash* extern_syms) {
+static void link_lib_module(const char* modname, obj_file_t* obj, const char* symbol_name,
+	StrHash* extern_syms) {
 	Module* old_module = get_cur_module();			// remember current module
 
 	Module* lib_module = set_cur_module(new_module());	// new module to link library
 	lib_module->modname = spool_add(modname);
 	object_module_append(obj, lib_module);
 
+	if (opts.why_linked != WHY_LINKED_NONE)
+		link_trace_add(lib_module, obj->filename, symbol_name,
+			(Module*)StrHash_get(extern_syms, symbol_name));
+
 	if (opts.verbose)
 		printf("Linking library module '%s'\n", modname);
 
@@ -973,6 +1729,12 @@ void link_modules(void)
 
 	set_error_null();
 
+	/* remove unreferenced code before allocating addresses */
+	if (!get_num_errors() && opts.gc_sections && !opts.consol_obj_file)
+		gc_sections();
+	if (!get_num_errors() && !opts.consol_obj_file)
+		gc_remove_nofall_symbols();
+
 	/* allocate segment addresses and compute absolute addresses of symbols */
 	/* in consol_obj_file sections are zero-based */
 	if (!get_num_errors() && !opts.consol_obj_file)
@@ -1017,8 +1779,13 @@ void link_modules(void)
 
 		if (opts.globaldef)
 			write_def_file();
+
+		if (opts.why_linked != WHY_LINKED_NONE && !opts.consol_obj_file)
+			write_why_linked_file();
 	}
 
+	gc_free();
+	link_trace_free();
 	OBJ_DELETE(extern_syms);
 }
 
@@ -1081,8 +1848,6 @@ CreateBinFile(void)
 }
 
 /* Consolidate object file */
-static int sym_first(int c) { return c == '_' || isalpha(c); }
-static int sym_next(int c) { return c == '_' || isalnum(c); }
 
 static void replace_names(Str* result, const char* input, StrHash* map)
 {
@@ -16,6 +16,7 @@ Define CPU opcodes
 #include "model.h"
 #include "opcodes.h"
 #include "parse.h"
+#include "relax.h"
 #include "z80asm.h"
 #include <assert.h>
 
@@ -41,6 +42,27 @@ void add_opcode(int opcode)
 	}
 
 	append_byte( opcode & 0xFF );
+
+	/* code after unconditional jumps and returns is not reached by falling
+	   through, -gc-sections needs to know it */
+	switch (opcode) {
+	case Z80_JP:
+		set_opcode_flow(false, 2);
+		break;
+	case Z80_JR:						/* RDEL on the 8085 */
+		set_opcode_flow((opts.cpu & (CPU_8080 | CPU_8085)) != 0, 1);
+		break;
+	case Z80_RET:
+	case Z80_RETI:
+	case 0xED45:						/* RETN */
+	case Z80_JP_idx:
+	case 0xDD00 + Z80_JP_idx:
+	case 0xFD00 + Z80_JP_idx:
+		set_opcode_flow(false, 0);
+		break;
+	default:
+		set_opcode_flow(true, 0);
+	}
 }
 
 /* add opcode followed by jump relative offset expression */
@@ -53,6 +75,9 @@ void add_opcode_jr_n(int opcode, struct Expr* expr, int asmpc_offset)
 {
 	expr->asmpc += asmpc_offset;		// expr is assumed to be at asmpc+1; add offset if this is not true
 
+	if (relax_branch(opcode, expr))
+		return;
+
 	if (opts.opt_speed) {
 		switch (opcode) {
 		case Z80_JR:
@@ -110,6 +135,9 @@ void add_opcode_d(int opcode, Expr *expr)
 /* add opcode followed by 16-bit expression */
 void add_opcode_nn(int opcode, Expr *expr)
 {
+	if (relax_branch(opcode, expr))		/* JP may be assembled as JR */
+		return;
+
 	add_opcode(opcode);
 	Pass2infoExpr(RANGE_WORD, expr);
 }
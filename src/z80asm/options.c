@@ -40,6 +40,9 @@
 #define FILEEXT_SYM     ".sym"    
 #define FILEEXT_MAP     ".map"    
 #define FILEEXT_RELOC   ".reloc"  
+#define FILEEXT_DEP     ".d"      
+#define FILEEXT_WHY     ".why"    
+#define FILEEXT_JSON    ".json"   
 
 /* types */
 enum OptType
@@ -70,6 +73,8 @@ static void option_appmake_zx(void);
 static void option_appmake_zx81(void);
 static void option_filler(const char *filler_arg );
 static void option_debug_info();
+static void option_relax(const char *relax_arg );
+static void option_why_linked(const char *why_linked_arg );
 static void define_assembly_defines();
 static void include_z80asm_lib();
 static const char *search_z80asm_lib();
@@ -119,6 +124,7 @@ DEFINE_init_module()
 {
 	opts.inc_path = argv_new();
 	opts.lib_path = argv_new();
+	opts.gc_keep = argv_new();
 	opts.files = argv_new();
 }
 
@@ -126,6 +132,7 @@ DEFINE_dtor_module()
 {
 	argv_free(opts.inc_path);
 	argv_free(opts.lib_path);
+	argv_free(opts.gc_keep);
 	argv_free(opts.files);
 }
 
@@ -648,6 +655,8 @@ static void exit_help( void )
     printf( "    %-6s = symbols file\n", FILEEXT_SYM );
     printf( "    %-6s = map file\n", FILEEXT_MAP );
 	printf( "    %-6s = reloc file\n", FILEEXT_RELOC);
+	printf( "    %-6s = dependency file\n", FILEEXT_DEP);
+	printf( "    %-6s = link trace file\n", FILEEXT_WHY);
 	printf( "    %-6s = global address definition file\n", FILEEXT_DEF);
     printf( "    %-6s = error file\n", FILEEXT_ERR );
 
@@ -717,6 +726,26 @@ static void option_filler(const char *filler_arg )
 		opts.filler = value;
 }
 
+static void option_relax(const char *relax_arg )
+{
+	if (strcmp(relax_arg, "size") == 0)
+		opts.relax = RELAX_SIZE;
+	else if (strcmp(relax_arg, "speed") == 0)
+		opts.relax = RELAX_SPEED;
+	else
+		error_illegal_option(relax_arg);
+}
+
+static void option_why_linked(const char *why_linked_arg )
+{
+	if (strcmp(why_linked_arg, "tree") == 0)
+		opts.why_linked = WHY_LINKED_TREE;
+	else if (strcmp(why_linked_arg, "json") == 0)
+		opts.why_linked = WHY_LINKED_JSON;
+	else
+		error_illegal_option(why_linked_arg);
+}
+
 static void option_debug_info()
 {
 	opts.debug_info = true;
@@ -938,6 +967,19 @@ const char *get_reloc_filename(const char *filename)
 	return path_replace_ext(filename, FILEEXT_RELOC);
 }
 
+const char *get_dep_filename(const char *filename)
+{
+	init_module();
+	return path_prepend_output_dir(path_replace_ext(filename, FILEEXT_DEP));
+}
+
+const char *get_why_filename(const char *filename)
+{
+	init_module();
+	return path_prepend_output_dir(path_replace_ext(filename,
+		opts.why_linked == WHY_LINKED_JSON ? FILEEXT_JSON : FILEEXT_WHY));
+}
+
 const char *get_asm_filename(const char *filename)
 {
 	return path_replace_ext(filename, FILEEXT_ASM);
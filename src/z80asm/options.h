@@ -48,6 +48,16 @@
 *----------------------------------------------------------------------------*/
 typedef enum { APPMAKE_NONE, APPMAKE_ZX81, APPMAKE_ZX } appmake_t;
 
+/*-----------------------------------------------------------------------------
+*   JR/JP branch relaxation
+*----------------------------------------------------------------------------*/
+typedef enum { RELAX_NONE, RELAX_SIZE, RELAX_SPEED } relax_t;
+
+/*-----------------------------------------------------------------------------
+*   Format of the link trace
+*----------------------------------------------------------------------------*/
+typedef enum { WHY_LINKED_NONE, WHY_LINKED_TREE, WHY_LINKED_JSON } why_linked_t;
+
 /*-----------------------------------------------------------------------------
 *   singleton opts
 *----------------------------------------------------------------------------*/
@@ -81,6 +91,8 @@ extern const char *get_lib_filename(const char *filename );
 extern const char *get_sym_filename(const char *filename );
 extern const char *get_map_filename(const char *filename);
 extern const char *get_reloc_filename(const char *filename);
+extern const char *get_dep_filename(const char *filename);
+extern const char *get_why_filename(const char *filename);
 
 /*-----------------------------------------------------------------------------
 *   Call appmake if requested in options
@@ -28,9 +28,14 @@ OPT_VAR( bool,		globaldef,	false	)
 OPT_VAR( bool,		make_bin,	false	)
 OPT_VAR( bool,		split_bin,	false   )	/* true to split binary file per section */
 OPT_VAR( bool,		date_stamp,	false	)
+OPT_VAR( bool,		make_depfile, false	)	/* -MD */
 OPT_VAR( bool,		relocatable, false	)
 OPT_VAR( bool,      reloc_info, false   )	/* generate .reloc file */
 OPT_VAR( bool,		opt_speed,	false   )
+OPT_VAR( bool,		gc_sections, false  )	/* remove unreferenced code when linking */
+OPT_VAR(why_linked_t, why_linked, WHY_LINKED_NONE)	/* -why-linked=tree|json */
+
+OPT_VAR(relax_t, relax, RELAX_NONE)			/* -relax=size|speed */
 
 OPT_VAR(appmake_t, appmake, APPMAKE_NONE)
 OPT_VAR(const char *, appmake_opts, "")
@@ -48,6 +53,7 @@ OPT_VAR(const char *,    output_directory, NULL)	/* set by -O */
 
 OPT_VAR(argv_t *,	inc_path, NULL)			/* path for include files */
 OPT_VAR(argv_t *,	lib_path, NULL)			/* path for library files */
+OPT_VAR(argv_t *,	gc_keep,  NULL)			/* sections never removed by -gc-sections */
 
 OPT_VAR(argv_t *,	files,	  NULL)			/* list of input files */
 
@@ -81,6 +87,7 @@ OPT(OptCall, option_cpu_ti83plus, "-mti83plus", "", "Assemble for the TI83Plus",
 OPT(OptCall, option_cpu_ti83, "-mti83", "", "Assemble for the TI83", "")
 OPT(OptSet, &opts.swap_ix_iy, "-IXIY", "", "Swap IX and IY registers", "")
 OPT(OptSet, &opts.opt_speed, "-opt-speed", "", "Optimize for speed", "")
+OPT(OptCallArg, option_relax, "-relax", "", "Choose JR or JP for each branch for size or speed", "=size|speed")
 OPT(OptCall, option_debug_info, "-debug", "", "Add debug info to map file", "")
 
 OPT_TITLE("Environment:")
@@ -97,7 +104,11 @@ OPT(OptString, (void*)&opts.output_directory, "-O", "", "Output directory", "DIR
 OPT(OptString, (void*)&opts.bin_file, "-o", "", "Output binary file", "FILE")
 OPT(OptSet, &opts.make_bin, "-b", "", "Assemble and link/relocate to file" FILEEXT_BIN, "")
 OPT(OptSet, &opts.split_bin, "-split-bin", "", "Create one binary file per section", "")
-OPT(OptSet, &opts.date_stamp, "-d", "", "Assemble only updated files", "")
+OPT(OptSet, &opts.gc_sections, "-gc-sections", "", "Remove unreferenced code and data when linking", "")
+OPT(OptStringList, &opts.gc_keep, "-gc-keep", "", "Never remove section when linking with -gc-sections", "=SECTION")
+OPT(OptCallArg, option_why_linked, "-why-linked", "", "Report why each library module was linked", "=tree|json")
+OPT(OptSet, &opts.date_stamp, "-d", "", "Assemble only files with changed sources or defines", "")
+OPT(OptSet, &opts.make_depfile, "-MD", "", "Create dependency file" FILEEXT_DEP, "")
 OPT(OptCallArg, option_origin, "-r", "", "Relocate binary file to given address (decimal or hex)", "ADDR")
 OPT(OptSet, &opts.relocatable, "-R", "", "Create relocatable code", "")
 OPT(OptSet, &opts.reloc_info, "-reloc-info", "", "Geneate binary file relocation information", "")
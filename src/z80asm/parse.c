@@ -11,6 +11,7 @@ Define ragel-based parser.
 
 #include "class.h"
 #include "codearea.h"
+#include "depfile.h"
 #include "die.h"
 #include "directives.h"
 #include "expr.h"
@@ -26,6 +27,7 @@ Define ragel-based parser.
 #include "utarray.h"
 #include "utstring.h"
 #include "zutils.h"
+#include "../zx0/pack.h"
 
 #include <ctype.h>
 
@@ -449,6 +451,60 @@ static void asm_ENDIF(ParseCtx *ctx)
 	}
 }
 
+/*-----------------------------------------------------------------------------
+*   [label] BINARY|INCBIN "file", method - include the file compressed
+*	Tried when the statement is not one of the grammar in parse_rules.rl
+*----------------------------------------------------------------------------*/
+static bool parse_binary_packed(ParseCtx *ctx)
+{
+	STR_DEFINE(label, STR_SIZE);
+	STR_DEFINE(filename, STR_SIZE);
+	STR_DEFINE(method, STR_SIZE);
+	bool parse_ok = false;
+
+	if (ctx->current_sm != SM_MAIN)
+		return false;
+
+	save_scan_state();
+	{
+		if (sym.tok == TK_LABEL) {
+			Str_set_n(label, sym.tstart, sym.tlen);
+			GetSym();
+		}
+		if (sym.tok == TK_BINARY || sym.tok == TK_INCBIN) {
+			GetSym();
+			if (sym.tok == TK_STRING) {
+				Str_set_bytes(filename, sym.tstart, sym.tlen);
+				GetSym();
+				if (sym.tok == TK_COMMA) {
+					GetSym();
+					if (sym.tok == TK_NAME) {
+						Str_set_n(method, sym.tstart, sym.tlen);
+						GetSym();
+						parse_ok = (sym.tok == TK_NEWLINE);
+					}
+				}
+			}
+		}
+	}
+	if (parse_ok) {
+		drop_scan_state();
+
+		asm_cond_LABEL(label);
+		if (pack_method(Str_data(method)) < 0)
+			error_unknown_compression(Str_data(method));
+		else
+			asm_BINARY_packed(Str_data(filename), pack_method(Str_data(method)));
+	}
+	else
+		restore_scan_state();
+
+	STR_DELETE(label);
+	STR_DELETE(filename);
+	STR_DELETE(method);
+	return parse_ok;
+}
+
 /*-----------------------------------------------------------------------------
 *   Import parser generated by ragel
 *----------------------------------------------------------------------------*/
@@ -491,6 +547,8 @@ bool parse_file(const char *filename)
 	src_push();
 	{
 		if (src_open(filename, opts.inc_path)) {
+			depfile_add(src_filename());
+
 			if (opts.verbose)
 				printf("Reading '%s' = '%s'\n", path_canon(filename), path_canon(src_filename()));	/* display name of file */
 
@@ -525,8 +583,10 @@ bool parse_statement(ParseCtx *ctx)
 	}
 	if (parse_ok)
 		drop_scan_state();
-	else
+	else {
 		restore_scan_state();
+		parse_ok = parse_binary_packed(ctx);
+	}
 
 	return parse_ok;
 }
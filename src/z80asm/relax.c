@@ -0,0 +1,211 @@
+/*
+Z88DK Z80 Macro Assembler
+
+Copyright (C) Paulo Custodio, 2011-2020
+License: The Artistic License 2.0, http://www.perlfoundation.org/artistic_license_2_0
+Repository: https://github.com/z88dk/z88dk
+
+JR/JP branch relaxation (-relax=size|speed).
+*/
+
+#include "relax.h"
+#include "codearea.h"
+#include "expr.h"
+#include "init.h"
+#include "opcodes.h"
+#include "options.h"
+#include "utarray.h"
+#include "z80asm.h"
+
+/*-----------------------------------------------------------------------------
+*   branches of the module, in source order
+*----------------------------------------------------------------------------*/
+typedef struct relax_branch_t {
+	bool	 is_long;		/* assembled as JP */
+	bool	 is_cond;		/* conditional branch */
+	Expr	*expr;			/* target in the current pass (weak ref) */
+} relax_branch_t;
+
+static UT_icd ut_relax_branch_icd = { sizeof(relax_branch_t), NULL, NULL, NULL };
+
+static UT_array *g_branches;		/* decisions of the module */
+static unsigned	 g_next_branch;		/* index of next branch in the current pass */
+
+/*-----------------------------------------------------------------------------
+*   Initialize and Terminate module
+*----------------------------------------------------------------------------*/
+DEFINE_init_module()
+{
+	utarray_new(g_branches, &ut_relax_branch_icd);
+}
+
+DEFINE_dtor_module()
+{
+	utarray_free(g_branches);
+}
+
+/*-----------------------------------------------------------------------------
+*   start relaxation of a new module
+*----------------------------------------------------------------------------*/
+void relax_start(void)
+{
+	init_module();
+	utarray_clear(g_branches);
+	g_next_branch = 0;
+}
+
+/*-----------------------------------------------------------------------------
+*   check if the expression refers to ASMPC, i.e. counts on the size of
+*	the branch as written
+*----------------------------------------------------------------------------*/
+static bool relax_uses_asmpc(Expr *expr)
+{
+	for (size_t i = 0; i < ExprOpArray_size(expr->rpn_ops); i++) {
+		if (ExprOpArray_item(expr->rpn_ops, i)->op_type == ASMPC_OP)
+			return true;
+	}
+	return false;
+}
+
+/*-----------------------------------------------------------------------------
+*   check if the target of the branch fits in a JR, and if a JR is
+*	the best choice; pc is the address of the branch opcode
+*----------------------------------------------------------------------------*/
+static bool relax_fits_short(relax_branch_t *branch, int pc)
+{
+	Expr *expr = branch->expr;
+	long offset;
+
+	offset = Expr_eval(expr, false);
+	if (expr->result.not_evaluable || expr->result.undefined_symbol ||
+		expr->result.extern_symbol || expr->result.cross_section_addr ||
+		!expr->is_computed || expr->type != TYPE_ADDRESS)
+		return false;
+
+	offset -= pc + 2;
+	if (offset < -128 || offset > 127)
+		return false;
+
+	/* backward conditional branches close loops and are usually taken:
+	   JP cc takes 10 T-states, JR cc takes 12 if taken */
+	if (opts.relax == RELAX_SPEED && branch->is_cond && offset < 0)
+		return false;
+
+	return true;
+}
+
+/*-----------------------------------------------------------------------------
+*   add a JR/JP opcode followed by its target expression
+*----------------------------------------------------------------------------*/
+bool relax_branch(int opcode, Expr *expr)
+{
+	relax_branch_t *branch;
+	int jr_opcode, jp_opcode;
+	bool is_cond;
+
+	init_module();
+
+	if (opts.relax == RELAX_NONE || (opts.cpu & (CPU_8080 | CPU_8085)))
+		return false;
+	if (get_phased_PC() >= 0)		/* PHASE labels are constants */
+		return false;
+	if (relax_uses_asmpc(expr))		/* jr $+3 depends on its own size */
+		return false;
+
+	switch (opcode) {
+	case Z80_JR:
+	case Z80_JP:
+		jr_opcode = Z80_JR;
+		jp_opcode = Z80_JP;
+		is_cond = false;
+		break;
+	case Z80_JR_FLAG(FLAG_NZ): case Z80_JP_FLAG(FLAG_NZ):
+	case Z80_JR_FLAG(FLAG_Z):  case Z80_JP_FLAG(FLAG_Z):
+	case Z80_JR_FLAG(FLAG_NC): case Z80_JP_FLAG(FLAG_NC):
+	case Z80_JR_FLAG(FLAG_C):  case Z80_JP_FLAG(FLAG_C):
+		if (opcode >= Z80_JP_FLAG(0)) {
+			jp_opcode = opcode;
+			jr_opcode = opcode - Z80_JP_FLAG(0) + Z80_JR_FLAG(0);
+		}
+		else {
+			jr_opcode = opcode;
+			jp_opcode = opcode - Z80_JR_FLAG(0) + Z80_JP_FLAG(0);
+		}
+		is_cond = true;
+		break;
+	default:
+		return false;			/* DJNZ and JP cc without JR form */
+	}
+
+	/* JP is always faster than JR */
+	if (opts.relax == RELAX_SPEED && !is_cond) {
+		add_opcode(jp_opcode);
+		Pass2infoExpr(RANGE_WORD, expr);
+		return true;
+	}
+
+	/* new branch starts short, unless the target is already known */
+	if (g_next_branch >= utarray_len(g_branches)) {
+		relax_branch_t new_branch = { false, is_cond, expr };
+		utarray_push_back(g_branches, &new_branch);
+
+		/* a target already defined only moves away if other branches grow */
+		branch = (relax_branch_t *)utarray_back(g_branches);
+		if (!relax_fits_short(branch, expr->asmpc) && !expr->result.not_evaluable)
+			branch->is_long = true;
+	}
+
+	branch = (relax_branch_t *)utarray_eltptr(g_branches, g_next_branch);
+	g_next_branch++;
+	branch->is_cond = is_cond;
+	branch->expr = expr;
+
+	if (branch->is_long) {
+		add_opcode(jp_opcode);
+		Pass2infoExpr(RANGE_WORD, expr);
+	}
+	else {
+		add_opcode(jr_opcode);
+		Pass2infoExpr(RANGE_JR_OFFSET, expr);
+	}
+	return true;
+}
+
+/*-----------------------------------------------------------------------------
+*   check the branches of the pass just assembled
+*----------------------------------------------------------------------------*/
+bool relax_next_pass(void)
+{
+	relax_branch_t *branch;
+	Section *section;
+	bool changed = false;
+
+	init_module();
+
+	section = get_cur_section();
+	for (unsigned i = 0; i < g_next_branch && i < utarray_len(g_branches); i++) {
+		branch = (relax_branch_t *)utarray_eltptr(g_branches, i);
+		if (!branch->is_long) {
+			set_cur_section(branch->expr->section);
+			set_PC(branch->expr->asmpc);
+
+			if (!relax_fits_short(branch, branch->expr->asmpc)) {
+				branch->is_long = true;
+				changed = true;
+			}
+		}
+		branch->expr = NULL;
+	}
+	set_cur_section(section);
+
+	g_next_branch = 0;
+	return changed;
+}
+
+/*-----------------------------------------------------------------------------
+*   end relaxation of the module
+*----------------------------------------------------------------------------*/
+void relax_end(void)
+{
+	relax_start();
+}
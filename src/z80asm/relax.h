@@ -0,0 +1,35 @@
+/*
+Z88DK Z80 Macro Assembler
+
+Copyright (C) Paulo Custodio, 2011-2020
+License: The Artistic License 2.0, http://www.perlfoundation.org/artistic_license_2_0
+Repository: https://github.com/z88dk/z88dk
+
+JR/JP branch relaxation (-relax=size|speed).
+Each JR, JR cc, JP and JP cc (NZ, Z, NC, C) to a label is assembled in the
+short or long form chosen for size or speed; branches whose target refers to
+ASMPC ($) are assembled as written. The module is assembled again
+until no branch needs to grow; branches never shrink between passes, so the
+process always ends.
+*/
+
+#pragma once
+
+#include "types.h"
+
+struct Expr;
+
+/* start relaxation of a new module */
+extern void relax_start(void);
+
+/* add a JR/JP opcode followed by its target expression in the form chosen
+   by the relaxation; return false if the branch is not relaxed and must be
+   assembled as written */
+extern bool relax_branch(int opcode, struct Expr *expr);
+
+/* check the branches of the pass just assembled; return true if any
+   branch changed form and the module must be assembled again */
+extern bool relax_next_pass(void);
+
+/* end relaxation of the module */
+extern void relax_end(void);
@@ -24,6 +24,15 @@ struct Section;
 #define ASMTAIL_KW	"__%s%s" "tail"
 #define ASMSIZE_KW	"__%s%s" "size"
 
+/* label defined by the compiler in modules where each global label starts
+   an independent block of code or data that -gc-sections may remove */
+#define GC_SPLIT_KW	"__gc_split"
+
+/* prefix of the label defined by the assembler in those modules at each
+   global label that follows an unconditional jump or return, i.e. that the
+   code before it does not fall into */
+#define GC_NOFALL_KW	"__gc_nofall_"
+
 /*-----------------------------------------------------------------------------
 *   Type of symbol
 *	Expressions have the type of the greatest symbol used
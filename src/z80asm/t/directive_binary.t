@@ -99,5 +99,40 @@ z80asm(<<END, "-b -Itest_dir");
 END
 check_bin_file("test.bin", "hello");
 
+# compressed as included
+unlink_testfiles();
+spew("test1.dat", "hello hello hello hello world\n" x 3);
+z80asm(<<END);
+		ld bc,101h
+lbl:	binary "test1.dat", zx0
+		incbin "test1.dat", zx0_back
+		binary "test1.dat", zx7
+		incbin "test1.dat", zx7_back
+		ld de,lbl
+END
+check_bin_file("test.bin", pack("C*", 
+				1, 1, 1, 
+				0x68, 0x68, 0x65, 0x6c, 0xe0, 0x6f, 0x20, 0xf4, 0x66, 0x77, 
+				0x6f, 0x72, 0x8f, 0x64, 0x0a, 0xc4, 0x45, 0xc0, 0x00, 0x20,
+				0xa0, 0xaa, 0xda, 0x3b, 0x7b, 0xad, 0x0b, 0x68, 0x65, 0x24, 
+				0x6c, 0x6f, 0x20, 0x77, 0x6f, 0x72, 0x6c, 0x64, 0x0a, 0xac,
+				0x68, 0x04, 0x65, 0x6c, 0x6c, 0x6f, 0x20, 0x22, 0x05, 0x77, 
+				0x04, 0x6f, 0x72, 0x6c, 0x64, 0x0a, 0x1d, 0xc0, 0x1d, 0x00, 0x20,
+				0x20, 0x00, 0x1d, 0xc0, 0x1d, 0x05, 0x8c, 0x68, 0x65, 0x6c, 
+				0x10, 0x6c, 0x6f, 0x20, 0x77, 0x6f, 0x72, 0x6c, 0x64, 0x00, 0x0a,
+				0x11, 3, 0));
+
+z80asm(<<END, "-b", 1, "", <<END);
+		binary "test1.dat", lz4
+END
+Error at file 'test.asm' line 1: unknown compression method 'lz4'
+END
+
+z80asm(<<END, "-b", 1, "", <<END);
+		binary "test2.dat", zx0
+END
+Error at file 'test.asm' line 1: cannot read file 'test2.dat'
+END
+
 unlink_testfiles();
 done_testing();
@@ -0,0 +1,175 @@
+#!/usr/bin/perl
+
+# Z88DK Z80 Macro Assembler
+#
+# Copyright (C) Paulo Custodio, 2011-2021
+# License: The Artistic License 2.0, http://www.perlfoundation.org/artistic_license_2_0
+# Repository: https://github.com/z88dk/z88dk/
+#
+# Test -gc-sections and -gc-keep
+
+use Modern::Perl;
+use Test::More;
+require './t/testlib.pl';
+
+unlink_testfiles();
+spew("test.asm", <<END);
+	section code
+	extern func_a, alias
+main:
+	call func_a
+	ld hl, alias
+	ret
+END
+
+# module split at each global label
+spew("test1.asm", <<END);
+	section code
+__gc_split:
+	public func_a, func_b, func_c, alias
+	defc alias = func_c + 1
+func_a:
+	ld a, (data_a)
+	ret
+func_b:
+	ld a, (data_b)
+	call local_f
+	ret
+local_f:
+	ret
+func_c:
+	nop
+	ret
+	section data
+	public data_a, data_b
+data_a:	defb 1
+data_b: defb 2
+END
+
+# module removed as a whole
+spew("test2.asm", <<END);
+	section code
+	public dead_f
+dead_f:
+	ret
+	section data
+	defb 0x55
+END
+
+# without -gc-sections
+run("z80asm -b test.asm test1.asm test2.asm");
+check_bin_file("test.bin", pack("C*",
+				0xCD, 0x07, 0x00,			# call func_a
+				0x21, 0x14, 0x00,			# ld hl, alias
+				0xC9,						# ret
+				0x3A, 0x16, 0x00, 0xC9,		# func_a
+				0x3A, 0x17, 0x00, 			# func_b
+				0xCD, 0x12, 0x00, 0xC9,
+				0xC9,						# local_f
+				0x00, 0xC9,					# func_c
+				0xC9,						# dead_f
+				0x01, 0x02,					# data_a, data_b
+				0x55));
+
+# with -gc-sections
+run("z80asm -b -m -gc-sections test.asm test1.asm test2.asm");
+check_bin_file("test.bin", pack("C*",
+				0xCD, 0x07, 0x00,			# call func_a
+				0x21, 0x0C, 0x00,			# ld hl, alias
+				0xC9,						# ret
+				0x3A, 0x0D, 0x00, 0xC9,		# func_a
+				0x00, 0xC9,					# func_c
+				0x01));						# data_a
+check_text_file("test.map", <<'END');
+main                            = $0000 ; addr, local, , test, code, test.asm:3
+__gc_split                      = $0007 ; addr, local, , test1, code, test1.asm:2
+func_a                          = $0007 ; addr, public, , test1, code, test1.asm:5
+func_c                          = $000B ; addr, public, , test1, code, test1.asm:14
+alias                           = $000C ; addr, public, , test1, code, test1.asm:4
+data_a                          = $000D ; addr, public, , test1, data, test1.asm:19
+__head                          = $0000 ; const, public, def, , ,
+__tail                          = $000E ; const, public, def, , ,
+__size                          = $000E ; const, public, def, , ,
+__code_head                     = $0000 ; const, public, def, , ,
+__code_tail                     = $000D ; const, public, def, , ,
+__code_size                     = $000D ; const, public, def, , ,
+__data_head                     = $000D ; const, public, def, , ,
+__data_tail                     = $000E ; const, public, def, , ,
+__data_size                     = $0001 ; const, public, def, , ,
+END
+
+# keep sections
+run("z80asm -b -gc-sections -gc-keep=data test.asm test1.asm test2.asm");
+check_bin_file("test.bin", pack("C*",
+				0xCD, 0x07, 0x00,			# call func_a
+				0x21, 0x0C, 0x00,			# ld hl, alias
+				0xC9,						# ret
+				0x3A, 0x0E, 0x00, 0xC9,		# func_a
+				0x00, 0xC9,					# func_c
+				0xC9,						# dead_f, kept by data of same module
+				0x01, 0x02,					# data_a, data_b
+				0x55));
+
+# report removed code
+run("z80asm -b -v -gc-sections test.asm test1.asm test2.asm", 0, 'IGNORE');
+run("z80asm -b -v -gc-sections test.asm test1.asm test2.asm | grep -i remov", 0, <<'END');
+Removing unreferenced 'func_b' from section 'code' of module 'test1' (8 bytes)
+Removing unreferenced 'data_b' from section 'data' of module 'test1' (1 bytes)
+Removing unreferenced 'test2' from section 'code' of module 'test2' (1 bytes)
+Removing unreferenced 'test2' from section 'data' of module 'test2' (1 bytes)
+Removed 11 bytes of unreferenced code and data
+END
+
+# library modules
+run("z80asm -xtest_lib.lib test1.asm test2.asm");
+run("z80asm -b -gc-sections -ltest_lib.lib test.asm");
+check_bin_file("test.bin", pack("C*",
+				0xCD, 0x07, 0x00,			# call func_a
+				0x21, 0x0C, 0x00,			# ld hl, alias
+				0xC9,						# ret
+				0x3A, 0x0D, 0x00, 0xC9,		# func_a
+				0x00, 0xC9,					# func_c
+				0x01));						# data_a
+
+# relative jumps and code that falls into the next label are followed
+spew("test.asm", <<END);
+	section code
+	extern func_a
+	call func_a
+	ret
+END
+spew("test1.asm", <<END);
+	section code
+__gc_split:
+	public func_a, func_b, func_c, func_d, func_e
+func_a:
+	call func_d
+	jr func_c
+func_b:
+	ld a, 1
+	ret
+func_c:
+	ret
+func_d:
+	ld a, 2
+func_e:
+	inc a
+	ret
+END
+run("z80asm -b -gc-sections test.asm test1.asm");
+check_bin_file("test.bin", pack("C*",
+				0xCD, 0x04, 0x00,			# call func_a
+				0xC9,						# ret
+				0xCD, 0x0A, 0x00,			# func_a: call func_d
+				0x18, 0x00,					# jr func_c
+				0xC9,						# func_c
+				0x3E, 0x02,					# func_d
+				0x3C, 0xC9));				# func_e
+run("z80asm -b -v -gc-sections test.asm test1.asm | grep -i remov", 0, <<'END');
+Removing unreferenced 'func_b' from section 'code' of module 'test1' (3 bytes)
+Removed 3 bytes of unreferenced code and data
+END
+
+unlink_testfiles();
+unlink("test_lib.lib");
+done_testing();
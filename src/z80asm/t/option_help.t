@@ -38,6 +38,8 @@ Usage:
     .sym   = symbols file
     .map   = map file
     .reloc = reloc file
+    .d     = dependency file
+    .why   = link trace file
     .def   = global address definition file
     .err   = error file
 
@@ -58,6 +60,7 @@ Code Generation Options:
   -mti83                 Assemble for the TI83
   -IXIY                  Swap IX and IY registers
   -opt-speed             Optimize for speed
+  -relax=size|speed      Choose JR or JP for each branch for size or speed
   -debug                 Add debug info to map file
 
 Environment:
@@ -74,7 +77,11 @@ Binary Output:
   -oFILE                 Output binary file
   -b                     Assemble and link/relocate to file.bin
   -split-bin             Create one binary file per section
-  -d                     Assemble only updated files
+  -gc-sections           Remove unreferenced code and data when linking
+  -gc-keep=SECTION       Never remove section when linking with -gc-sections
+  -why-linked=tree|json  Report why each library module was linked
+  -d                     Assemble only files with changed sources or defines
+  -MD                    Create dependency file.d
   -rADDR                 Relocate binary file to given address (decimal or hex)
   -R                     Create relocatable code
   -reloc-info            Geneate binary file relocation information
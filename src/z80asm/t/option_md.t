@@ -0,0 +1,92 @@
+#!/usr/bin/perl
+
+# Z88DK Z80 Macro Assembler
+#
+# Copyright (C) Paulo Custodio, 2011-2021
+# License: The Artistic License 2.0, http://www.perlfoundation.org/artistic_license_2_0
+# Repository: https://github.com/z88dk/z88dk/
+#
+# Test -MD and -d
+
+use Modern::Perl;
+use Test::More;
+require './t/testlib.pl';
+
+unlink_testfiles();
+spew("test.inc", "defc value = 1\n");
+spew("test.dat", "\x01\x02");
+spew("test.asm", <<'END');
+	include "test.inc"
+	defb value
+	binary "test.dat"
+	binary "test.dat"
+END
+
+# dependency file
+run("z80asm -b -MD test.asm");
+check_bin_file("test.bin", pack("C*", 1, 1, 2, 1, 2));
+ok -f "test.d", "test.d exists";
+my @dep = split(/\n/, slurp("test.d"));
+is scalar(@dep), 2, "test.d lines";
+is $dep[0], "test.o: test.asm test.inc test.dat", "test.d rule";
+like $dep[1], qr/^# z80asm-hash: [0-9a-f]{16}$/, "test.d hash";
+
+# no dependency file on error
+spew("test1.asm", "ld a, (hl\n");
+run("z80asm -MD test1.asm", 1, "", "IGNORE");
+ok ! -f "test1.d", "no test1.d";
+unlink "test1.asm", "test1.err";
+
+# -d assembles when the dependency file is missing
+unlink "test.d";
+run("z80asm -b -v -d test.asm | grep Assembling", 0, <<'END');
+Assembling 'test.asm' to 'test.o'
+END
+ok -f "test.d", "test.d exists";
+
+# up-to-date
+run("z80asm -b -v -d test.asm | grep Assembling", 1, "");
+check_bin_file("test.bin", pack("C*", 1, 1, 2, 1, 2));
+
+# source file newer but unchanged
+utime(undef, undef, "test.asm");
+utime(time - 10, time - 10, "test.o");
+run("z80asm -b -v -d test.asm | grep Assembling", 1, "");
+
+# include file changed
+spew("test.inc", "defc value = 2\n");
+run("z80asm -b -v -d test.asm | grep Assembling", 0, <<'END');
+Assembling 'test.asm' to 'test.o'
+END
+check_bin_file("test.bin", pack("C*", 2, 1, 2, 1, 2));
+
+# binary file changed
+spew("test.dat", "\x03");
+run("z80asm -b -v -d test.asm | grep Assembling", 0, <<'END');
+Assembling 'test.asm' to 'test.o'
+END
+check_bin_file("test.bin", pack("C*", 2, 3, 3));
+
+# define changed
+run("z80asm -b -v -d test.asm | grep Assembling", 1, "");
+run("z80asm -b -v -d -Dvalue2 test.asm | grep Assembling", 0, <<'END');
+Assembling 'test.asm' to 'test.o'
+END
+run("z80asm -b -v -d -Dvalue2 test.asm | grep Assembling", 1, "");
+run("z80asm -b -v -d -Dvalue2=3 test.asm | grep Assembling", 0, <<'END');
+Assembling 'test.asm' to 'test.o'
+END
+
+# option changed
+run("z80asm -b -v -d -Dvalue2=3 -IXIY test.asm | grep Assembling", 0, <<'END');
+Assembling 'test.asm' to 'test.o'
+END
+
+# object file missing
+unlink "test.o";
+run("z80asm -b -v -d -Dvalue2=3 -IXIY test.asm | grep Assembling", 0, <<'END');
+Assembling 'test.asm' to 'test.o'
+END
+
+unlink_testfiles();
+done_testing();
@@ -0,0 +1,145 @@
+#!/usr/bin/perl
+
+# Z88DK Z80 Macro Assembler
+#
+# Copyright (C) Paulo Custodio, 2011-2021
+# License: The Artistic License 2.0, http://www.perlfoundation.org/artistic_license_2_0
+# Repository: https://github.com/z88dk/z88dk/
+#
+# Test -relax=size|speed
+
+use Modern::Perl;
+use Test::More;
+require './t/testlib.pl';
+
+unlink_testfiles();
+
+my $asm = <<'END';
+	extern ext
+start:
+	jp l1
+	jp nz, l1
+	jr c, far
+	jp ext
+l1:	djnz start
+	jp z, start
+	jp pe, start
+	defs 128, 0
+far:	jp nc, l1
+	defw size
+	defc size = $ - start
+END
+
+# as written
+z80asm($asm, "-b", 1, "", <<'END');
+Error at file 'test.asm' line 5: integer '139' out of range
+END
+
+# size
+z80asm($asm, "-b -relax=size", 1, "", <<'END');
+Error at file 'test.asm' line 6: symbol 'ext' not defined
+END
+z80asm($asm, "-relax=size");
+spew("test1.asm", "public ext \n ext: ret");
+run("z80asm -b -relax=size test.asm test1.asm");
+check_bin_file("test.bin", pack("C*",
+				0x18, 0x08,					# jr l1
+				0x20, 0x06,					# jr nz, l1
+				0xDA, 0x91, 0x00,			# jp c, far
+				0xC3, 0x96, 0x00,			# jp ext
+				0x10, 0xF4,					# djnz start
+				0x28, 0xF2,					# jr z, start
+				0xEA, 0x00, 0x00,			# jp pe, start
+				(0) x 128,
+				0xD2, 0x0A, 0x00,			# jp nc, l1
+				0x96, 0x00,					# defw size
+				0xC9));
+
+# speed
+run("z80asm -b -relax=speed test.asm test1.asm");
+check_bin_file("test.bin", pack("C*",
+				0xC3, 0x0B, 0x00,			# jp l1
+				0x20, 0x06,					# jr nz, l1
+				0xDA, 0x93, 0x00,			# jp c, far
+				0xC3, 0x98, 0x00,			# jp ext
+				0x10, 0xF3,					# djnz start
+				0xCA, 0x00, 0x00,			# jp z, start
+				0xEA, 0x00, 0x00,			# jp pe, start
+				(0) x 128,
+				0xD2, 0x0B, 0x00,			# jp nc, l1
+				0x98, 0x00,					# defw size
+				0xC9));
+
+# branch grows because a later branch grows
+z80asm(<<'END', "-b -relax=size");
+	jp l2
+	jp far
+	defs 125, 0
+l2:	ret
+	defs 130, 0
+far: ret
+END
+check_bin_file("test.bin", pack("C*",
+				0xC3, 0x83, 0x00,			# jp l2
+				0xC3, 0x06, 0x01,			# jp far
+				(0) x 125,
+				0xC9,
+				(0) x 130,
+				0xC9));
+
+# branches to other sections and constants stay long
+z80asm(<<'END', "-b -relax=size");
+	section code
+	jp 0
+	jp data
+	section data
+data: ret
+END
+check_bin_file("test.bin", pack("C*",
+				0xC3, 0x00, 0x00,
+				0xC3, 0x06, 0x00,
+				0xC9));
+
+# branches relative to ASMPC stay as written
+for my $relax (qw( size speed )) {
+	z80asm(<<'END', "-b -relax=$relax");
+	jp z, ASMPC+4
+	nop
+	jr ASMPC+3
+	nop
+	jp $+3
+	jr nc, $+2
+	ret
+END
+	check_bin_file("test.bin", pack("C*",
+				0xCA, 0x04, 0x00,			# jp z, ASMPC+4
+				0x00,
+				0x18, 0x01,					# jr ASMPC+3
+				0x00,
+				0xC3, 0x0A, 0x00,			# jp $+3
+				0x30, 0x00,					# jr nc, $+2
+				0xC9));
+}
+
+# no JR on the 8080
+z80asm("l1: jp l1", "-b -m8080 -relax=size");
+check_bin_file("test.bin", pack("C*", 0xC3, 0x00, 0x00));
+
+# messages of repeated passes shown once
+z80asm(<<'END', "-b -relax=size", 0, "", <<'END2');
+	jp l1
+	ld a, 300
+	defs 130, 0
+l1: ret
+END
+Warning at file 'test.asm' line 2: integer '300' out of range
+END2
+check_bin_file("test.bin", pack("C*", 0xC3, 0x87, 0x00, 0x3E, 0x2C, (0) x 130, 0xC9));
+
+# invalid argument
+z80asm("nop", "-b -relax=fast", 1, "", <<'END');
+Error: illegal option: fast
+END
+
+unlink_testfiles();
+done_testing();
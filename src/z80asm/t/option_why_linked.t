@@ -0,0 +1,112 @@
+#!/usr/bin/perl
+
+# Z88DK Z80 Macro Assembler
+#
+# Copyright (C) Paulo Custodio, 2011-2021
+# License: The Artistic License 2.0, http://www.perlfoundation.org/artistic_license_2_0
+# Repository: https://github.com/z88dk/z88dk/
+#
+# Test -why-linked
+
+use Modern::Perl;
+use Test::More;
+require './t/testlib.pl';
+
+unlink_testfiles();
+unlink("test.why", "test.json", "test_lib.lib");
+
+spew("test.asm", <<END);
+	section code
+	extern printf
+	call printf
+	ret
+END
+
+spew("test1.asm", <<END);
+	section code
+	public printf
+	extern ftoa, putc
+printf:	call ftoa
+	call putc
+	ret
+	section data
+	defb 1, 2, 3
+END
+
+spew("test2.asm", <<END);
+	section code
+	public ftoa
+	extern putc
+ftoa:	call putc
+	ret
+END
+
+spew("test3.asm", <<END);
+	section code
+	public putc
+putc:	ret
+END
+
+spew("test4.asm", <<END);
+	section code
+	public unused
+unused:	ret
+END
+
+run("z80asm -xtest_lib.lib test1.asm test2.asm test3.asm test4.asm");
+
+# tree
+run("z80asm -b -why-linked=tree -ltest_lib.lib test.asm");
+check_text_file("test.why", <<'END');
+test (test.asm): code 4; total 19 bytes
+    test1 (test_lib.lib) for 'printf': code 7, data 3; total 15 bytes
+        test2 (test_lib.lib) for 'ftoa': code 4; total 4 bytes
+        test3 (test_lib.lib) for 'putc': code 1; total 1 bytes
+END
+
+# json
+run("z80asm -b -why-linked=json -ltest_lib.lib test.asm");
+check_text_file("test.json", <<'END');
+{
+  "modules": [
+    { "name": "test", "file": "test.asm", "sections": { "code": 4 }, "size": 4, "total": 19 },
+    { "name": "test1", "library": "test_lib.lib", "symbol": "printf", "referenced_by": "test", "sections": { "code": 7, "data": 3 }, "size": 10, "total": 15 },
+    { "name": "test2", "library": "test_lib.lib", "symbol": "ftoa", "referenced_by": "test1", "sections": { "code": 4 }, "size": 4, "total": 4 },
+    { "name": "test3", "library": "test_lib.lib", "symbol": "putc", "referenced_by": "test1", "sections": { "code": 1 }, "size": 1, "total": 1 }
+  ]
+}
+END
+
+# sizes after -gc-sections
+spew("test.asm", <<END);
+	section code
+	extern ftoa
+	call ftoa
+	ret
+END
+spew("test2.asm", <<END);
+	section code
+__gc_split:
+	public ftoa, dtoa
+	extern putc
+ftoa:	call putc
+	ret
+dtoa:	nop
+	ret
+END
+run("z80asm -xtest_lib.lib test1.asm test2.asm test3.asm test4.asm");
+run("z80asm -b -gc-sections -why-linked=tree -ltest_lib.lib test.asm");
+check_text_file("test.why", <<'END');
+test (test.asm): code 4; total 9 bytes
+    test2 (test_lib.lib) for 'ftoa': code 4; total 5 bytes
+        test3 (test_lib.lib) for 'putc': code 1; total 1 bytes
+END
+
+# invalid argument
+z80asm("nop", "-b -why-linked=graph", 1, "", <<'END');
+Error: illegal option: graph
+END
+
+unlink_testfiles();
+unlink("test.why", "test.json", "test_lib.lib");
+done_testing();
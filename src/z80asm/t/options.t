@@ -317,12 +317,20 @@ is substr(read_file(o_file(), binmode => ':raw'), -5, 5), "\0\xFF\xFF\xFF\xFF";
 
 ok(abs((-M o_file()) - $date_obj) < 0.001);	# same object
 
-# touch source
+# touch source, same contents
 sleep 0.500;		# make sure our obj is older
 write_file(asm_file(), "nop");
 t_z80asm_capture("-d ".asm_file(), "", "", 0);
 is substr(read_file(o_file(), binmode => ':raw'), -5, 5), "\0\xFF\xFF\xFF\xFF";
 
+ok(abs((-M o_file()) - $date_obj) < 0.001);	# same object
+
+# change source
+sleep 0.500;		# make sure our obj is older
+write_file(asm_file(), "nop\nnop");
+t_z80asm_capture("-d ".asm_file(), "", "", 0);
+is substr(read_file(o_file(), binmode => ':raw'), -5, 5), "\0\xFF\xFF\xFF\xFF";
+
 ok(abs((-M o_file()) - $date_obj) > 0);	# new object
 
 # remove source, give -d -> uses existing object - with extensiom
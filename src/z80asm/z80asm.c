@@ -7,6 +7,7 @@ License: The Artistic License 2.0, http://www.perlfoundation.org/artistic_licens
 Repository: https://github.com/z88dk/z88dk
 */
 
+#include "depfile.h"
 #include "die.h"
 #include "directives.h"
 #include "fileutil.h"
@@ -16,6 +17,7 @@ Repository: https://github.com/z88dk/z88dk
 #include "modlink.h"
 #include "module.h"
 #include "parse.h"
+#include "relax.h"
 #include "strutil.h"
 #include "symbol.h"
 #include "types.h"
@@ -44,6 +46,7 @@ char *reloctable = NULL, *relocptr = NULL;
 /* local functions */
 static void query_assemble(const char *src_filename );
 static void do_assemble(const char *src_filename );
+static void parse_file_relax(const char *src_filename );
 
 /*-----------------------------------------------------------------------------
 *   Assemble one source file
@@ -139,14 +142,14 @@ static void query_assemble(const char *src_filename )
     int src_stat_result, obj_stat_result;
 	const char *obj_filename = get_obj_filename( src_filename );
 
-    /* get time stamp of files, error if source not found */
+    /* check existence of files, error if source not found */
     src_stat_result = stat( src_filename, &src_stat );		/* BUG_0033 */
     obj_stat_result = stat( obj_filename, &obj_stat );
 
     if ( opts.date_stamp &&									/* -d option */
             obj_stat_result >= 0 &&							/* object file exists */
             ( src_stat_result >= 0 ?						/* if source file exists, ... */
-              src_stat.st_mtime <= obj_stat.st_mtime		/* ... source older than object */
+              depfile_up_to_date(src_filename)				/* ... sources, includes and defines unchanged */
               : true										/* ... else source does not exist, but object exists
 															   --> consider up-to-date (e.g. test.c -> test.o) */
             ) &&
@@ -171,6 +174,7 @@ static void do_assemble(const char *src_filename )
 	const char *obj_filename = get_obj_filename(src_filename);
 
 	clear_macros();
+	depfile_start();
 
 	/* create list file */
 	if (opts.list)
@@ -185,7 +189,10 @@ static void do_assemble(const char *src_filename )
 	if (opts.verbose)
 		printf("Assembling '%s' to '%s'\n", path_canon(src_filename), path_canon(obj_filename));
 
-	parse_file(src_filename);
+	if (opts.relax == RELAX_NONE)
+		parse_file(src_filename);
+	else
+		parse_file_relax(src_filename);
 
 	list_end();						/* get_used_symbol will only generate page references until list_end() */
 
@@ -210,6 +217,14 @@ static void do_assemble(const char *src_filename )
 	if (start_errors != get_num_errors())
 		remove(get_obj_filename(src_filename));
 
+	/* list the files read, needed by -d */
+	if (opts.make_depfile || opts.date_stamp) {
+		if (start_errors == get_num_errors())
+			depfile_write(src_filename, obj_filename);
+		else
+			remove(get_dep_filename(src_filename));
+	}
+
 	close_error_file();
 
 	remove_all_local_syms();
@@ -220,6 +235,50 @@ static void do_assemble(const char *src_filename )
 		putchar('\n');    /* separate module texts */
 }
 
+/*-----------------------------------------------------------------------------
+*   Assemble the source file again while JR/JP branches change form (-relax)
+*	- messages of discarded passes are not shown
+*----------------------------------------------------------------------------*/
+static void parse_file_relax(const char *src_filename )
+{
+	int start_errors = get_num_errors();
+	bool verbose = opts.verbose;
+
+	relax_start();
+	save_module_sections();
+	asm_DEFVARS_save();
+
+	for (;;) {
+		hold_errors();
+		parse_file(src_filename);
+
+		if (start_errors != get_num_errors() || !relax_next_pass())
+			break;
+
+		/* discard the pass */
+		release_errors(false);
+		opts.verbose = false;			/* show file names only once */
+
+		clear_macros();
+		remove_all_local_syms();
+		remove_all_global_syms();
+		ExprList_remove_all(CURRENTMODULE->exprs);
+		restore_module_sections();
+		asm_DEFVARS_restore();
+
+		opts.cur_list = opts.list;
+		if (opts.list)
+			list_open(get_list_filename(src_filename));
+
+		copy_static_syms();
+		set_PC(0);
+	}
+
+	release_errors(true);
+	opts.verbose = verbose;
+	relax_end();
+}
+
 /***************************************************************************************************
  * Main entry of Z80asm
  ***************************************************************************************************/
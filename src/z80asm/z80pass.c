@@ -18,18 +18,39 @@ Repository: https://github.com/z88dk/z88dk
 /* local functions */
 void Z80pass2(void);
 
+/* write the GC_NOFALL_KW labels of the global labels to the object file */
+static void touch_gc_nofall_symbols(void)
+{
+	SymbolHashElem* iter;
+	size_t len = strlen(GC_NOFALL_KW);
+
+	for (iter = SymbolHash_first(CURRENTMODULE->local_symtab); iter != NULL; iter = SymbolHash_next(iter))
+	{
+		Symbol* marker = (Symbol*)iter->value;
+		if (strncmp(marker->name, GC_NOFALL_KW, len) == 0)
+		{
+			Symbol* sym = SymbolHash_get(global_symtab, marker->name + len);
+			if (sym != NULL && sym->is_defined &&
+				(sym->scope == SCOPE_PUBLIC || sym->scope == SCOPE_GLOBAL))
+				marker->is_touched = true;
+		}
+	}
+}
+
 void
 Z80pass2(void)
 {
 	ExprListElem* iter;
 	Expr* expr, * expr2;
 	long value;
-	bool do_patch, do_store;
+	bool do_patch, do_store, gc_split;
 	long asmpc;		// should be an int!
 
 	/* compute all dependent expressions */
 	compute_equ_exprs(CURRENTMODULE->exprs, false, true);
 
+	gc_split = find_local_symbol(GC_SPLIT_KW) != NULL;
+
 	iter = ExprList_first(CURRENTMODULE->exprs);
 	while (iter != NULL)
 	{
@@ -65,6 +86,10 @@ Z80pass2(void)
 				error_jr_not_local();	/* JR must be local */
 				do_patch = false;
 			}
+			else if (expr->type >= TYPE_ADDRESS && gc_split)
+			{
+				do_store = true;		/* -gc-sections follows the branch and moves it */
+			}
 		}
 		else if (expr->type >= TYPE_ADDRESS ||
 			expr->result.extern_symbol ||
@@ -170,6 +195,9 @@ Z80pass2(void)
 		}
 	}
 
+	if (gc_split)
+		touch_gc_nofall_symbols();
+
 	// check for undefined symbols
 	check_undefined_symbols(CURRENTMODULE->local_symtab);
 	check_undefined_symbols(global_symtab);
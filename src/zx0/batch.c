@@ -0,0 +1,450 @@
+/*
+ * Batch compression, shared by zx0 and zx7.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+
+#include "batch.h"
+
+#if defined(__GNUC__) && !defined(ZX0_NO_THREADS)
+#define BATCH_THREADS
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <pthread.h>
+#include <unistd.h>
+#endif
+#endif
+
+#define MAX_LINE 4096
+#define MAX_THREADS 64
+
+#ifndef FALSE
+#define FALSE 0
+#define TRUE 1
+#endif
+
+typedef unsigned long long HASH;
+
+typedef struct {
+    BATCH_ENTRY entry;
+    char *key;                  /* tool and flags */
+    HASH input_hash;
+    HASH output_hash;
+} JOB;
+
+typedef struct {
+    char *output;
+    char *key;
+    HASH input_hash;
+    HASH output_hash;
+    long input_size;
+    long output_size;
+    long delta;
+} CACHED;
+
+static JOB *jobs;
+static int job_count;
+static int next_job;
+
+static CACHED *cache;
+static int cache_count;
+
+static char *tool_name;
+static BATCH_COMPRESS compress_function;
+
+
+static void *batch_alloc(void *ptr, size_t size) {
+    ptr = ptr ? realloc(ptr, size) : malloc(size);
+    if (!ptr) {
+        fprintf(stderr, "Error: Insufficient memory\n");
+        exit(1);
+    }
+    return ptr;
+}
+
+static char *batch_strdup(char *str) {
+    return strcpy((char *)batch_alloc(NULL, strlen(str)+1), str);
+}
+
+/* FNV-1a, which is plenty to tell whether a file has changed */
+static HASH hash_data(unsigned char *data, long size) {
+    HASH hash = 14695981039346656037ULL;
+
+    while (size-- > 0) {
+        hash ^= *data++;
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+static unsigned char *read_file(char *name, long *size) {
+    unsigned char *data;
+    FILE *fp;
+
+    fp = fopen(name, "rb");
+    if (!fp)
+        return NULL;
+    fseek(fp, 0L, SEEK_END);
+    *size = ftell(fp);
+    fseek(fp, 0L, SEEK_SET);
+    data = (unsigned char *)batch_alloc(NULL, *size+1);
+    if (fread(data, 1, *size, fp) != (size_t)*size) {
+        free(data);
+        data = NULL;
+    }
+    fclose(fp);
+    return data;
+}
+
+/* Split the next word off a manifest line, in double quotes if it has spaces */
+static char *next_word(char **line) {
+    char *word;
+    char *ptr = *line;
+
+    while (isspace((unsigned char)*ptr))
+        ptr++;
+    if (!*ptr || *ptr == '#')
+        return NULL;
+    if (*ptr == '"') {
+        word = ++ptr;
+        while (*ptr && *ptr != '"')
+            ptr++;
+        if (!*ptr)
+            return NULL;
+    } else {
+        word = ptr;
+        while (*ptr && !isspace((unsigned char)*ptr))
+            ptr++;
+    }
+    if (*ptr)
+        *ptr++ = '\0';
+    *line = ptr;
+    return word;
+}
+
+static void read_manifest(char *manifest) {
+    char buffer[MAX_LINE];
+    char *line;
+    char *word;
+    BATCH_ENTRY *entry;
+    int key_size;
+    int line_number = 0;
+    FILE *fp;
+    int i;
+
+    fp = fopen(manifest, "r");
+    if (!fp) {
+        fprintf(stderr, "Error: Cannot access manifest %s\n", manifest);
+        exit(1);
+    }
+    while (fgets(buffer, sizeof(buffer), fp)) {
+        line_number++;
+        line = buffer;
+        if (!(word = next_word(&line)))
+            continue;
+        jobs = (JOB *)batch_alloc(jobs, (job_count+1)*sizeof(JOB));
+        memset(&jobs[job_count], 0, sizeof(JOB));
+        entry = &jobs[job_count].entry;
+        entry->line = line_number;
+        entry->input = batch_strdup(word);
+        if (!(word = next_word(&line))) {
+            fprintf(stderr, "Error: No output file for %s in %s line %d\n", entry->input, manifest, line_number);
+            exit(1);
+        }
+        entry->output = batch_strdup(word);
+        key_size = strlen(tool_name)+1;
+        while ((word = next_word(&line))) {
+            if (entry->flag_count == BATCH_MAX_FLAGS) {
+                fprintf(stderr, "Error: Too many parameters for %s in %s line %d\n", entry->input, manifest, line_number);
+                exit(1);
+            }
+            entry->flags[entry->flag_count++] = batch_strdup(word);
+            key_size += strlen(word)+1;
+        }
+
+        /* the flags are part of what the output is made from */
+        jobs[job_count].key = (char *)batch_alloc(NULL, key_size);
+        strcpy(jobs[job_count].key, tool_name);
+        for (i = 0; i < entry->flag_count; i++) {
+            strcat(jobs[job_count].key, " ");
+            strcat(jobs[job_count].key, entry->flags[i]);
+        }
+        job_count++;
+    }
+    fclose(fp);
+}
+
+/*
+ * The cache has a line for each output file:
+ *
+ *     key <tab> input hash <tab> output hash <tab> input size <tab> output size <tab> delta <tab> output
+ */
+static void read_cache(char *name) {
+    char buffer[MAX_LINE];
+    char *field[7];
+    char *ptr;
+    CACHED *cached;
+    FILE *fp;
+    int i;
+
+    fp = fopen(name, "r");
+    if (!fp)
+        return;
+    while (fgets(buffer, sizeof(buffer), fp)) {
+        buffer[strcspn(buffer, "\r\n")] = '\0';
+        for (ptr = buffer, i = 0; i < 7 && ptr; i++) {
+            field[i] = ptr;
+            if ((ptr = strchr(ptr, '\t')))
+                *ptr++ = '\0';
+        }
+        if (i < 7)
+            continue;
+        cache = (CACHED *)batch_alloc(cache, (cache_count+1)*sizeof(CACHED));
+        cached = &cache[cache_count++];
+        cached->key = batch_strdup(field[0]);
+        cached->input_hash = strtoull(field[1], NULL, 16);
+        cached->output_hash = strtoull(field[2], NULL, 16);
+        cached->input_size = atol(field[3]);
+        cached->output_size = atol(field[4]);
+        cached->delta = atol(field[5]);
+        cached->output = batch_strdup(field[6]);
+    }
+    fclose(fp);
+}
+
+static void write_cache(char *name) {
+    JOB *job;
+    FILE *fp;
+    int i;
+
+    fp = fopen(name, "w");
+    if (!fp) {
+        fprintf(stderr, "Error: Cannot create cache file %s\n", name);
+        return;
+    }
+    for (i = 0; i < job_count; i++) {
+        job = &jobs[i];
+        if (!job->entry.failed)
+            fprintf(fp, "%s\t%016llx\t%016llx\t%ld\t%ld\t%ld\t%s\n", job->key, job->input_hash, job->output_hash,
+                    job->entry.input_size, job->entry.output_size, job->entry.delta, job->entry.output);
+    }
+    fclose(fp);
+}
+
+/* Test whether the output is still the one the cache says was made from the same input and flags */
+static int from_cache(JOB *job) {
+    unsigned char *output_data;
+    CACHED *cached;
+    long output_size;
+    int i;
+
+    for (i = 0; i < cache_count; i++) {
+        cached = &cache[i];
+        if (!strcmp(cached->output, job->entry.output) && !strcmp(cached->key, job->key) &&
+                cached->input_hash == job->input_hash && cached->input_size == job->entry.input_size) {
+            if (!(output_data = read_file(job->entry.output, &output_size)))
+                return FALSE;
+            job->output_hash = hash_data(output_data, output_size);
+            free(output_data);
+            if (output_size != cached->output_size || job->output_hash != cached->output_hash)
+                return FALSE;
+            job->entry.output_size = cached->output_size;
+            job->entry.delta = cached->delta;
+            return TRUE;
+        }
+    }
+    return FALSE;
+}
+
+static void run_job(JOB *job) {
+    BATCH_ENTRY *entry = &job->entry;
+    unsigned char *input_data;
+    unsigned char *output_data;
+    FILE *fp;
+
+    if (!(input_data = read_file(entry->input, &entry->input_size))) {
+        fprintf(stderr, "Error: Cannot access input file %s\n", entry->input);
+        entry->failed = TRUE;
+        return;
+    }
+    job->input_hash = hash_data(input_data, entry->input_size);
+    if (from_cache(job)) {
+        entry->cached = TRUE;
+        free(input_data);
+        return;
+    }
+
+    if (!entry->input_size) {
+        fprintf(stderr, "Error: Empty input file %s\n", entry->input);
+        entry->failed = TRUE;
+    } else if (!compress_function(entry, input_data, entry->input_size, &output_data, &entry->output_size, &entry->delta)) {
+        entry->failed = TRUE;
+    } else {
+        job->output_hash = hash_data(output_data, entry->output_size);
+        fp = fopen(entry->output, "wb");
+        if (!fp || fwrite(output_data, 1, entry->output_size, fp) != (size_t)entry->output_size) {
+            fprintf(stderr, "Error: Cannot write output file %s\n", entry->output);
+            entry->failed = TRUE;
+        }
+        if (fp)
+            fclose(fp);
+        free(output_data);
+    }
+    free(input_data);
+}
+
+#ifdef BATCH_THREADS
+#ifdef _WIN32
+static DWORD WINAPI batch_thread(LPVOID arg) {
+#else
+static void *batch_thread(void *arg) {
+#endif
+    int i;
+
+    while ((i = __atomic_fetch_add(&next_job, 1, __ATOMIC_RELAXED)) < job_count)
+        run_job(&jobs[i]);
+    return 0;
+}
+
+static int processors(void) {
+#ifdef _WIN32
+    SYSTEM_INFO info;
+
+    GetSystemInfo(&info);
+    return info.dwNumberOfProcessors;
+#elif defined(_SC_NPROCESSORS_ONLN)
+    long count = sysconf(_SC_NPROCESSORS_ONLN);
+
+    return count > 0 ? count : 1;
+#else
+    return 1;
+#endif
+}
+
+static void run_jobs(int threads) {
+#ifdef _WIN32
+    HANDLE thread[MAX_THREADS];
+#else
+    pthread_t thread[MAX_THREADS];
+#endif
+    int count;
+
+    if (threads <= 0)
+        threads = processors();
+    if (threads > job_count)
+        threads = job_count;
+    if (threads > MAX_THREADS)
+        threads = MAX_THREADS;
+
+    /* this thread is one of them */
+    for (count = 0; count < threads-1; count++) {
+#ifdef _WIN32
+        if (!(thread[count] = CreateThread(NULL, 0, batch_thread, NULL, 0, NULL)))
+#else
+        if (pthread_create(&thread[count], NULL, batch_thread, NULL))
+#endif
+            break;
+    }
+    batch_thread(NULL);
+    while (count-- > 0) {
+#ifdef _WIN32
+        WaitForSingleObject(thread[count], INFINITE);
+        CloseHandle(thread[count]);
+#else
+        pthread_join(thread[count], NULL);
+#endif
+    }
+}
+#else
+static void run_jobs(int threads) {
+    (void)threads;
+    for (next_job = 0; next_job < job_count; next_job++)
+        run_job(&jobs[next_job]);
+}
+#endif
+
+static void write_json_string(FILE *fp, char *str) {
+    fputc('"', fp);
+    for (; *str; str++) {
+        if (*str == '"' || *str == '\\')
+            fprintf(fp, "\\%c", *str);
+        else if ((unsigned char)*str < ' ')
+            fprintf(fp, "\\u%04x", (unsigned char)*str);
+        else
+            fputc(*str, fp);
+    }
+    fputc('"', fp);
+}
+
+static int write_summary(char *name) {
+    BATCH_ENTRY *entry;
+    long input_total = 0;
+    long output_total = 0;
+    FILE *fp;
+    int i;
+
+    fp = fopen(name, "w");
+    if (!fp) {
+        fprintf(stderr, "Error: Cannot create summary file %s\n", name);
+        return FALSE;
+    }
+    fprintf(fp, "{\n  \"tool\": ");
+    write_json_string(fp, tool_name);
+    fprintf(fp, ",\n  \"files\": [\n");
+    for (i = 0; i < job_count; i++) {
+        entry = &jobs[i].entry;
+        fprintf(fp, "    { \"input\": ");
+        write_json_string(fp, entry->input);
+        fprintf(fp, ", \"output\": ");
+        write_json_string(fp, entry->output);
+        fprintf(fp, ", \"flags\": ");
+        write_json_string(fp, strchr(jobs[i].key, ' ') ? strchr(jobs[i].key, ' ')+1 : "");
+        if (entry->failed) {
+            fprintf(fp, ", \"error\": true }");
+        } else {
+            fprintf(fp, ", \"input_size\": %ld, \"output_size\": %ld, \"delta\": %ld, \"cached\": %s }",
+                    entry->input_size, entry->output_size, entry->delta, entry->cached ? "true" : "false");
+            input_total += entry->input_size;
+            output_total += entry->output_size;
+        }
+        fprintf(fp, "%s\n", i+1 < job_count ? "," : "");
+    }
+    fprintf(fp, "  ],\n  \"input_size\": %ld,\n  \"output_size\": %ld\n}\n", input_total, output_total);
+    fclose(fp);
+    return TRUE;
+}
+
+int batch(char *tool, char *manifest, char *summary, int threads, BATCH_COMPRESS compress) {
+    BATCH_ENTRY *entry;
+    char *cache_name;
+    int ok = TRUE;
+    int i;
+
+    tool_name = tool;
+    compress_function = compress;
+    read_manifest(manifest);
+
+    cache_name = (char *)batch_alloc(NULL, strlen(manifest)+7);
+    strcpy(cache_name, manifest);
+    strcat(cache_name, ".cache");
+    read_cache(cache_name);
+
+    run_jobs(threads);
+    write_cache(cache_name);
+
+    for (i = 0; i < job_count; i++) {
+        entry = &jobs[i].entry;
+        if (entry->failed)
+            ok = FALSE;
+        else if (!summary)
+            printf("File %s compressed from %ld to %ld bytes! (delta %ld)%s\n", entry->input,
+                   entry->input_size, entry->output_size, entry->delta, entry->cached ? " (cached)" : "");
+    }
+    if (summary && !write_summary(summary))
+        ok = FALSE;
+    return ok;
+}
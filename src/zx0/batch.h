@@ -0,0 +1,42 @@
+/*
+ * Batch compression, shared by zx0 and zx7.
+ *
+ * A manifest, given as @manifest, lists the files to compress, one per
+ * line:
+ *
+ *     input output [flags]
+ *
+ * where the flags are those of the compressor for a single file. Names
+ * with spaces can be put in double quotes, and everything after a # is a
+ * comment. The files are compressed in parallel, and an entry is skipped
+ * if its output is still the one made from the same input with the same
+ * flags, as recorded in the cache kept next to the manifest.
+ */
+
+#ifndef BATCH_H
+#define BATCH_H
+
+#define BATCH_MAX_FLAGS 8
+
+typedef struct {
+    char *input;
+    char *output;
+    char *flags[BATCH_MAX_FLAGS];
+    int flag_count;
+    int line;
+    long input_size;
+    long output_size;
+    long delta;
+    int cached;
+    int failed;
+} BATCH_ENTRY;
+
+/*
+ * Compress input_data, which may be changed, into a malloc'ed output_data.
+ * Returns FALSE after reporting an error.
+ */
+typedef int (*BATCH_COMPRESS)(BATCH_ENTRY *entry, unsigned char *input_data, long input_size, unsigned char **output_data, long *output_size, long *delta);
+
+int batch(char *tool, char *manifest, char *summary, int threads, BATCH_COMPRESS compress);
+
+#endif
@@ -27,28 +27,32 @@
 #include <stdlib.h>
 
 #include "zx0.h"
+#include "pack.h"
 
-unsigned char* output_data;
-int output_index;
-int input_index;
-int bit_index;
-int bit_mask;
-int diff;
-int backtrack;
+#define MAX_OFFSET_ZX0    32640
+#define MAX_OFFSET_ZX7     2176
 
-void read_bytes(int n, int *delta) {
+static THREAD_LOCAL unsigned char* output_data;
+static THREAD_LOCAL int output_index;
+static THREAD_LOCAL int input_index;
+static THREAD_LOCAL int bit_index;
+static THREAD_LOCAL int bit_mask;
+static THREAD_LOCAL int diff;
+static THREAD_LOCAL int backtrack;
+
+static void read_bytes(int n, int *delta) {
     input_index += n;
     diff += n;
     if (diff > *delta)
         *delta = diff;
 }
 
-void write_byte(int value) {
+static void write_byte(int value) {
     output_data[output_index++] = value;
     diff--;
 }
 
-void write_bit(int value) {
+static void write_bit(int value) {
     if (backtrack) {
         if (value)
             output_data[output_index-1] |= 1;
@@ -65,7 +69,7 @@ void write_bit(int value) {
     }
 }
 
-void write_interlaced_elias_gamma(int value, int backwards_mode) {
+static void write_interlaced_elias_gamma(int value, int backwards_mode) {
     int i;
 
     for (i = 2; i <= value; i <<= 1)
@@ -78,11 +82,12 @@ void write_interlaced_elias_gamma(int value, int backwards_mode) {
     write_bit(!backwards_mode);
 }
 
-unsigned char *compress(BLOCK *optimal, unsigned char *input_data, int input_size, int skip, int backwards_mode, int *output_size, int *delta) {
+unsigned char *zx0_compress(BLOCK *optimal, unsigned char *input_data, int input_size, int skip, int backwards_mode, int *output_size, int *delta) {
     BLOCK *next;
     BLOCK *prev;
     int last_offset = INITIAL_OFFSET;
     int first = TRUE;
+    int after_literals = FALSE;
     int i;
 
     /* calculate and allocate output buffer */
@@ -126,7 +131,11 @@ unsigned char *compress(BLOCK *optimal, unsigned char *input_data, int input_siz
                 write_byte(input_data[input_index]);
                 read_bytes(1, delta);
             }
-        } else if (optimal->offset == last_offset) {
+            after_literals = TRUE;
+        } else if (optimal->offset == last_offset && after_literals) {
+            /* only literals can be followed by a copy from last offset */
+            after_literals = FALSE;
+
             /* copy from last offset indicator */
             write_bit(0);
 
@@ -152,6 +161,7 @@ unsigned char *compress(BLOCK *optimal, unsigned char *input_data, int input_siz
             read_bytes(optimal->length, delta);
 
             last_offset = optimal->offset;
+            after_literals = FALSE;
         }
     }
 
@@ -161,3 +171,35 @@ unsigned char *compress(BLOCK *optimal, unsigned char *input_data, int input_siz
 
     return output_data;
 }
+
+static void reverse(unsigned char *first, unsigned char *last) {
+    unsigned char c;
+
+    while (first < last) {
+        c = *first;
+        *first++ = *last;
+        *last-- = c;
+    }
+}
+
+unsigned char *zx0_pack(unsigned char *input_data, long input_size, long skip, int backwards_mode, int quick_mode, int history_limit, int threads, long *output_size, long *delta) {
+    unsigned char *output_data;
+    int size;
+    int diff;
+
+    /* conditionally reverse input */
+    if (backwards_mode)
+        reverse(input_data, input_data+input_size-1);
+
+    output_data = zx0_compress(zx0_optimize(input_data, input_size, skip, quick_mode ? MAX_OFFSET_ZX7 : MAX_OFFSET_ZX0, history_limit, threads), input_data, input_size, skip, backwards_mode, &size, &diff);
+    free_blocks();
+
+    /* conditionally reverse input and output back */
+    if (backwards_mode) {
+        reverse(input_data, input_data+input_size-1);
+        reverse(output_data, output_data+size-1);
+    }
+    *output_size = size;
+    *delta = diff;
+    return output_data;
+}
@@ -0,0 +1,106 @@
+/*
+ * Match length tracking for the optimizer.
+ *
+ * At each index, the run of matching bytes at every offset is extended if
+ * the byte at the index matches the one at the offset, and reset if not.
+ * That is one byte compared against a window of history, so it's done 16
+ * (SSE2) or 32 (AVX2) offsets at a time where the processor allows it.
+ * The history is read backwards as the offset increases, so the compare
+ * mask is taken a bit at a time, highest first, to get the run lengths in
+ * offset order.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "zx0.h"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define MATCH_SIMD
+#include <immintrin.h>
+#endif
+
+static void match_lengths_scalar(unsigned char *input_data, int index, int first_offset, int last_offset, int *match_length) {
+    int offset;
+
+    for (offset = first_offset; offset <= last_offset; offset++) {
+        if (index >= offset && input_data[index] == input_data[index-offset])
+            match_length[offset]++;
+        else
+            match_length[offset] = 0;
+    }
+}
+
+#ifdef MATCH_SIMD
+__attribute__((target("sse2")))
+static void match_lengths_sse2(unsigned char *input_data, int index, int first_offset, int last_offset, int *match_length) {
+    const __m128i bits = _mm_set_epi32(1, 2, 4, 8);
+    const __m128i one = _mm_set1_epi32(1);
+    __m128i byte = _mm_set1_epi8((char)input_data[index]);
+    __m128i lengths;
+    __m128i mask;
+    int matches;
+    int offset;
+    int i;
+
+    for (offset = first_offset; offset+15 <= last_offset && offset+15 <= index; offset += 16) {
+        /* bit 15 is offset, bit 0 is offset+15 */
+        matches = _mm_movemask_epi8(_mm_cmpeq_epi8(byte, _mm_loadu_si128((__m128i *)(input_data+index-offset-15))));
+        for (i = 0; i < 16; i += 4) {
+            mask = _mm_set1_epi32((matches >> (12-i)) & 15);
+            mask = _mm_cmpeq_epi32(_mm_and_si128(mask, bits), bits);
+            lengths = _mm_loadu_si128((__m128i *)(match_length+offset+i));
+            lengths = _mm_and_si128(_mm_add_epi32(lengths, one), mask);
+            _mm_storeu_si128((__m128i *)(match_length+offset+i), lengths);
+        }
+    }
+    match_lengths_scalar(input_data, index, offset, last_offset, match_length);
+}
+
+__attribute__((target("avx2")))
+static void match_lengths_avx2(unsigned char *input_data, int index, int first_offset, int last_offset, int *match_length) {
+    const __m256i bits = _mm256_set_epi32(1, 2, 4, 8, 16, 32, 64, 128);
+    const __m256i one = _mm256_set1_epi32(1);
+    __m256i byte = _mm256_set1_epi8((char)input_data[index]);
+    __m256i lengths;
+    __m256i mask;
+    unsigned int matches;
+    int offset;
+    int i;
+
+    for (offset = first_offset; offset+31 <= last_offset && offset+31 <= index; offset += 32) {
+        /* bit 31 is offset, bit 0 is offset+31 */
+        matches = (unsigned int)_mm256_movemask_epi8(_mm256_cmpeq_epi8(byte, _mm256_loadu_si256((__m256i *)(input_data+index-offset-31))));
+        for (i = 0; i < 32; i += 8) {
+            mask = _mm256_set1_epi32((matches >> (24-i)) & 255);
+            mask = _mm256_cmpeq_epi32(_mm256_and_si256(mask, bits), bits);
+            lengths = _mm256_loadu_si256((__m256i *)(match_length+offset+i));
+            lengths = _mm256_and_si256(_mm256_add_epi32(lengths, one), mask);
+            _mm256_storeu_si256((__m256i *)(match_length+offset+i), lengths);
+        }
+    }
+    match_lengths_scalar(input_data, index, offset, last_offset, match_length);
+}
+#endif
+
+/* Pick the widest implementation the processor runs, unless ZX0_SIMD says otherwise */
+MATCH_FUNCTION match_function(void) {
+    char *simd = getenv("ZX0_SIMD");
+    MATCH_FUNCTION function = match_lengths_scalar;
+
+#ifdef MATCH_SIMD
+    __builtin_cpu_init();
+    if (simd && !strcmp(simd, "scalar"))
+        return function;
+    if (__builtin_cpu_supports("sse2"))
+        function = match_lengths_sse2;
+    if (simd && !strcmp(simd, "sse2"))
+        return function;
+    if (__builtin_cpu_supports("avx2"))
+        function = match_lengths_avx2;
+#else
+    (void)simd;
+#endif
+    return function;
+}
@@ -30,9 +30,90 @@
 
 #define QTY_BLOCKS 10000
 
-BLOCK *ghost_root = NULL;
-BLOCK *dead_array = NULL;
-int dead_array_size = 0;
+/*
+ * Each thread has its own free blocks, but a block may be shared by the
+ * threads so their references are counted atomically while they run.
+ */
+#ifdef ZX0_THREADS
+#define reference(block) (shared_blocks ? __atomic_add_fetch(&(block)->references, 1, __ATOMIC_RELAXED) : ++(block)->references)
+#define unreference(block) (shared_blocks ? __atomic_sub_fetch(&(block)->references, 1, __ATOMIC_ACQ_REL) : --(block)->references)
+#else
+#define reference(block) ++(block)->references
+#define unreference(block) --(block)->references
+#endif
+
+/*
+ * The blocks are carved out of arrays that are all kept in a pool, so
+ * that they can be freed together once a compression is done with them.
+ * Each thread has its own pool, except that the threads working on the
+ * same input share one.
+ */
+typedef struct arena_t {
+    struct arena_t *next;
+    BLOCK blocks[QTY_BLOCKS];
+} ARENA;
+
+struct block_pool_t {
+    ARENA *arenas;
+    long arena_count;
+};
+
+THREAD_LOCAL int shared_blocks = FALSE;
+
+static THREAD_LOCAL BLOCK_POOL own_pool;
+static THREAD_LOCAL BLOCK_POOL *pool = NULL;
+
+THREAD_LOCAL BLOCK *ghost_root = NULL;
+THREAD_LOCAL BLOCK *dead_array = NULL;
+THREAD_LOCAL int dead_array_size = 0;
+
+BLOCK_POOL *block_pool(void) {
+    return pool ? pool : &own_pool;
+}
+
+void use_block_pool(BLOCK_POOL *shared_pool) {
+    pool = shared_pool;
+}
+
+static BLOCK *new_arena(void) {
+    BLOCK_POOL *pool = block_pool();
+    ARENA *arena = (ARENA *)malloc(sizeof(ARENA));
+
+    if (!arena) {
+        fprintf(stderr, "Error: Insufficient memory\n");
+        exit(1);
+    }
+#ifdef ZX0_THREADS
+    arena->next = __atomic_load_n(&pool->arenas, __ATOMIC_RELAXED);
+    while (!__atomic_compare_exchange_n(&pool->arenas, &arena->next, arena, TRUE, __ATOMIC_RELEASE, __ATOMIC_RELAXED))
+        ;
+    __atomic_add_fetch(&pool->arena_count, 1, __ATOMIC_RELAXED);
+#else
+    arena->next = pool->arenas;
+    pool->arenas = arena;
+    pool->arena_count++;
+#endif
+    return arena->blocks;
+}
+
+long block_memory(void) {
+    return block_pool()->arena_count*(long)sizeof(ARENA);
+}
+
+/* Free all the blocks of the pool, which mustn't be used by any other thread by now */
+void free_blocks(void) {
+    BLOCK_POOL *pool = block_pool();
+    ARENA *arena;
+
+    while ((arena = pool->arenas)) {
+        pool->arenas = arena->next;
+        free(arena);
+    }
+    pool->arena_count = 0;
+    ghost_root = NULL;
+    dead_array = NULL;
+    dead_array_size = 0;
+}
 
 BLOCK *allocate(int bits, int index, int offset, int length, BLOCK *chain) {
     BLOCK *ptr;
@@ -41,18 +122,14 @@ BLOCK *allocate(int bits, int index, int offset, int length, BLOCK *chain) {
         ptr = ghost_root;
         ghost_root = ptr->ghost_chain;
         if (ptr->chain) {
-            if (!--ptr->chain->references) {
+            if (!unreference(ptr->chain)) {
                 ptr->chain->ghost_chain = ghost_root;
                 ghost_root = ptr->chain;
             }
         }
     } else {
         if (!dead_array_size) {
-            dead_array = (BLOCK *)malloc(QTY_BLOCKS*sizeof(BLOCK));
-            if (!dead_array) {
-                fprintf(stderr, "Error: Insufficient memory\n");
-                exit(1);
-            }
+            dead_array = new_arena();
             dead_array_size = QTY_BLOCKS;
         }
         ptr = &dead_array[--dead_array_size];
@@ -62,19 +139,24 @@ BLOCK *allocate(int bits, int index, int offset, int length, BLOCK *chain) {
     ptr->offset = offset;
     ptr->length = length;
     if (chain)
-        chain->references++;
+        reference(chain);
     ptr->chain = chain;
     ptr->references = 0;
     return ptr;
 }
 
 void assign(BLOCK **ptr, BLOCK *chain) {
-    chain->references++;
+    reference(chain);
+    release(ptr);
+    *ptr = chain;
+}
+
+void release(BLOCK **ptr) {
     if (*ptr) {
-        if (!--(*ptr)->references) {
+        if (!unreference(*ptr)) {
             (*ptr)->ghost_chain = ghost_root;
             ghost_root = *ptr;
         }
     }
-    *ptr = chain;
+    *ptr = NULL;
 }
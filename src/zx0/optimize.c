@@ -25,18 +25,80 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 
 #include "zx0.h"
 
+#ifdef ZX0_THREADS
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <pthread.h>
+#include <sched.h>
+#include <unistd.h>
+#endif
+#endif
+
 #define MAX_SCALE 50
 
+#define MAX_THREADS 64
+#define MIN_THREAD_OFFSETS 1024
+
 #define minimum(a,b) (a < b ? a : b)
 
-int offset_ceiling(int index, int offset_limit) {
+/*
+ * Each index is worked on by splitting its offsets into consecutive
+ * ranges, one per thread. A thread keeps its cheapest block ending at the
+ * index, the first it found of those with the fewest bits, and the main
+ * thread takes the first cheapest of those in range order. That's the
+ * block the single threaded loop would have chosen, so the output doesn't
+ * depend on the number of threads.
+ */
+typedef struct optimizer_t OPTIMIZER;
+
+typedef struct {
+    OPTIMIZER *optimizer;
+    int first_offset;
+    int last_offset;
+    int *best_length;
+    BLOCK *best;
+#ifdef ZX0_THREADS
+#ifdef _WIN32
+    HANDLE thread;
+#else
+    pthread_t thread;
+#endif
+#endif
+} WORKER;
+
+/* What the threads working on one input share */
+struct optimizer_t {
+    unsigned char *input_data;
+    int skip;
+    BLOCK **last_literal;
+    BLOCK **last_match;
+    BLOCK **optimal;
+    int optimal_mask;
+    int history;
+    int *match_length;
+    MATCH_FUNCTION match_lengths;
+    int index;
+    BLOCK_POOL *blocks;
+    WORKER workers[MAX_THREADS];
+    int worker_count;
+    volatile int generation;
+    volatile int finished;
+    volatile int stopping;
+};
+
+THREAD_LOCAL long optimize_memory;
+int show_progress = TRUE;
+
+static int offset_ceiling(int index, int offset_limit) {
     return index > offset_limit ? offset_limit : index < INITIAL_OFFSET ? INITIAL_OFFSET : index;
 }
 
-int elias_gamma_bits(int value) {
+static int elias_gamma_bits(int value) {
     int bits = 1;
     while (value > 1) {
         bits += 2;
@@ -45,96 +107,317 @@ int elias_gamma_bits(int value) {
     return bits;
 }
 
-BLOCK* optimize(unsigned char *input_data, int input_size, int skip, int offset_limit) {
-    BLOCK **last_literal;
-    BLOCK **last_match;
-    BLOCK **optimal;
-    int* match_length;
-    int* best_length;
-    int best_length_size;
+static inline void candidate(WORKER *worker, BLOCK *block) {
+    if (!worker->best || worker->best->bits > block->bits)
+        assign(&worker->best, block);
+}
+
+static void optimize_offsets(WORKER *worker) {
+    OPTIMIZER *optimizer = worker->optimizer;
+    unsigned char *input_data = optimizer->input_data;
+    BLOCK **last_literal = optimizer->last_literal;
+    BLOCK **last_match = optimizer->last_match;
+    BLOCK **optimal = optimizer->optimal;
+    int* match_length = optimizer->match_length;
+    int* best_length = worker->best_length;
+    int best_length_size = 2;
+    int skip = optimizer->skip;
+    int index = optimizer->index;
+    int mask = optimizer->optimal_mask;
+    int history = optimizer->history;
+    int run;
     int bits;
-    int index;
     int offset;
     int length;
     int bits2;
+
+    if (index != skip)
+        optimizer->match_lengths(input_data, index, worker->first_offset, worker->last_offset, match_length);
+    else if (worker->first_offset <= worker->last_offset)
+        memset(match_length+worker->first_offset, 0, (worker->last_offset-worker->first_offset+1)*sizeof(int));
+
+    for (offset = worker->first_offset; offset <= worker->last_offset; offset++) {
+        if (match_length[offset]) {
+            /* copy from last offset */
+            if (last_literal[offset]) {
+                length = index-last_literal[offset]->index;
+                bits = last_literal[offset]->bits + 1 + elias_gamma_bits(length);
+                assign(&(last_match[offset]), allocate(bits, index, offset, length, last_literal[offset]));
+                candidate(worker, last_match[offset]);
+            }
+            /* copy from new offset */
+            if (match_length[offset] > 1) {
+                run = minimum(match_length[offset], history);
+                if (best_length_size < run) {
+                    bits = optimal[(index-best_length[best_length_size]) & mask]->bits + elias_gamma_bits(best_length[best_length_size]-1);
+                    do {
+                        best_length_size++;
+                        bits2 = optimal[(index-best_length_size) & mask]->bits + elias_gamma_bits(best_length_size-1);
+                        if (bits2 <= bits) {
+                            best_length[best_length_size] = best_length_size;
+                            bits = bits2;
+                        } else {
+                            best_length[best_length_size] = best_length[best_length_size-1];
+                        }
+                    } while(best_length_size < run);
+                }
+                length = best_length[run];
+                bits = optimal[(index-length) & mask]->bits + 8 + elias_gamma_bits((offset-1)/128+1) + elias_gamma_bits(length-1);
+                if (!last_match[offset] || last_match[offset]->index != index || last_match[offset]->bits > bits) {
+                    assign(&last_match[offset], allocate(bits, index, offset, length, optimal[(index-length) & mask]));
+                    candidate(worker, last_match[offset]);
+                }
+            }
+        } else {
+            /* copy literals */
+            if (last_match[offset]) {
+                length = index-last_match[offset]->index;
+                bits = last_match[offset]->bits + 1 + elias_gamma_bits(length) + length*8;
+                assign(&(last_literal[offset]), allocate(bits, index, 0, length, last_match[offset]));
+                candidate(worker, last_literal[offset]);
+            }
+        }
+    }
+}
+
+#ifdef ZX0_THREADS
+/*
+ * The workers wait for each index by spinning on a generation count, as
+ * an index takes too little time for anything heavier.
+ */
+static void pause_thread(int *spins) {
+    if (++*spins > 1000) {
+#ifdef _WIN32
+        SwitchToThread();
+#else
+        sched_yield();
+#endif
+    }
+}
+
+#ifdef _WIN32
+static DWORD WINAPI worker_thread(LPVOID arg) {
+#else
+static void *worker_thread(void *arg) {
+#endif
+    WORKER *worker = (WORKER *)arg;
+    OPTIMIZER *optimizer = worker->optimizer;
+    int seen = 0;
+    int spins;
+
+    use_block_pool(optimizer->blocks);
+    shared_blocks = TRUE;
+    for (;;) {
+        spins = 0;
+        while (__atomic_load_n(&optimizer->generation, __ATOMIC_ACQUIRE) == seen)
+            pause_thread(&spins);
+        seen++;
+        if (optimizer->stopping)
+            break;
+        optimize_offsets(worker);
+        __atomic_add_fetch(&optimizer->finished, 1, __ATOMIC_RELEASE);
+    }
+    return 0;
+}
+
+static void start_workers(OPTIMIZER *optimizer) {
+    WORKER *workers = optimizer->workers;
+    int i;
+
+    optimizer->generation = 0;
+    optimizer->stopping = FALSE;
+    for (i = 1; i < optimizer->worker_count; i++) {
+#ifdef _WIN32
+        workers[i].thread = CreateThread(NULL, 0, worker_thread, &workers[i], 0, NULL);
+        if (!workers[i].thread) {
+#else
+        if (pthread_create(&workers[i].thread, NULL, worker_thread, &workers[i])) {
+#endif
+            optimizer->worker_count = i;
+            break;
+        }
+    }
+}
+
+static void stop_workers(OPTIMIZER *optimizer) {
+    WORKER *workers = optimizer->workers;
+    int i;
+
+    optimizer->stopping = TRUE;
+    __atomic_add_fetch(&optimizer->generation, 1, __ATOMIC_RELEASE);
+    for (i = 1; i < optimizer->worker_count; i++) {
+#ifdef _WIN32
+        WaitForSingleObject(workers[i].thread, INFINITE);
+        CloseHandle(workers[i].thread);
+#else
+        pthread_join(workers[i].thread, NULL);
+#endif
+    }
+}
+
+/* Work on the index in all the threads */
+static void run_workers(OPTIMIZER *optimizer) {
+    int spins = 0;
+
+    optimizer->finished = 0;
+    __atomic_add_fetch(&optimizer->generation, 1, __ATOMIC_RELEASE);
+    optimize_offsets(&optimizer->workers[0]);
+    while (__atomic_load_n(&optimizer->finished, __ATOMIC_ACQUIRE) != optimizer->worker_count-1)
+        pause_thread(&spins);
+}
+
+int processor_count(void) {
+#ifdef _WIN32
+    SYSTEM_INFO info;
+
+    GetSystemInfo(&info);
+    return info.dwNumberOfProcessors;
+#elif defined(_SC_NPROCESSORS_ONLN)
+    long count = sysconf(_SC_NPROCESSORS_ONLN);
+
+    return count > 0 ? count : 1;
+#else
+    return 1;
+#endif
+}
+#else
+int processor_count(void) {
+    return 1;
+}
+#endif
+
+BLOCK* zx0_optimize(unsigned char *input_data, int input_size, int skip, int offset_limit, int history_limit, int threads) {
+    OPTIMIZER optimizer;
+    WORKER *workers = optimizer.workers;
+    WORKER *worker;
+    BLOCK **last_match;
+    BLOCK **optimal;
+    BLOCK *result;
+    int optimal_size;
+    int optimal_mask;
+    int history;
+    int worker_count;
+    int index;
+    int active;
+    int chunk;
+    int i;
     int dots = 2;
     int max_offset = offset_ceiling(input_size-1, offset_limit);
 
+    /*
+     * A match is never longer than the history, so the cheapest blocks
+     * ending at the indexes before that can be let go, and their chains
+     * reused unless something later is built on them.
+     */
+    history = history_limit > 0 && history_limit < input_size ? history_limit : input_size;
+    for (optimal_size = 4; optimal_size <= history; optimal_size <<= 1)
+        ;
+    optimal_mask = optimal_size-1;
+
     /* allocate all main data structures at once */
-    last_literal = (BLOCK **)calloc(max_offset+1, sizeof(BLOCK *));
-    last_match = (BLOCK **)calloc(max_offset+1, sizeof(BLOCK *));
-    optimal = (BLOCK **)calloc(input_size+1, sizeof(BLOCK *));
-    match_length = (int *)calloc(max_offset+1, sizeof(int));
-    best_length = (int *)malloc((input_size+1)*sizeof(int));
-    if (!last_literal || !last_match || !optimal || !match_length || !best_length) {
+    optimizer.input_data = input_data;
+    optimizer.skip = skip;
+    optimizer.last_literal = (BLOCK **)calloc(max_offset+1, sizeof(BLOCK *));
+    optimizer.last_match = last_match = (BLOCK **)calloc(max_offset+1, sizeof(BLOCK *));
+    optimizer.optimal = optimal = (BLOCK **)calloc(optimal_size, sizeof(BLOCK *));
+    optimizer.optimal_mask = optimal_mask;
+    optimizer.history = history;
+    optimizer.match_length = (int *)calloc(max_offset+1, sizeof(int));
+    optimizer.match_lengths = match_function();
+    optimizer.blocks = block_pool();
+    if (!optimizer.last_literal || !last_match || !optimal || !optimizer.match_length) {
          fprintf(stderr, "Error: Insufficient memory\n");
          exit(1);
     }
-    best_length[2] = 2;
+
+    /* there's no point in threads that would have too few offsets each */
+#ifdef ZX0_THREADS
+    worker_count = minimum(threads, max_offset/MIN_THREAD_OFFSETS);
+    worker_count = worker_count < 1 ? 1 : minimum(worker_count, MAX_THREADS);
+#else
+    worker_count = 1;
+#endif
+    optimizer.worker_count = worker_count;
+    for (i = 0; i < worker_count; i++) {
+        workers[i].optimizer = &optimizer;
+        workers[i].best = NULL;
+        workers[i].best_length = (int *)malloc((history+3)*sizeof(int));
+        if (!workers[i].best_length) {
+             fprintf(stderr, "Error: Insufficient memory\n");
+             exit(1);
+        }
+        workers[i].best_length[2] = 2;
+    }
+#ifdef ZX0_THREADS
+    start_workers(&optimizer);
+    worker_count = optimizer.worker_count;
+    shared_blocks = worker_count > 1;
+#endif
 
     /* start with fake block */
     assign(&(last_match[INITIAL_OFFSET]), allocate(-1, skip-1, INITIAL_OFFSET, 0, NULL));
 
-    printf("[");
+    if (show_progress)
+        printf("[");
 
     /* process remaining bytes */
     for (index = skip; index < input_size; index++) {
-        best_length_size = 2;
+        optimizer.index = index;
+        release(&(optimal[index & optimal_mask]));
         max_offset = offset_ceiling(index, offset_limit);
-        for (offset = 1; offset <= max_offset; offset++) {
-            if (index != skip && index >= offset && input_data[index] == input_data[index-offset]) {
-                /* copy from last offset */
-                if (last_literal[offset]) {
-                    length = index-last_literal[offset]->index;
-                    bits = last_literal[offset]->bits + 1 + elias_gamma_bits(length);
-                    assign(&(last_match[offset]), allocate(bits, index, offset, length, last_literal[offset]));
-                    if (!optimal[index] || optimal[index]->bits > bits)
-                        assign(&(optimal[index]), last_match[offset]);
-                }
-                /* copy from new offset */
-                if (++match_length[offset] > 1) {
-                    if (best_length_size < match_length[offset]) {
-                        bits = optimal[index-best_length[best_length_size]]->bits + elias_gamma_bits(best_length[best_length_size]-1);
-                        do {
-                            best_length_size++;
-                            bits2 = optimal[index-best_length_size]->bits + elias_gamma_bits(best_length_size-1);
-                            if (bits2 <= bits) {
-                                best_length[best_length_size] = best_length_size;
-                                bits = bits2;
-                            } else {
-                                best_length[best_length_size] = best_length[best_length_size-1];
-                            }
-                        } while(best_length_size < match_length[offset]);
-                    }
-                    length = best_length[match_length[offset]];
-                    bits = optimal[index-length]->bits + 8 + elias_gamma_bits((offset-1)/128+1) + elias_gamma_bits(length-1);
-                    if (!last_match[offset] || last_match[offset]->index != index || last_match[offset]->bits > bits) {
-                        assign(&last_match[offset], allocate(bits, index, offset, length, optimal[index-length]));
-                        if (!optimal[index] || optimal[index]->bits > bits)
-                            assign(&(optimal[index]), last_match[offset]);
-                    }
-                }
-            } else {
-                /* copy literals */
-                match_length[offset] = 0;
-                if (last_match[offset]) {
-                    length = index-last_match[offset]->index;
-                    bits = last_match[offset]->bits + 1 + elias_gamma_bits(length) + length*8;
-                    assign(&(last_literal[offset]), allocate(bits, index, 0, length, last_match[offset]));
-                    if (!optimal[index] || optimal[index]->bits > bits)
-                        assign(&(optimal[index]), last_literal[offset]);
-                }
+        active = minimum(worker_count, max_offset/MIN_THREAD_OFFSETS);
+        if (active < 2) {
+            workers[0].first_offset = 1;
+            workers[0].last_offset = max_offset;
+            optimize_offsets(&workers[0]);
+        } else {
+            /* the threads beyond those needed for this index have nothing to do */
+            chunk = (max_offset+active-1)/active;
+            for (i = 0; i < worker_count; i++) {
+                workers[i].first_offset = i*chunk+1;
+                workers[i].last_offset = minimum((i+1)*chunk, max_offset);
+            }
+#ifdef ZX0_THREADS
+            run_workers(&optimizer);
+#endif
+        }
+
+        for (i = 0; i < worker_count; i++) {
+            worker = &workers[i];
+            if (worker->best) {
+                if (!optimal[index & optimal_mask] || optimal[index & optimal_mask]->bits > worker->best->bits)
+                    assign(&(optimal[index & optimal_mask]), worker->best);
+                release(&worker->best);
             }
         }
 
-        if (index*MAX_SCALE/input_size > dots) {
+        if (show_progress && index*MAX_SCALE/input_size > dots) {
             printf(".");
             fflush(stdout);
             dots++;
         }
     }
 
-    printf("]\n");
+    if (show_progress)
+        printf("]\n");
+
+#ifdef ZX0_THREADS
+    stop_workers(&optimizer);
+    shared_blocks = FALSE;
+#endif
+    for (i = 0; i < worker_count; i++)
+        free(workers[i].best_length);
+
+    /* nothing is freed before the end, so the memory used now is the most used */
+    max_offset = offset_ceiling(input_size-1, offset_limit);
+    optimize_memory = block_memory() + (long)(max_offset+1)*(2*sizeof(BLOCK *)+sizeof(int)) +
+                      optimal_size*(long)sizeof(BLOCK *) + worker_count*(history+3)*(long)sizeof(int);
+
+    result = optimal[(input_size-1) & optimal_mask];
+    free(optimizer.last_literal);
+    free(last_match);
+    free(optimal);
+    free(optimizer.match_length);
 
-    return optimal[input_size-1];
+    return result;
 }
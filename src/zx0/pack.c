@@ -0,0 +1,177 @@
+/*
+ * In-memory compression with a cache, for the tools that link zx0 and zx7.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#ifdef _WIN32
+#include <process.h>
+#define getpid _getpid
+#else
+#include <unistd.h>
+#endif
+
+#include "zx0.h"
+#include "pack.h"
+
+#define PACK_CACHE_ENV "Z88DK_PACK_CACHE"
+
+typedef unsigned long long HASH;
+
+typedef struct pack_entry_t {
+    struct pack_entry_t *next;
+    int method;
+    HASH input_hash;
+    long input_size;
+    unsigned char *output_data;
+    long output_size;
+} PACK_ENTRY;
+
+static char *method_names[] = { "zx0", "zx0_back", "zx7", "zx7_back" };
+
+#define METHOD_COUNT ((int)(sizeof(method_names)/sizeof(method_names[0])))
+
+static PACK_ENTRY *cache;
+
+
+static void *pack_alloc(size_t size) {
+    void *ptr = malloc(size ? size : 1);
+
+    if (!ptr) {
+        fprintf(stderr, "Error: Insufficient memory\n");
+        exit(1);
+    }
+    return ptr;
+}
+
+/* FNV-1a, as for the manifest cache */
+static HASH hash_data(unsigned char *data, long size) {
+    HASH hash = 14695981039346656037ULL;
+
+    while (size-- > 0) {
+        hash ^= *data++;
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+int pack_method(const char *name) {
+    int method;
+
+    for (method = 0; method < METHOD_COUNT; method++)
+        if (!strcmp(name, method_names[method]))
+            return method;
+    return -1;
+}
+
+const char *pack_method_name(int method) {
+    return method >= 0 && method < METHOD_COUNT ? method_names[method] : NULL;
+}
+
+static void cache_file_name(char *name, size_t size, char *dir, PACK_ENTRY *entry) {
+    snprintf(name, size, "%s/%016llx-%ld.%s", dir, entry->input_hash, entry->input_size, method_names[entry->method]);
+}
+
+/* Read a result saved by an earlier run */
+static int read_cache_file(char *dir, PACK_ENTRY *entry) {
+    char name[FILENAME_MAX];
+    FILE *fp;
+    long size;
+
+    cache_file_name(name, sizeof(name), dir, entry);
+    fp = fopen(name, "rb");
+    if (!fp)
+        return FALSE;
+    fseek(fp, 0L, SEEK_END);
+    size = ftell(fp);
+    fseek(fp, 0L, SEEK_SET);
+    if (size <= 0) {
+        fclose(fp);
+        return FALSE;
+    }
+    entry->output_data = (unsigned char *)pack_alloc(size);
+    if (fread(entry->output_data, 1, size, fp) != (size_t)size) {
+        free(entry->output_data);
+        fclose(fp);
+        return FALSE;
+    }
+    fclose(fp);
+    entry->output_size = size;
+    return TRUE;
+}
+
+/* Save a result, under a temporary name so that another build never reads half of it */
+static void write_cache_file(char *dir, PACK_ENTRY *entry) {
+    char name[FILENAME_MAX];
+    char temp_name[FILENAME_MAX+16];
+    FILE *fp;
+
+    cache_file_name(name, sizeof(name), dir, entry);
+    snprintf(temp_name, sizeof(temp_name), "%s.%d.tmp", name, (int)getpid());
+    fp = fopen(temp_name, "wb");
+    if (!fp)
+        return;
+    if (fwrite(entry->output_data, 1, entry->output_size, fp) != (size_t)entry->output_size) {
+        fclose(fp);
+        remove(temp_name);
+        return;
+    }
+    fclose(fp);
+    if (rename(temp_name, name))
+        remove(temp_name);
+}
+
+static void compress_entry(PACK_ENTRY *entry, unsigned char *input_data) {
+    long delta;
+
+    show_progress = FALSE;
+    switch (entry->method) {
+    case PACK_ZX0:
+    case PACK_ZX0_BACK:
+        entry->output_data = zx0_pack(input_data, entry->input_size, 0, entry->method == PACK_ZX0_BACK, FALSE, 0, 1, &entry->output_size, &delta);
+        break;
+    default:
+        entry->output_data = zx7_pack(input_data, entry->input_size, 0, entry->method == PACK_ZX7_BACK, &entry->output_size, &delta);
+        break;
+    }
+}
+
+unsigned char *pack(int method, unsigned char *input_data, long input_size, long *output_size) {
+    PACK_ENTRY *entry;
+    unsigned char *output_data;
+    HASH input_hash;
+    char *dir;
+
+    if (input_size <= 0 || !pack_method_name(method))
+        return NULL;
+
+    input_hash = hash_data(input_data, input_size);
+    for (entry = cache; entry; entry = entry->next)
+        if (entry->method == method && entry->input_hash == input_hash && entry->input_size == input_size)
+            break;
+
+    if (!entry) {
+        entry = (PACK_ENTRY *)pack_alloc(sizeof(PACK_ENTRY));
+        entry->method = method;
+        entry->input_hash = input_hash;
+        entry->input_size = input_size;
+
+        dir = getenv(PACK_CACHE_ENV);
+        if (dir && *dir) {
+            if (!read_cache_file(dir, entry)) {
+                compress_entry(entry, input_data);
+                write_cache_file(dir, entry);
+            }
+        } else {
+            compress_entry(entry, input_data);
+        }
+        entry->next = cache;
+        cache = entry;
+    }
+
+    output_data = (unsigned char *)pack_alloc(entry->output_size);
+    memcpy(output_data, entry->output_data, entry->output_size);
+    *output_size = entry->output_size;
+    return output_data;
+}
@@ -0,0 +1,36 @@
+/*
+ * In-memory compression, for the tools that link the compressors in.
+ *
+ * zx0_pack() and zx7_pack() compress input_data into a malloc'ed buffer,
+ * reporting the delta needed for in-place decompression. The input is
+ * reversed while compressing backwards but is left as it was found.
+ *
+ * pack() compresses with a method named in the source or on the command
+ * line, and caches the result by a hash of the input, in memory and, when
+ * Z88DK_PACK_CACHE names a directory, on disk, so that the same data is
+ * only compressed once between builds.
+ */
+
+#ifndef PACK_H
+#define PACK_H
+
+enum {
+    PACK_ZX0,
+    PACK_ZX0_BACK,
+    PACK_ZX7,
+    PACK_ZX7_BACK
+};
+
+unsigned char *zx0_pack(unsigned char *input_data, long input_size, long skip, int backwards_mode, int quick_mode, int history_limit, int threads, long *output_size, long *delta);
+
+unsigned char *zx7_pack(unsigned char *input_data, long input_size, long skip, int backwards_mode, long *output_size, long *delta);
+
+/* Look up a method by name, -1 if there is no such method */
+int pack_method(const char *name);
+
+const char *pack_method_name(int method);
+
+/* Compress into a malloc'ed buffer, NULL if there is no input */
+unsigned char *pack(int method, unsigned char *input_data, long input_size, long *output_size);
+
+#endif
@@ -28,18 +28,40 @@
 #include <string.h>
 
 #include "zx0.h"
+#include "batch.h"
+#include "pack.h"
 
-#define MAX_OFFSET_ZX0    32640
-#define MAX_OFFSET_ZX7     2176
-
-void reverse(unsigned char *first, unsigned char *last) {
-    unsigned char c;
+/* Compress a file from a manifest, with its own flags */
+int batch_compress(BATCH_ENTRY *entry, unsigned char *input_data, long input_size, unsigned char **output_data, long *output_size, long *delta) {
+    int skip = 0;
+    int quick_mode = FALSE;
+    int backwards_mode = FALSE;
+    int history_limit = 0;
+    char *flag;
+    int i;
 
-    while (first < last) {
-        c = *first;
-        *first++ = *last;
-        *last-- = c;
+    for (i = 0; i < entry->flag_count; i++) {
+        flag = entry->flags[i];
+        if (!strcmp(flag, "-q")) {
+            quick_mode = TRUE;
+        } else if (!strcmp(flag, "-b")) {
+            backwards_mode = TRUE;
+        } else if (!strncmp(flag, "-m", 2) && atoi(flag+2) >= 2) {
+            history_limit = atoi(flag+2);
+        } else if (*flag == '+' && atoi(flag) > 0) {
+            skip = atoi(flag);
+        } else {
+            fprintf(stderr, "Error: Invalid parameter %s for %s\n", flag, entry->input);
+            return FALSE;
+        }
     }
+    if (skip >= input_size) {
+        fprintf(stderr, "Error: Skipping entire input file %s\n", entry->input);
+        return FALSE;
+    }
+
+    *output_data = zx0_pack(input_data, input_size, skip, backwards_mode, quick_mode, history_limit, 1, output_size, delta);
+    return TRUE;
 }
 
 int main(int argc, char *argv[]) {
@@ -47,16 +69,18 @@ int main(int argc, char *argv[]) {
     int forced_mode = FALSE;
     int quick_mode = FALSE;
     int backwards_mode = FALSE;
+    int threads = processor_count();
+    int history_limit = 0;
     char *output_name;
     unsigned char *input_data;
     unsigned char *output_data;
     FILE *ifp;
     FILE *ofp;
     int input_size;
-    int output_size;
+    long output_size;
     int partial_counter;
     int total_counter;
-    int delta;
+    long delta;
     int i;
 
     printf("ZX0 v1.5: Optimal data compressor by Einar Saukas\n");
@@ -69,12 +93,28 @@ int main(int argc, char *argv[]) {
             quick_mode = TRUE;
         } else if (!strcmp(argv[i], "-b")) {
             backwards_mode = TRUE;
+        } else if (!strncmp(argv[i], "-m", 2)) {
+            if ((history_limit = atoi(argv[i]+2)) < 2) {
+                fprintf(stderr, "Error: Invalid parameter %s\n", argv[i]);
+                exit(1);
+            }
+        } else if (!strncmp(argv[i], "-j", 2)) {
+            if ((threads = atoi(argv[i]+2)) <= 0) {
+                fprintf(stderr, "Error: Invalid parameter %s\n", argv[i]);
+                exit(1);
+            }
         } else if ((skip = atoi(argv[i])) <= 0) {
             fprintf(stderr, "Error: Invalid parameter %s\n", argv[i]);
             exit(1);
         }
     }
 
+    /* compress the files in a manifest, each in one thread */
+    if (i < argc && *argv[i] == '@' && argc <= i+2) {
+        show_progress = FALSE;
+        return batch("zx0", argv[i]+1, argc == i+2 ? argv[i+1] : NULL, threads, batch_compress) ? 0 : 1;
+    }
+
     /* determine output filename */
     if (argc == i+1) {
         output_name = (char *)malloc(strlen(argv[i])+5);
@@ -83,10 +123,14 @@ int main(int argc, char *argv[]) {
     } else if (argc == i+2) {
         output_name = argv[i+1];
     } else {
-        fprintf(stderr, "Usage: %s [-f] [-b] [-q] input [output.zx0]\n"
+        fprintf(stderr, "Usage: %s [-f] [-b] [-q] [-m<n>] [-j<n>] input [output.zx0]\n"
+                        "       %s [-j<n>] @manifest [summary.json]\n"
                         "  -f      Force overwrite of output file\n"
                         "  -b      Compress backwards\n"
-                        "  -q      Quick non-optimal compression\n", argv[0]);
+                        "  -q      Quick non-optimal compression\n"
+                        "  -m<n>   Bounded memory, matches no longer than n bytes\n"
+                        "  -j<n>   Use n threads (default: one per processor)\n"
+                        "  @manifest  Compress the files listed as: input output [-b] [-q] [-m<n>] [+skip]\n", argv[0], argv[0]);
         exit(1);
     }
 
@@ -146,16 +190,8 @@ int main(int argc, char *argv[]) {
         exit(1);
     }
 
-    /* conditionally reverse input file */
-    if (backwards_mode)
-        reverse(input_data, input_data+input_size-1);
-
     /* generate output file */
-    output_data = compress(optimize(input_data, input_size, skip, quick_mode ? MAX_OFFSET_ZX7 : MAX_OFFSET_ZX0), input_data, input_size, skip, backwards_mode, &output_size, &delta);
-
-    /* conditionally reverse output file */
-    if (backwards_mode)
-        reverse(output_data, output_data+output_size-1);
+    output_data = zx0_pack(input_data, input_size, skip, backwards_mode, quick_mode, history_limit, threads, &output_size, &delta);
 
     /* write output file */
     if (fwrite(output_data, sizeof(char), output_size, ofp) != output_size) {
@@ -167,7 +203,9 @@ int main(int argc, char *argv[]) {
     fclose(ofp);
 
     /* done! */
-    printf("File%s compressed%s from %d to %d bytes! (delta %d)\n", (skip ? " partially" : ""), (backwards_mode ? " backwards" : ""), input_size-skip, output_size, delta);
+    printf("File%s compressed%s from %d to %ld bytes! (delta %ld)\n", (skip ? " partially" : ""), (backwards_mode ? " backwards" : ""), input_size-skip, output_size, delta);
+    if (history_limit)
+        printf("Peak memory %ld KB\n", (optimize_memory+1023)/1024);
 
     return 0;
 }
@@ -25,6 +25,14 @@
 
 #define INITIAL_OFFSET 1
 
+/* The optimizer threads need the gcc atomic builtins */
+#if defined(__GNUC__) && !defined(ZX0_NO_THREADS)
+#define ZX0_THREADS
+#define THREAD_LOCAL __thread
+#else
+#define THREAD_LOCAL
+#endif
+
 #define FALSE 0
 #define TRUE 1
 
@@ -38,10 +46,34 @@ typedef struct block_t {
     int references;
 } BLOCK;
 
+typedef struct block_pool_t BLOCK_POOL;
+
+typedef void (*MATCH_FUNCTION)(unsigned char *input_data, int index, int first_offset, int last_offset, int *match_length);
+
+extern THREAD_LOCAL int shared_blocks;
+
 BLOCK *allocate(int bits, int index, int offset, int length, BLOCK *chain);
 
 void assign(BLOCK **ptr, BLOCK *chain);
 
-BLOCK *optimize(unsigned char *input_data, int input_size, int skip, int offset_limit);
+void release(BLOCK **ptr);
+
+BLOCK_POOL *block_pool(void);
+
+void use_block_pool(BLOCK_POOL *pool);
+
+long block_memory(void);
+
+void free_blocks(void);
+
+int processor_count(void);
+
+MATCH_FUNCTION match_function(void);
+
+extern THREAD_LOCAL long optimize_memory;
+
+extern int show_progress;
+
+BLOCK *zx0_optimize(unsigned char *input_data, int input_size, int skip, int offset_limit, int history_limit, int threads);
 
-unsigned char *compress(BLOCK *optimal, unsigned char *input_data, int input_size, int skip, int backwards_mode, int *output_size, int *delta);
+unsigned char *zx0_compress(BLOCK *optimal, unsigned char *input_data, int input_size, int skip, int backwards_mode, int *output_size, int *delta);
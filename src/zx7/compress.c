@@ -27,25 +27,26 @@
 #include <stdlib.h>
 
 #include "zx7.h"
+#include "../zx0/pack.h"
 
-unsigned char* output_data;
-size_t output_index;
-size_t bit_index;
-int bit_mask;
-long diff;
+static THREAD_LOCAL unsigned char* output_data;
+static THREAD_LOCAL size_t output_index;
+static THREAD_LOCAL size_t bit_index;
+static THREAD_LOCAL int bit_mask;
+static THREAD_LOCAL long diff;
 
-void read_bytes(int n, long *delta) {
+static void read_bytes(int n, long *delta) {
    diff += n;
    if (diff > *delta)
        *delta = diff;
 }
 
-void write_byte(int value) {
+static void write_byte(int value) {
     output_data[output_index++] = value;
     diff--;
 }
 
-void write_bit(int value) {
+static void write_bit(int value) {
     if (bit_mask == 0) {
         bit_mask = 128;
         bit_index = output_index;
@@ -57,7 +58,7 @@ void write_bit(int value) {
     bit_mask >>= 1;
 }
 
-void write_elias_gamma(int value) {
+static void write_elias_gamma(int value) {
     int i;
 
     for (i = 2; i <= value; i <<= 1) {
@@ -68,7 +69,7 @@ void write_elias_gamma(int value) {
     }
 }
 
-unsigned char *compress(Optimal *optimal, unsigned char *input_data, size_t input_size, long skip, size_t *output_size, long *delta) {
+unsigned char *zx7_compress(Optimal *optimal, unsigned char *input_data, size_t input_size, long skip, size_t *output_size, long *delta) {
     size_t input_index;
     size_t input_prev;
     int offset1;
@@ -148,3 +149,36 @@ unsigned char *compress(Optimal *optimal, unsigned char *input_data, size_t inpu
 
     return output_data;
 }
+
+static void reverse(unsigned char *first, unsigned char *last) {
+    unsigned char c;
+
+    while (first < last) {
+        c = *first;
+        *first++ = *last;
+        *last-- = c;
+    }
+}
+
+unsigned char *zx7_pack(unsigned char *input_data, long input_size, long skip, int backwards_mode, long *output_size, long *delta) {
+    unsigned char *output_data;
+    Optimal *optimal;
+    size_t size;
+
+    /* conditionally reverse input */
+    if (backwards_mode) {
+        reverse(input_data, input_data+input_size-1);
+    }
+
+    optimal = zx7_optimize(input_data, input_size, skip);
+    output_data = zx7_compress(optimal, input_data, input_size, skip, &size, delta);
+    free(optimal);
+
+    /* conditionally reverse input and output back */
+    if (backwards_mode) {
+        reverse(input_data, input_data+input_size-1);
+        reverse(output_data, output_data+size-1);
+    }
+    *output_size = size;
+    return output_data;
+}
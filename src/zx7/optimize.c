@@ -28,7 +28,7 @@
 
 #include "zx7.h"
 
-int elias_gamma_bits(int value) {
+static int elias_gamma_bits(int value) {
     int bits;
 
     bits = 1;
@@ -39,14 +39,16 @@ int elias_gamma_bits(int value) {
     return bits;
 }
 
-int count_bits(int offset, int len) {
+/* Kept for the next file, as clearing the entries used is quicker than all of them */
+static THREAD_LOCAL size_t *matches = NULL;
+
+static int count_bits(int offset, int len) {
     return 1 + (offset > 128 ? 12 : 8) + elias_gamma_bits(len-1);
 }
 
-Optimal* optimize(unsigned char *input_data, size_t input_size, long skip) {
+Optimal* zx7_optimize(unsigned char *input_data, size_t input_size, long skip) {
     size_t *min;
     size_t *max;
-    size_t *matches;
     size_t *match_slots;
     Optimal *optimal;
     size_t *match;
@@ -60,7 +62,8 @@ Optimal* optimize(unsigned char *input_data, size_t input_size, long skip) {
     /* allocate all data structures at once */
     min = (size_t *)calloc(MAX_OFFSET+1, sizeof(size_t));
     max = (size_t *)calloc(MAX_OFFSET+1, sizeof(size_t));
-    matches = (size_t *)calloc(256*256, sizeof(size_t));
+    if (!matches)
+        matches = (size_t *)calloc(256*256, sizeof(size_t));
     match_slots = (size_t *)calloc(input_size, sizeof(size_t));
     optimal = (Optimal *)calloc(input_size, sizeof(Optimal));
 
@@ -118,8 +121,12 @@ Optimal* optimize(unsigned char *input_data, size_t input_size, long skip) {
         matches[match_index] = i;
     }
 
-    /* save time by releasing the largest block only, the O.S. will clean everything else later */
+    for (i = 1; i < input_size; i++) {
+        matches[input_data[i-1] << 8 | input_data[i]] = 0;
+    }
     free(match_slots);
+    free(min);
+    free(max);
 
     return optimal;
 }
@@ -30,6 +30,8 @@
 #include <limits.h>
 
 #include "zx7.h"
+#include "../zx0/batch.h"
+#include "../zx0/pack.h"
 
 long parse_long(char *str) {
     long value;
@@ -39,27 +41,41 @@ long parse_long(char *str) {
     return !errno ? value : LONG_MIN;
 }
 
-void reverse(unsigned char *first, unsigned char *last) {
-    unsigned char c;
+/* Compress a file from a manifest, with its own flags */
+int batch_compress(BATCH_ENTRY *entry, unsigned char *input_data, long input_size, unsigned char **output_data, long *output_size, long *delta) {
+    long skip = 0;
+    int backwards_mode = 0;
+    int i;
 
-    while (first < last) {
-        c = *first;
-        *first++ = *last;
-        *last-- = c;
+    for (i = 0; i < entry->flag_count; i++) {
+        if (!strcmp(entry->flags[i], "-b")) {
+            backwards_mode = 1;
+        } else if (*entry->flags[i] != '+' || (skip = parse_long(entry->flags[i])) <= 0) {
+            fprintf(stderr, "Error: Invalid parameter %s for %s\n", entry->flags[i], entry->input);
+            return 0;
+        }
+    }
+    if (skip >= input_size) {
+        fprintf(stderr, "Error: Skipping entire input file %s\n", entry->input);
+        return 0;
     }
+
+    *output_data = zx7_pack(input_data, input_size, skip, backwards_mode, output_size, delta);
+    return 1;
 }
 
 int main(int argc, char *argv[]) {
     long skip = 0;
     int forced_mode = 0;
     int backwards_mode = 0;
+    int threads = 0;
     char *output_name;
     unsigned char *input_data;
     unsigned char *output_data;
     FILE *ifp;
     FILE *ofp;
     size_t input_size;
-    size_t output_size;
+    long output_size;
     size_t partial_counter;
     size_t total_counter;
     long delta;
@@ -73,12 +89,22 @@ int main(int argc, char *argv[]) {
             forced_mode = 1;
         } else if (!strcmp(argv[i], "-b")) {
             backwards_mode = 1;
+        } else if (!strncmp(argv[i], "-j", 2)) {
+            if ((threads = parse_long(argv[i]+2)) <= 0) {
+                fprintf(stderr, "Error: Invalid parameter %s\n", argv[i]);
+                exit(1);
+            }
         } else if ((skip = parse_long(argv[i])) <= 0) {
             fprintf(stderr, "Error: Invalid parameter %s\n", argv[i]);
             exit(1);
         }
     }
 
+    /* compress the files in a manifest */
+    if (i < argc && *argv[i] == '@' && argc <= i+2) {
+        return batch("zx7", argv[i]+1, argc == i+2 ? argv[i+1] : NULL, threads, batch_compress) ? 0 : 1;
+    }
+
     /* determine output filename */
     if (argc == i+1) {
         output_name = (char *)malloc(strlen(argv[i])+5);
@@ -88,8 +114,11 @@ int main(int argc, char *argv[]) {
         output_name = argv[i+1];
     } else {
         fprintf(stderr, "Usage: %s [-f] [-b] input [output.zx7]\n"
+                        "       %s [-j<n>] @manifest [summary.json]\n"
                         "  -f      Force overwrite of output file\n"
-                        "  -b      Compress backwards\n", argv[0]);
+                        "  -b      Compress backwards\n"
+                        "  -j<n>   Compress n files at a time (default: one per processor)\n"
+                        "  @manifest  Compress the files listed as: input output [-b] [+skip]\n", argv[0], argv[0]);
 
         exit(1);
     }
@@ -151,18 +180,8 @@ int main(int argc, char *argv[]) {
         exit(1);
     }
 
-    /* conditionally reverse input file */
-    if (backwards_mode) {
-        reverse(input_data, input_data+input_size-1);
-    }
-
     /* generate output file */
-    output_data = compress(optimize(input_data, input_size, skip), input_data, input_size, skip, &output_size, &delta);
-
-    /* conditionally reverse output file */
-    if (backwards_mode) {
-        reverse(output_data, output_data+output_size-1);
-    }
+    output_data = zx7_pack(input_data, input_size, skip, backwards_mode, &output_size, &delta);
 
     /* write output file */
     if (fwrite(output_data, sizeof(char), output_size, ofp) != output_size) {
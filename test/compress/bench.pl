@@ -0,0 +1,266 @@
+#!/usr/bin/perl
+
+# Benchmark of the Z80 decompressors in libsrc/_DEVELOPMENT/compress
+#
+# Each file of the corpus is compressed with the host compressors, then
+# decompressed by each Z80 routine under z88dk-ticks. The decompressed data
+# is checked against the original and a table of compression ratio, speed
+# and decompressor size is printed.
+#
+# usage: bench.pl [-k] [corpus.lst]
+#   -k      keep the work directory
+#
+# The tools are taken from the PATH and can be overridden in the environment:
+#   Z80ASM, TICKS               assembler and emulator
+#   ZX0, ZX1, ZX2, ZX7, APLIB   compressors, called as "<command> input output"
+#
+# zx1, zx2 and aplib compressors are not part of z88dk; the decompressors of
+# a format whose compressor cannot be run are skipped.
+
+use strict;
+use warnings;
+use File::Basename;
+use File::Path qw( make_path remove_tree );
+use File::Spec;
+
+my $MAX_INPUT   = 0x6000;               # longer files are truncated
+my $DEST        = 0x8000;               # where the data is decompressed
+my $WORK_DIR    = "work";
+
+my $Z80ASM      = $ENV{Z80ASM} // "z88dk-z80asm";
+my $TICKS       = $ENV{TICKS} // "z88dk-ticks";
+
+my %COMPRESSOR = (
+    aplib   => $ENV{APLIB} // "apultra",
+    zx0     => $ENV{ZX0} // "z88dk-zx0 -f",
+    zx1     => $ENV{ZX1} // "zx1 -f",
+    zx2     => $ENV{ZX2} // "zx2 -f",
+    zx7     => $ENV{ZX7} // "z88dk-zx7 -f",
+);
+
+# name, format, entry point, sources relative to libsrc/_DEVELOPMENT/compress
+my @DECOMPRESSORS = (
+    [ "aplib",          "aplib", "asm_aplib_depack",
+        qw( aplib/z80/asm_aplib_depack.asm aplib/z80/__aplib_getbit.asm
+            aplib/z80/__aplib_getbitbc.asm aplib/z80/__aplib_getgamma.asm
+            aplib/z80/__aplib_var.asm ) ],
+    [ "zx0_standard",   "zx0",   "asm_dzx0_standard",   "zx0/z80/asm_dzx0_standard.asm" ],
+    [ "zx0_fast",       "zx0",   "asm_dzx0_fast",       "zx0/z80/asm_dzx0_fast.asm" ],
+    [ "zx0_turbo",      "zx0",   "asm_dzx0_turbo",      "zx0/z80/asm_dzx0_turbo.asm" ],
+    [ "zx0_mega",       "zx0",   "asm_dzx0_mega",       "zx0/z80/asm_dzx0_mega.asm" ],
+    [ "zx1_standard",   "zx1",   "asm_dzx1_standard",   "zx1/z80/asm_dzx1_standard.asm" ],
+    [ "zx1_turbo",      "zx1",   "asm_dzx1_turbo",      "zx1/z80/asm_dzx1_turbo.asm" ],
+    [ "zx1_mega",       "zx1",   "asm_dzx1_mega",       "zx1/z80/asm_dzx1_mega.asm" ],
+    [ "zx2_nano",       "zx2",   "asm_dzx2_nano",       "zx2/z80/asm_dzx2_nano.asm" ],
+    [ "zx7_standard",   "zx7",   "asm_dzx7_standard",   "zx7/z80/asm_dzx7_standard.asm", "../l/z80/l_ret.asm" ],
+    [ "zx7_turbo",      "zx7",   "asm_dzx7_turbo",      "zx7/z80/asm_dzx7_turbo.asm", "../l/z80/l_ret.asm" ],
+    [ "zx7_mega",       "zx7",   "asm_dzx7_mega",       "zx7/z80/asm_dzx7_mega.asm", "../l/z80/l_ret.asm" ],
+);
+
+my $keep = @ARGV && $ARGV[0] eq '-k' ? shift(@ARGV) : 0;
+my $corpus_list = shift(@ARGV) // dirname($0)."/corpus.lst";
+@ARGV and die "usage: $0 [-k] [corpus.lst]\n";
+
+my $here = File::Spec->rel2abs(dirname($0));
+my $compress_dir = File::Spec->catdir($here, "..", "..", "libsrc", "_DEVELOPMENT", "compress");
+
+my @corpus = read_corpus($corpus_list);
+
+remove_tree($WORK_DIR);
+make_path($WORK_DIR);
+chdir($WORK_DIR) or die "$WORK_DIR: $!\n";
+write_file("$_.in", $corpus[$_]{data}) for 0 .. $#corpus;
+
+# compress the corpus in each format
+my %packed;                             # format => [ packed file per corpus entry ]
+my @skipped;
+for my $format (sort keys %COMPRESSOR) {
+    my @files;
+    for my $i (0 .. $#corpus) {
+        my $out = "$i.$format";
+        unlink $out;
+        if (system("$COMPRESSOR{$format} $i.in $out >compress.log 2>&1") != 0 || ! -s $out) {
+            push @skipped, "$format: cannot run \"$COMPRESSOR{$format}\"";
+            @files = ();
+            last;
+        }
+        push @files, $out;
+    }
+    $packed{$format} = \@files if @files;
+}
+
+# decompress each file with each routine
+my $failed = 0;
+my @results;
+for my $decompressor (@DECOMPRESSORS) {
+    my($name, $format, $entry, @sources) = @$decompressor;
+    next unless $packed{$format};
+
+    for my $i (0 .. $#corpus) {
+        my $result = run_decompressor($name, $entry, \@sources, $i, $packed{$format}[$i]);
+        $failed++ unless $result->{ok};
+        push @results, $result;
+    }
+}
+
+chdir("..");
+remove_tree($WORK_DIR) unless $keep;
+
+print_table(\@corpus, \@results);
+print "\n" if @skipped;
+print "skipped $_\n" for @skipped;
+die "\n$failed decompression(s) failed\n" if $failed;
+exit 0;
+
+
+# read the corpus list, each file truncated to MAX_INPUT
+sub read_corpus {
+    my($list) = @_;
+    my $dir = dirname($list);
+    my @corpus;
+
+    open(my $fh, "<", $list) or die "$list: $!\n";
+    while (<$fh>) {
+        s/#.*//;
+        my($class, $file) = split ' ';
+        next unless defined $file;
+        $file = File::Spec->rel2abs($file, $dir);
+
+        open(my $in, "<:raw", $file) or die "$file: $!\n";
+        local $/;
+        my $data = <$in>;
+        close($in);
+        $data = substr($data, 0, $MAX_INPUT) if length($data) > $MAX_INPUT;
+        length($data) or die "$file: empty file\n";
+
+        push @corpus, { class => $class, name => basename($file), data => $data };
+    }
+    close($fh);
+
+    @corpus or die "$list: no files\n";
+    return @corpus;
+}
+
+sub write_file {
+    my($file, @text) = @_;
+    open(my $fh, ">:raw", $file) or die "$file: $!\n";
+    print $fh @text;
+    close($fh);
+}
+
+sub read_file {
+    my($file) = @_;
+    open(my $fh, "<:raw", $file) or die "$file: $!\n";
+    local $/;
+    my $data = <$fh>;
+    close($fh);
+    return $data;
+}
+
+sub run_decompressor {
+    my($name, $entry, $sources, $i, $packed) = @_;
+    my $input = $corpus[$i]{data};
+    my %result = (name => $name, index => $i, input => length($input), packed => -s $packed, ok => 0);
+
+    # driver: decompress and stop, the cycles are counted around the call
+    write_file("bench.asm", <<END);
+SECTION code
+
+EXTERN $entry
+
+        ld      sp, 0
+        ld      hl, packed
+        ld      de, $DEST
+bench_start:
+        call    $entry
+bench_end:
+        jr      bench_end
+
+SECTION data_packed
+
+packed:
+        BINARY  "$packed"
+END
+
+    my %dirs = map { dirname($_) => 1 } @$sources;
+    my $include = join(" ", "-I.", "-I$here", map { "-I$compress_dir/$_" } sort keys %dirs);
+    my $files = join(" ", map { "$compress_dir/$_" } @$sources);
+    if (system("$Z80ASM -b -m -O. $include bench.asm $files >asm.log 2>&1") != 0) {
+        print STDERR "$name: assembly failed\n", read_file("asm.log");
+        return \%result;
+    }
+
+    my %map = read_map("bench.map");
+    if ($map{__tail} > $DEST) {
+        print STDERR "$name: $corpus[$i]{name} does not fit in memory\n";
+        return \%result;
+    }
+
+    # everything linked after the data is the decompressor and its stubs
+    $result{code} = 0;
+    for (keys %map) {
+        next unless /^__(\w+)_size$/;
+        next if $1 eq 'code' || $1 eq 'data_packed' || $1 =~ /^bss_/;
+        $result{code} += $map{$_};
+    }
+
+    my $cmd = sprintf("%s -start %04X -end %04X -output dump.bin bench.bin", $TICKS, $map{bench_start}, $map{bench_end});
+    my $out = `$cmd`;
+    if ($out !~ /^(\d+)\s*$/) {
+        print STDERR "$name: $cmd: unexpected output $out\n";
+        return \%result;
+    }
+    $result{cycles} = $1;
+
+    my $output = substr(read_file("dump.bin"), $DEST, length($input));
+    if ($output ne $input) {
+        print STDERR "$name: $corpus[$i]{name} decompressed incorrectly\n";
+        return \%result;
+    }
+
+    $result{ok} = 1;
+    return \%result;
+}
+
+sub read_map {
+    my($file) = @_;
+    my %map;
+    open(my $fh, "<", $file) or die "$file: $!\n";
+    while (<$fh>) {
+        $map{$1} = hex($2) if /^(\w+)\s*=\s*\$([0-9A-F]+)/i;
+    }
+    close($fh);
+    return %map;
+}
+
+sub print_table {
+    my($corpus, $results) = @_;
+    my $width = 4;
+    for (@$corpus) { $width = length($_->{name}) if length($_->{name}) > $width; }
+    my $format = "%-9s %-${width}s %6s  %-13s %6s %6s %9s %11s %5s\n";
+    my %total;
+
+    printf $format, qw( class file size decompressor packed ratio cycles bytes/cycle code );
+    for my $r (@$results) {
+        my $c = $corpus->[$r->{index}];
+        printf $format, $c->{class}, $c->{name}, $r->{input}, $r->{name}, $r->{packed},
+            sprintf("%.1f%%", 100 * $r->{packed} / $r->{input}),
+            $r->{ok} ? ($r->{cycles}, sprintf("%.4f", $r->{input} / $r->{cycles}), $r->{code}) : ("FAILED", "", "");
+
+        my $t = $total{$r->{name}} //= { input => 0, packed => 0, cycles => 0, ok => 1 };
+        $t->{input} += $r->{input};
+        $t->{packed} += $r->{packed};
+        $t->{cycles} += $r->{cycles} // 0;
+        $t->{code} = $r->{code} if $r->{ok};
+        $t->{ok} &&= $r->{ok};
+    }
+
+    print "\nTotal\n";
+    printf $format, "", "", qw( size decompressor packed ratio cycles bytes/cycle code );
+    for my $d (@DECOMPRESSORS) {
+        my $t = $total{$d->[0]} or next;
+        printf $format, "", "", $t->{input}, $d->[0], $t->{packed},
+            sprintf("%.1f%%", 100 * $t->{packed} / $t->{input}),
+            $t->{ok} ? ($t->{cycles}, sprintf("%.4f", $t->{input} / $t->{cycles}), $t->{code}) : ("FAILED", "", "");
+    }
+}
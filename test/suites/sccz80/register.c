@@ -0,0 +1,111 @@
+#include "test.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+static int values[5] = { 3, 9, 4, 9, 7 };
+static char buf[10];
+
+static int add_sub(int a, int b)
+{
+        register int x = a;
+        register int y = b;
+
+        x += y;
+        y = x - y;
+        return x * 10 + y;
+}
+
+static int sum(int *p, int n)
+{
+        register int i;
+        register int *q = p;
+        int s = 0;
+
+        for (i = 0; i < n; i++) {
+                s += *q++;
+        }
+        return s;
+}
+
+static int find(int *p, int n, int v)
+{
+        register int i;
+        register int *q = p;
+
+        if (n == 0) return -1;
+        for (i = 0; i < n; i++) {
+                if (*q == v) {
+                        int k = i;
+                        return k;
+                }
+                q++;
+        }
+        return -2;
+}
+
+static int twice(int a)
+{
+        return a * 2;
+}
+
+static int calls(int n)
+{
+        register int i, t = 0;
+
+        for (i = 0; i < n; i++) t += twice(i);
+        return t;
+}
+
+static int copy(void)
+{
+        register char *d = buf;
+        register char *s = "hello";
+
+        while (*s) *d++ = *s++;
+        *d = 0;
+        return d - buf;
+}
+
+void test_register_pair()
+{
+        assertEqual(add_sub(3, 4), 73);
+        assertEqual(add_sub(-5, 2), -35);
+}
+
+void test_register_loop()
+{
+        assertEqual(sum(values, 5), 32);
+        assertEqual(calls(5), 20);
+        assertEqual(copy(), 5);
+        assertEqual(buf[4], 'o');
+}
+
+void test_register_return()
+{
+        assertEqual(find(values, 5, 4), 2);
+        assertEqual(find(values, 5, 8), -2);
+        assertEqual(find(values, 0, 3), -1);
+        /* Locals are still addressed correctly after the early returns */
+        assertEqual(find(values, 5, 7), 4);
+}
+
+int suite_register()
+{
+    suite_setup("Register Variable Tests");
+
+    suite_add_test(test_register_pair);
+    suite_add_test(test_register_loop);
+    suite_add_test(test_register_return);
+
+    return suite_run();
+}
+
+
+int main(int argc, char *argv[])
+{
+    int  res = 0;
+
+    res += suite_register();
+
+    exit(res);
+}
@@ -0,0 +1,43 @@
+#include <string.h>
+
+struct pair {
+    int   x;
+    int   y;
+};
+
+struct pair p1, p2;
+
+void memset1(char *ptr)
+{
+    memset(ptr,0,13);
+}
+
+void memset2(char *ptr, int c)
+{
+    memset(ptr,c,13);
+}
+
+void memset3(char *ptr)
+{
+    memset(ptr,0,300);
+}
+
+void memcpy1(char *ptr)
+{
+    memcpy(ptr,1000,10);
+}
+
+void memcpy2(char *dst, char *src)
+{
+    memcpy(dst,src,20);
+}
+
+void struct1(struct pair *p)
+{
+    *p = p1;
+}
+
+void struct2(void)
+{
+    p2 = p1;
+}
@@ -0,0 +1,20 @@
+struct pt { int x; int y; };
+int glob;
+
+static inline int add(int a, int b) { return a + b; }
+static inline int sq(int a) { return a * a; }
+inline static unsigned char lo(unsigned int w) { return w & 0xff; }
+static inline int gety(struct pt *p) { return p->y; }
+static inline int getg(void) { return glob; }
+static inline int twice(int a) { return add(a, a); }
+
+int var(int x) { return add(x, 3); }
+int constant(void) { return add(2, 3) * 4; }
+int nested(void) { return twice(sq(3)); }
+int simple(int x) { return sq(x); }
+int complex(int x) { return sq(x + 1); }
+unsigned char narrow(unsigned int w) { return lo(w) + lo(0x1234); }
+int member(struct pt *q) { return gety(q); }
+int hidden(void) { int glob = 3; return getg() + glob; }
+int chained(int x) { return add(add(x, 1), 2); }
+int side_effect(int x) { return add(x++, 1); }
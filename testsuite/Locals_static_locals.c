@@ -0,0 +1,31 @@
+struct pt { int x, y; };
+extern int g(int);
+int sum(int *p, int n)
+{
+    int i, s = 0;
+    char c = 'a';
+    long l = 5;
+    struct pt q;
+    int arr[4] = { 1, 2, 3, 4 };
+    for (i = 0; i < n; i++) {
+        int t = p[i];
+        s += t;
+    }
+    {
+        int i = 3;
+        s += i + arr[1];
+    }
+    q.x = s;
+    return s + c + l + q.x;
+}
+int fact(int n) __reentrant
+{
+    int r = n;
+    if (n > 1) r *= fact(n - 1);
+    return r;
+}
+int rec(int n)
+{
+    if (n) return rec(n - 1);
+    return 0;
+}
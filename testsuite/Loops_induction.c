@@ -0,0 +1,66 @@
+int a[10];
+char b[20];
+struct pt { int x, y; } pts[4];
+extern int g(int);
+
+long sum(int *p, int n)
+{
+    int i;
+    long s = 0;
+    for (i = 0; i < n; i++)
+        s += p[i] + a[i] + b[i];
+    return s;
+}
+
+void copy(void)
+{
+    int i;
+    int loc[5];
+    for (i = 4; i >= 0; i--) {
+        loc[i] = a[i];
+        pts[i].x = loc[i];
+    }
+}
+
+void nested(char m[4][8])
+{
+    int i, j;
+    for (i = 0; i < 4; i++)
+        for (j = 0; j < 8; ++j)
+            m[i][j] = b[j];
+}
+
+void changed(int *p)
+{
+    int i;
+    for (i = 0; i < 10; i += 1) {
+        a[i] = p[i];
+        p++;
+    }
+}
+
+void calls(void)
+{
+    int i;
+    for (i = 0; i < 10; i++)
+        a[i] = g(i);
+}
+
+void modified(void)
+{
+    int i;
+    for (i = 0; i < 10; i++) {
+        a[i] = 1;
+        i++;
+    }
+}
+
+void local(void)
+{
+    int i;
+    for (i = 0; i < 4; i++) {
+        int tmp[4];
+        tmp[i] = a[i];
+        b[i] = tmp[i];
+    }
+}
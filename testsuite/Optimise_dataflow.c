@@ -0,0 +1,70 @@
+extern int g(int);
+extern int h(void);
+extern int cg(int) __z88dk_callee;
+int var;
+
+int reload(int x)
+{
+    int y;
+    y = x + 1;
+    return g(y) + y;
+}
+
+int constants(int a, int b)
+{
+    a = 0;
+    b = 0;
+    return a * b + a;
+}
+
+void postinc(int *p)
+{
+    *p++ = var;
+    var = *p;
+}
+
+void tail(void)
+{
+    h();
+}
+
+int tail_callee(int x)
+{
+    return cg(x);
+}
+
+int tail_args(int x)
+{
+    return g(x);
+}
+
+int with_asm(int x)
+{
+    x = 0;
+#asm
+    nop
+#endasm
+    return x;
+}
+
+int long_const(long a, int b)
+{
+    int r;
+
+    r = a + b - 69000;
+    return r + b;
+}
+
+int registers(int a, int b)
+{
+    register int i;
+    int x, y;
+
+    x = a;
+    y = b;
+    for ( i = 0; i < a; i++ ) {
+        x += y;
+        y = x - b;
+    }
+    return x + y;
+}
@@ -0,0 +1,59 @@
+extern int g(int);
+int var;
+
+int stores(int a, int b)
+{
+    int x, y;
+    char c;
+    unsigned char u;
+    x = a;
+    y = b;
+    x += y;
+    y = x - b;
+    c = x;
+    u = y;
+    x = c + u;
+    return x + y + a;
+}
+
+int counter(int n)
+{
+    int i, total;
+    total = 0;
+    for ( i = 0; i < n; i++ ) {
+        total += i;
+        var = total;
+    }
+    return total;
+}
+
+int few(int a)
+{
+    int x;
+    x = a;
+    return x;
+}
+
+int calls(int a)
+{
+    int x, y;
+    x = a;
+    y = x + 1;
+    x += y;
+    y = g(x);
+    return x + y;
+}
+
+int registers(int a, int b)
+{
+    register int i;
+    int x, y;
+
+    x = a;
+    y = b;
+    for ( i = 0; i < a; i++ ) {
+        x += y;
+        y = x - b;
+    }
+    return x + y;
+}
@@ -0,0 +1,41 @@
+
+struct block {
+    char    b[8];
+};
+
+struct block src, dst;
+int neg;
+
+int check(int v)
+{
+    int r;
+    if ( v >= 0 ) {
+        r = v + v;
+    } else {
+        neg = neg + 1;
+        r = 0;
+    }
+    return r + 1;
+}
+
+void copy(void)
+{
+    dst = src;
+}
+
+long unused(long a)
+{
+    return a << 3;
+}
+
+int main()
+{
+    int i, total;
+
+    total = 0;
+    for ( i = 0; i < 64; i++ ) {
+        copy();
+        total += check(i);
+    }
+    return total;
+}
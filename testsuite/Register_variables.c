@@ -0,0 +1,36 @@
+int sum(int *p, int n)
+{
+    register int i;
+    register int *q = p;
+    int s = 0;
+    for (i = 0; i < n; i++) {
+        s += *q++;
+    }
+    return s;
+}
+void clear(char *p, int n)
+{
+    register char *d = p;
+    while (n--) *d++ = 0;
+}
+extern int f(int);
+int calls(int n)
+{
+    register int i, t = 0;
+    for (i = 0; i < n; i++) t += f(i);
+    return t;
+}
+int find(int *p, int n, int v)
+{
+    register int i;
+    register int *q = p;
+    if (n == 0) return -1;
+    for (i = 0; i < n; i++) {
+        if (*q == v) {
+            int k = i;
+            return k;
+        }
+        q++;
+    }
+    return -2;
+}
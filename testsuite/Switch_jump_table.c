@@ -0,0 +1,43 @@
+
+
+int dense_int(int x)
+{
+    switch (x) {
+    case 10: return 1;
+    case 11: return 2;
+    case 12: return 3;
+    case 13: return 4;
+    case 15: return 5;
+    case 16: return 6;
+    case 17: return 7;
+    case 18: return 8;
+    case 19: return 9;
+    case 20: return 10;
+    }
+    return 0;
+}
+
+int dense_char(signed char c)
+{
+    switch (c) {
+    case -3: return 1;
+    case -2: return 2;
+    case -1: return 3;
+    case 0: return 4;
+    case 1: return 5;
+    case 2: return 6;
+    case 3: return 7;
+    default: return 8;
+    }
+}
+
+int sparse_int(int x)
+{
+    switch (x) {
+    case 1: return 1;
+    case 100: return 2;
+    case 1000: return 3;
+    case 10000: return 4;
+    }
+    return 0;
+}